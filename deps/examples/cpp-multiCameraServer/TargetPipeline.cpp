@@ -0,0 +1,151 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "TargetPipeline.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <wpi/json.h>
+
+#include "frcvision/Overlay.h"
+#include "frcvision/Profiler.h"
+
+namespace {
+
+template <typename... Args>
+void ConfigError(const frcvision::PipelineSettings& settings,
+                 fmt::format_string<Args...> format, Args&&... args) {
+  fmt::print(stderr, "config error: pipeline '{}': {}\n", settings.name,
+             fmt::format(format, std::forward<Args>(args)...));
+}
+
+}  // namespace
+
+TargetPipeline::TargetPipeline(const frcvision::PipelineSettings& settings,
+                               nt::NetworkTableInstance inst,
+                               frcvision::WorkPool& pool)
+    : m_threshold{ReadBits(settings)},
+      m_tiles{pool, ReadTileSettings(settings)},
+      m_targetsPub{inst, fmt::format("/vision/{}/targets", settings.name)} {
+  std::vector<double> low{50, 100, 100};
+  std::vector<double> high{90, 255, 255};
+  try {
+    if (settings.config.value("space", "hsv") == "ycrcb")
+      m_space = frcvision::ColorThreshold::kYCrCb;
+    low = settings.config.value("low", low);
+    high = settings.config.value("high", high);
+    m_roi = settings.config.value("roi", false);
+    frcvision::RoiSettings roi;
+    roi.maxMisses = settings.config.value("roi misses", roi.maxMisses);
+    m_tracker = frcvision::RoiTracker{roi};
+  } catch (const wpi::json::exception& e) {
+    ConfigError(settings, "{}", e.what());
+  }
+  if (m_roi) m_tracker.Publish(inst, settings.name);
+  auto prefix = fmt::format("/vision/{}/", settings.name);
+  m_lowEntry = inst.GetDoubleArrayTopic(prefix + "low").GetEntry(low);
+  m_lowEntry.Set(low);
+  m_highEntry = inst.GetDoubleArrayTopic(prefix + "high").GetEntry(high);
+  m_highEntry.Set(high);
+
+  auto& profiler = frcvision::Profiler::GetInstance();
+  m_thresholdProbe = profiler.GetProbe(settings.name, "threshold");
+  m_morphologyProbe = profiler.GetProbe(settings.name, "morphology");
+  m_blobsProbe = profiler.GetProbe(settings.name, "blobs");
+}
+
+void TargetPipeline::Process(cv::Mat& image,
+                             const frcvision::FrameTime& time) {
+  if (image.type() != CV_8UC3) return;  // needs "gray": false
+
+  // only rebuilds the table when the bounds actually changed
+  auto low = m_lowEntry.Get();
+  auto high = m_highEntry.Get();
+  if (low.size() == 3 && high.size() == 3 &&
+      m_threshold.SetBounds(m_space, {low[0], low[1], low[2]},
+                            {high[0], high[1], high[2]})) {
+    m_tracker.Reset();  // the old target may not match any more
+  }
+
+  // with "roi", only the window around the predicted target position
+  m_window = m_roi ? m_tracker.Begin(image.size(), time.local)
+                   : cv::Rect{{0, 0}, image.size()};
+  {
+    frcvision::ProfileScope scope{m_thresholdProbe};
+    // a YUYV camera's own frame at full size, without the conversion; the
+    // window then has to keep pixel pairs (which share U and V) together
+    cv::Mat yuyv = GetPyramid().GetYUYV();
+    bool raw = yuyv.size() == image.size();
+    if (raw) {
+      m_window.width += m_window.x % 2;
+      m_window.x -= m_window.x % 2;
+      m_window.width += m_window.width % 2;
+    }
+    m_tiles.Threshold(m_threshold, (raw ? yuyv : image)(m_window), m_mask);
+  }
+  {
+    frcvision::ProfileScope scope{m_morphologyProbe};
+    m_tiles.Erode(m_mask, m_mask, {3, 3});
+    m_tiles.Dilate(m_mask, m_mask, {3, 3});
+  }
+  {
+    frcvision::ProfileScope scope{m_blobsProbe};
+    frcvision::FindBlobs(m_mask, m_blobs);
+    for (auto&& blob : m_blobs) {
+      blob.box += m_window.tl();
+      blob.centroid += cv::Point2d{m_window.tl()};
+    }
+    std::sort(m_blobs.begin(), m_blobs.end(),
+              [](const auto& a, const auto& b) { return a.area > b.area; });
+  }
+  m_target = m_blobs.empty() ? nullptr : &m_blobs.front();
+  if (m_roi) {
+    std::optional<cv::Rect2d> box;
+    if (m_target) box = cv::Rect2d{m_target->box};
+    m_tracker.End(box);
+  }
+  m_targets.clear();
+  for (auto&& blob : m_blobs) {
+    m_targets.push_back({blob.centroid.x, blob.centroid.y,
+                         static_cast<double>(blob.box.width),
+                         static_cast<double>(blob.box.height),
+                         static_cast<double>(blob.area)});
+  }
+  // sent from the publisher's own thread, never blocking this one
+  m_targetsPub.Publish(m_targets, time);
+}
+
+void TargetPipeline::Draw(cv::Mat& image) {
+  if (m_roi && m_window.size() != image.size())
+    frcvision::DrawBox(image, m_window, {255, 0, 0});
+  if (m_target) frcvision::DrawBox(image, m_target->box);
+}
+
+int TargetPipeline::ReadBits(const frcvision::PipelineSettings& settings) {
+  try {
+    int bits = settings.config.value("bits", 6);
+    if (bits >= 4 && bits <= 8) return bits;
+    ConfigError(settings, "bits must be 4 to 8");
+  } catch (const wpi::json::exception& e) {
+    ConfigError(settings, "could not read bits: {}", e.what());
+  }
+  return 6;
+}
+
+frcvision::TileSettings TargetPipeline::ReadTileSettings(
+    const frcvision::PipelineSettings& settings) {
+  frcvision::TileSettings tiles;
+  try {
+    tiles.minPixels = settings.config.value("tile pixels", tiles.minPixels);
+  } catch (const wpi::json::exception& e) {
+    ConfigError(settings, "could not read tile pixels: {}", e.what());
+  }
+  return tiles;
+}
@@ -0,0 +1,76 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef TARGETPIPELINE_H_
+#define TARGETPIPELINE_H_
+
+#include <vector>
+
+#include <networktables/DoubleArrayTopic.h>
+#include <networktables/NetworkTableInstance.h>
+#include <opencv2/core/core.hpp>
+
+#include "frcvision/BitMask.h"
+#include "frcvision/ColorThreshold.h"
+#include "frcvision/PipelineRuntime.h"
+#include "frcvision/ResultPublisher.h"
+#include "frcvision/RoiTracker.h"
+#include "frcvision/TiledStages.h"
+#include "frcvision/TimeSync.h"
+
+/*
+   Example target pipeline: color threshold through a lookup table, an
+   opening to remove noise, then the blobs.  Config (all optional):
+
+       "space": "hsv" or "ycrcb", "low": [c0, c1, c2], "high": [c0, c1, c2],
+       "bits": <lookup table bits per channel, 4 to 8>,
+       "roi": <true to only search around the last target>,
+       "roi misses": <frames without the target before searching it all>,
+       "tile pixels": <frame size (width * height) from which the threshold
+                       and opening are split over all cores, 0 for never>
+
+   The bounds can be tuned live through /vision/<name>/low and high.  All
+   blobs are published to /vision/<name>/targets, largest first, as one
+   struct array per frame.  Its stages are timed on the Vision Status page.
+
+   main.cpp runs it on cameras as the "target" type, and
+   multiCameraServerReplay (replay/main.cpp) on recorded frames.
+ */
+class TargetPipeline : public frcvision::CameraPipeline {
+ public:
+  TargetPipeline(const frcvision::PipelineSettings& settings,
+                 nt::NetworkTableInstance inst, frcvision::WorkPool& pool);
+
+  void Process(cv::Mat& image, const frcvision::FrameTime& time) override;
+  void Draw(cv::Mat& image) override;
+
+  // the last frame's blobs, largest first, as published
+  const std::vector<frcvision::Target>& GetTargets() const {
+    return m_targets;
+  }
+
+ private:
+  static int ReadBits(const frcvision::PipelineSettings& settings);
+  static frcvision::TileSettings ReadTileSettings(
+      const frcvision::PipelineSettings& settings);
+
+  frcvision::ColorThreshold m_threshold;
+  frcvision::TiledStages m_tiles;
+  frcvision::ColorThreshold::Space m_space = frcvision::ColorThreshold::kHSV;
+  bool m_roi = false;
+  frcvision::RoiTracker m_tracker;
+  cv::Rect m_window;
+  frcvision::BitMask m_mask;
+  std::vector<frcvision::Blob> m_blobs;
+  const frcvision::Blob* m_target = nullptr;
+  std::vector<frcvision::Target> m_targets;
+  nt::DoubleArrayEntry m_lowEntry;
+  nt::DoubleArrayEntry m_highEntry;
+  frcvision::ResultPublisher m_targetsPub;
+  int m_thresholdProbe;
+  int m_morphologyProbe;
+  int m_blobsProbe;
+};
+
+#endif  // TARGETPIPELINE_H_
@@ -0,0 +1,84 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <fmt/format.h>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/FramePool.h"
+
+namespace {
+
+// an empty kernel would make erode allocate a default one every call
+const cv::Mat kKernel = cv::Mat::ones(3, 3, CV_8U);
+
+// typical target pipeline: copy the frame out of the camera buffer, then
+// color threshold and clean up the mask; intermediates are fresh cv::Mats
+// every frame, as most examples write it
+int FreshFrame(const cv::Mat& camera) {
+  cv::Mat image, hsv, mask, eroded;
+  camera.copyTo(image);
+  cv::cvtColor(image, hsv, cv::COLOR_BGR2HSV);
+  cv::inRange(hsv, cv::Scalar{40, 80, 80}, cv::Scalar{90, 255, 255}, mask);
+  cv::erode(mask, eroded, kKernel);
+  return cv::countNonZero(eroded);
+}
+
+// the same with every intermediate taken from the pool
+int PooledFrame(const cv::Mat& camera) {
+  auto& pool = frcvision::FramePool::GetInstance();
+  auto image = pool.Acquire(camera.size(), CV_8UC3);
+  auto hsv = pool.Acquire(camera.size(), CV_8UC3);
+  auto mask = pool.Acquire(camera.size(), CV_8UC1);
+  auto eroded = pool.Acquire(camera.size(), CV_8UC1);
+  camera.copyTo(*image);
+  cv::cvtColor(*image, *hsv, cv::COLOR_BGR2HSV);
+  cv::inRange(*hsv, cv::Scalar{40, 80, 80}, cv::Scalar{90, 255, 255}, *mask);
+  cv::erode(*mask, *eroded, kKernel);
+  return cv::countNonZero(*eroded);
+}
+
+void AllocBench() {
+  frcvision::InstallMatAllocationCounter();
+  auto& pool = frcvision::FramePool::GetInstance();
+
+  for (auto size : {cv::Size{320, 240}, cv::Size{640, 480}}) {
+    cv::Mat camera = bench::TestImage(size.width, size.height);
+    bench::PrintHeader(
+        fmt::format("Frame buffers, {}x{}", size.width, size.height));
+
+    uint64_t start = frcvision::GetMatAllocations();
+    int expected = FreshFrame(camera);
+    uint64_t freshAllocs = frcvision::GetMatAllocations() - start;
+    auto fresh = bench::Measure([&] { FreshFrame(camera); });
+    bench::PrintRow("fresh cv::Mat per frame", fresh,
+                    fmt::format("{} allocs/frame", freshAllocs));
+
+    // the first frame fills the pool; after that nothing should allocate,
+    // including Measure's warmup
+    int result = PooledFrame(camera);
+    start = frcvision::GetMatAllocations();
+    uint64_t poolStart = pool.GetAllocations();
+    auto pooled = bench::Measure([&] { PooledFrame(camera); });
+    uint64_t allocs = frcvision::GetMatAllocations() - start;
+    bench::PrintRow(
+        "FramePool handles", pooled,
+        fmt::format("{} allocs total, {:.2f}x", allocs,
+                    fresh.medianUs / pooled.medianUs));
+
+    bench::PrintCheck("pooled result matches", result == expected,
+                      fmt::format("{} vs {} pixels", result, expected));
+    bench::PrintCheck(
+        "pooled steady state allocations",
+        allocs == 0 && pool.GetAllocations() == poolStart,
+        fmt::format("{} Mat allocations over {} frames", allocs,
+                    pooled.iterations));
+  }
+  pool.Clear();
+}
+
+}  // namespace
+
+BENCHMARK("alloc", "per-frame cv::Mat allocations, fresh vs FramePool",
+          AllocBench);
@@ -0,0 +1,158 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "Bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <fmt/format.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "BenchRegistry.h"
+
+namespace bench {
+
+Options& MutableOptions() {
+  static Options options;
+  return options;
+}
+
+const Options& GetOptions() { return MutableOptions(); }
+
+int& CheckFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+std::vector<Benchmark>& GetBenchmarks() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+int Register(std::string_view name, std::string_view description,
+             void (*func)()) {
+  GetBenchmarks().push_back(
+      {std::string{name}, std::string{description}, func});
+  return 0;
+}
+
+Stats Measure(const std::function<void()>& fn) {
+  using Clock = std::chrono::steady_clock;
+
+  // warm up caches and any lazily allocated buffers
+  for (int i = 0; i < 3; ++i) fn();
+
+  std::vector<double> times;
+  auto start = Clock::now();
+  auto end = start + std::chrono::duration<double>(GetOptions().seconds);
+  do {
+    auto t0 = Clock::now();
+    fn();
+    auto t1 = Clock::now();
+    times.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+  } while (Clock::now() < end || times.size() < 5);
+
+  Stats stats;
+  stats.iterations = times.size();
+  for (double t : times) stats.meanUs += t;
+  stats.meanUs /= times.size();
+  std::sort(times.begin(), times.end());
+  stats.medianUs = times[times.size() / 2];
+  stats.p90Us = times[times.size() * 9 / 10];
+  return stats;
+}
+
+void PrintHeader(std::string_view title) {
+  fmt::print("\n{}\n", title);
+  fmt::print("  {:<40} {:>10} {:>10} {:>8}\n", "", "median us", "p90 us",
+             "iters");
+}
+
+void PrintRow(std::string_view label, const Stats& stats,
+              std::string_view note) {
+  fmt::print("  {:<40} {:>10.1f} {:>10.1f} {:>8} {}\n", label, stats.medianUs,
+             stats.p90Us, stats.iterations, note);
+}
+
+void PrintCheck(std::string_view label, bool ok, std::string_view detail) {
+  fmt::print("  {:<40} {} {}\n", label, ok ? "OK" : "MISMATCH", detail);
+  if (!ok) ++CheckFailures();
+}
+
+cv::Mat TestImage(int width, int height) {
+  cv::Mat image;
+  if (!GetOptions().image.empty()) {
+    image = cv::imread(GetOptions().image, cv::IMREAD_COLOR);
+    if (!image.empty()) {
+      cv::resize(image, image, cv::Size{width, height}, 0, 0, cv::INTER_AREA);
+      return image;
+    }
+    fmt::print(stderr, "could not read '{}', using test scene\n",
+               GetOptions().image);
+  }
+
+  // gradient background with noise and a few saturated targets
+  image.create(height, width, CV_8UC3);
+  for (int y = 0; y < height; ++y) {
+    auto row = image.ptr<cv::Vec3b>(y);
+    for (int x = 0; x < width; ++x) {
+      row[x] = cv::Vec3b(x * 255 / width, y * 255 / height,
+                         (x + y) * 127 / (width + height));
+    }
+  }
+  cv::RNG rng{1234};
+  cv::Mat noise{height, width, CV_8UC3};
+  rng.fill(noise, cv::RNG::NORMAL, 0, 12);
+  cv::add(image, noise, image);
+  for (int i = 0; i < 12; ++i) {
+    cv::Point center{rng.uniform(0, width), rng.uniform(0, height)};
+    cv::Scalar color{static_cast<double>(rng.uniform(0, 256)),
+                     static_cast<double>(rng.uniform(0, 256)),
+                     static_cast<double>(rng.uniform(0, 256))};
+    int size = rng.uniform(width / 40 + 1, width / 8 + 2);
+    if (i % 2 == 0)
+      cv::rectangle(image, center, center + cv::Point{size, size / 2}, color,
+                    cv::FILLED);
+    else
+      cv::circle(image, center, size / 2, color, cv::FILLED);
+  }
+  // targets: bright green rectangles like retroreflective tape
+  for (int i = 0; i < 2; ++i) {
+    cv::Point tl{width / 4 + i * width / 3, height / 3};
+    cv::rectangle(image, tl, tl + cv::Point{width / 16, height / 5},
+                  cv::Scalar{80, 255, 80}, cv::FILLED);
+  }
+  return image;
+}
+
+cv::Mat ToYUYV(const cv::Mat& bgr) {
+  cv::Mat yuv;
+  cv::cvtColor(bgr, yuv, cv::COLOR_BGR2YUV);
+  cv::Mat yuyv{bgr.rows, bgr.cols, CV_8UC2};
+  for (int y = 0; y < bgr.rows; ++y) {
+    auto src = yuv.ptr<cv::Vec3b>(y);
+    auto dst = yuyv.ptr<uint8_t>(y);
+    for (int x = 0; x + 1 < bgr.cols; x += 2) {
+      dst[2 * x] = src[x][0];
+      dst[2 * x + 1] = (src[x][1] + src[x + 1][1]) / 2;
+      dst[2 * x + 2] = src[x + 1][0];
+      dst[2 * x + 3] = (src[x][2] + src[x + 1][2]) / 2;
+    }
+  }
+  return yuyv;
+}
+
+bool SameBits(const frcvision::BitMask& a, const frcvision::BitMask& b) {
+  if (a.Width() != b.Width() || a.Height() != b.Height()) return false;
+  for (int y = 0; y < a.Height(); ++y) {
+    if (!std::equal(a.Row(y), a.Row(y) + a.WordsPerRow(), b.Row(y)))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace bench
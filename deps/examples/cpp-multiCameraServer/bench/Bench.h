@@ -0,0 +1,66 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include <opencv2/core/core.hpp>
+
+#include "frcvision/BitMask.h"
+
+/*
+   Minimal benchmark harness for the frcvision building blocks.
+
+   Each benchmark file registers itself with a static BENCHMARK() and prints
+   its own table; correctness checks against the OpenCV reference are
+   reported in the same output.
+ */
+namespace bench {
+
+struct Options {
+  std::string image;     // optional input image instead of the test scene
+  double seconds = 0.5;  // minimum time per measurement
+};
+
+const Options& GetOptions();
+
+struct Stats {
+  double medianUs = 0;
+  double p90Us = 0;
+  double meanUs = 0;
+  int iterations = 0;
+};
+
+// runs fn repeatedly (after a warmup) for at least GetOptions().seconds
+Stats Measure(const std::function<void()>& fn);
+
+void PrintHeader(std::string_view title);
+void PrintRow(std::string_view label, const Stats& stats,
+              std::string_view note = {});
+// a failed check makes multiCameraServerBench exit with a failure
+void PrintCheck(std::string_view label, bool ok, std::string_view detail = {});
+
+// deterministic BGR scene (or the -i image resized) of the given size
+cv::Mat TestImage(int width, int height);
+
+// packs BGR into YUYV (4:2:2) the way a camera would deliver it
+cv::Mat ToYUYV(const cv::Mat& bgr);
+
+// same size and the same bits in every row
+bool SameBits(const frcvision::BitMask& a, const frcvision::BitMask& b);
+
+int Register(std::string_view name, std::string_view description,
+             void (*func)());
+
+}  // namespace bench
+
+#define BENCHMARK(name, description, func) \
+  static int bench_registered_##func =     \
+      ::bench::Register(name, description, func)
+
+#endif  // BENCH_BENCH_H_
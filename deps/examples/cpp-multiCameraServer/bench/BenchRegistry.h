@@ -0,0 +1,29 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef BENCH_BENCHREGISTRY_H_
+#define BENCH_BENCHREGISTRY_H_
+
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+
+namespace bench {
+
+struct Benchmark {
+  std::string name;
+  std::string description;
+  void (*func)();
+};
+
+std::vector<Benchmark>& GetBenchmarks();
+Options& MutableOptions();
+
+// PrintCheck calls that reported a mismatch so far
+int& CheckFailures();
+
+}  // namespace bench
+
+#endif  // BENCH_BENCHREGISTRY_H_
@@ -0,0 +1,103 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <fmt/format.h>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/ColorThreshold.h"
+
+namespace {
+
+// green retroreflective tape under a green ring light
+const cv::Scalar kLow{50, 100, 100};
+const cv::Scalar kHigh{90, 255, 255};
+
+// fraction of pixels where the masks disagree
+double Mismatch(const cv::Mat& a, const cv::Mat& b) {
+  if (a.size() != b.size()) return 1;
+  return static_cast<double>(cv::norm(a, b, cv::NORM_L1)) / 255 / a.total();
+}
+
+void ColorBench() {
+  for (auto size : {cv::Size{320, 240}, cv::Size{640, 480}}) {
+    cv::Mat bgr = bench::TestImage(size.width, size.height);
+    cv::Mat yuyv = bench::ToYUYV(bgr);
+    bench::PrintHeader(
+        fmt::format("Color threshold (HSV), {}x{}", size.width, size.height));
+
+    frcvision::ColorThreshold lut6{6};
+    frcvision::ColorThreshold lut8{8};
+    lut6.SetBounds(frcvision::ColorThreshold::kHSV, kLow, kHigh);
+    lut8.SetBounds(frcvision::ColorThreshold::kHSV, kLow, kHigh);
+    cv::Mat converted, hsv, ref, mask;
+    frcvision::BitMask bits;
+
+    for (bool camera : {false, true}) {
+      const cv::Mat& image = camera ? yuyv : bgr;
+      const char* format = camera ? "YUYV" : "BGR";
+      auto base = bench::Measure([&] {
+        if (camera) {
+          cv::cvtColor(yuyv, converted, cv::COLOR_YUV2BGR_YUYV);
+          cv::cvtColor(converted, hsv, cv::COLOR_BGR2HSV);
+        } else {
+          cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+        }
+        cv::inRange(hsv, kLow, kHigh, ref);
+      });
+      bench::PrintRow(fmt::format("{} cvtColor + inRange", format), base);
+
+      for (auto lut : {&lut6, &lut8}) {
+        int lutBits = lut == &lut6 ? 6 : 8;
+        auto fast = bench::Measure([&] { lut->Apply(image, mask); });
+        bench::PrintRow(
+            fmt::format("{} {}-bit table", format, lutBits), fast,
+            fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+        double mismatch = Mismatch(ref, mask);
+        bench::PrintCheck(
+            fmt::format("{} {}-bit table vs inRange", format, lutBits),
+            lutBits == 8 ? mismatch == 0 : mismatch < 0.01,
+            fmt::format("{:.3f}% of pixels differ", mismatch * 100));
+      }
+
+      // straight into a bit mask for the morphology and blob kernels
+      auto fast = bench::Measure([&] { lut6.Apply(image, bits); });
+      bench::PrintRow(fmt::format("{} 6-bit table to BitMask", format), fast,
+                      fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+      cv::Mat unpacked, lutMask;
+      frcvision::UnpackMask(bits, unpacked);
+      lut6.Apply(image, lutMask);
+      bench::PrintCheck(fmt::format("{} BitMask vs mask", format),
+                        Mismatch(lutMask, unpacked) == 0);
+    }
+
+    // what a bounds change over NT costs, once
+    int i = 0;
+    auto rebuild = bench::Measure([&] {
+      lut6.SetBounds(frcvision::ColorThreshold::kHSV, kLow,
+                     cv::Scalar{90.0 - (++i % 2), 255, 255});
+      lut6.Apply(bgr, mask);
+    });
+    bench::PrintRow("6-bit BGR table rebuild + apply", rebuild);
+    // the loop may have left either bound, so start from one that isn't
+    // kHigh: one change, then the same bounds again
+    lut6.SetBounds(frcvision::ColorThreshold::kHSV, kLow, {88, 255, 255});
+    lut6.Apply(bgr, mask);
+    int builds = lut6.GetBuildCount();
+    bool changed =
+        lut6.SetBounds(frcvision::ColorThreshold::kHSV, kLow, kHigh);
+    lut6.Apply(bgr, mask);
+    bool unchanged =
+        !lut6.SetBounds(frcvision::ColorThreshold::kHSV, kLow, kHigh);
+    lut6.Apply(bgr, mask);
+    bench::PrintCheck("unchanged bounds don't rebuild",
+                      changed && unchanged &&
+                          lut6.GetBuildCount() == builds + 1);
+  }
+}
+
+}  // namespace
+
+BENCHMARK("color", "color lookup table threshold vs cvtColor + inRange",
+          ColorBench);
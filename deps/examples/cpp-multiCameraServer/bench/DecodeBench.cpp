@@ -0,0 +1,73 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <vector>
+
+#include <fmt/format.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/ScaledSink.h"
+
+namespace {
+
+void BenchSource(int srcWidth, int srcHeight, int width, int height) {
+  std::vector<uint8_t> jpeg;
+  cv::imencode(".jpg", bench::TestImage(srcWidth, srcHeight), jpeg,
+               {cv::IMWRITE_JPEG_QUALITY, 85});
+
+  bench::PrintHeader(fmt::format("JPEG decode, {}x{} source ({} KiB)",
+                                 srcWidth, srcHeight, jpeg.size() / 1024));
+  cv::Mat out;
+  for (bool gray : {false, true}) {
+    for (int scale : {1, 2, 4, 8}) {
+      auto stats = bench::Measure(
+          [&] { frcvision::DecodeJpeg(jpeg, scale, gray, out); });
+      bench::PrintRow(fmt::format("1/{} {} -> {}x{}", scale,
+                                  gray ? "gray" : "color", out.cols, out.rows),
+                      stats);
+    }
+  }
+
+  // what a pipeline needing width x height pays with and without scaling
+  cv::Mat full;
+  auto baseline = bench::Measure([&] {
+    frcvision::DecodeJpeg(jpeg, 1, false, full);
+    cv::resize(full, out, cv::Size{width, height}, 0, 0, cv::INTER_AREA);
+  });
+  bench::PrintRow(fmt::format("full decode + resize to {}x{}", width, height),
+                  baseline);
+
+  int scale = frcvision::ChooseJpegScale(srcWidth, srcHeight, width, height);
+  cv::Mat scaled;
+  auto fast = bench::Measure([&] {
+    frcvision::DecodeJpeg(jpeg, scale, false, scaled);
+    if (scaled.cols != width || scaled.rows != height)
+      cv::resize(scaled, out, cv::Size{width, height}, 0, 0, cv::INTER_AREA);
+  });
+  bench::PrintRow(fmt::format("1/{} decode to {}x{}", scale, width, height),
+                  fast,
+                  fmt::format("{:.1f}x faster", baseline.medianUs /
+                                                    fast.medianUs));
+
+  for (int s : {2, 4, 8}) {
+    frcvision::DecodeJpeg(jpeg, s, false, out);
+    bench::PrintCheck(
+        fmt::format("1/{} output size", s),
+        out.cols == (srcWidth + s - 1) / s &&
+            out.rows == (srcHeight + s - 1) / s,
+        fmt::format("{}x{}", out.cols, out.rows));
+  }
+}
+
+void DecodeBench() {
+  BenchSource(640, 480, 160, 120);
+  BenchSource(1280, 720, 320, 180);
+}
+
+}  // namespace
+
+BENCHMARK("decode", "scaled IDCT JPEG decode vs decode + resize",
+          DecodeBench);
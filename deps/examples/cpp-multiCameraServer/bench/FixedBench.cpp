@@ -0,0 +1,77 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <functional>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "Bench.h"
+#include "frcvision/BitMask.h"
+#include "frcvision/ColorThreshold.h"
+#include "frcvision/FixedKernels.h"
+
+namespace {
+
+// times fn with the generic kernels, then with the ones compiled for the
+// size, and checks that both produce out
+void Compare(std::string_view label, const std::function<void()>& fn,
+             const frcvision::BitMask& out) {
+  frcvision::SetFixedKernelsEnabled(false);
+  auto base = bench::Measure(fn);
+  frcvision::BitMask generic = out;
+  bench::PrintRow(fmt::format("{}, generic", label), base);
+  frcvision::SetFixedKernelsEnabled(true);
+  auto fast = bench::Measure(fn);
+  bench::PrintRow(fmt::format("{}, fixed size", label), fast,
+                  fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+  bench::PrintCheck(fmt::format("{} fixed vs generic", label),
+                    bench::SameBits(generic, out));
+}
+
+void FixedBench() {
+  // every compiled size but 640x360, whose rows are 640x480's; 336x240 has
+  // no compiled kernels, so both rows run the generic code
+  for (auto size : {cv::Size{160, 120}, cv::Size{320, 240},
+                    cv::Size{424, 240}, cv::Size{640, 480},
+                    cv::Size{1280, 720}, cv::Size{336, 240}}) {
+    cv::Mat bgr = bench::TestImage(size.width, size.height);
+    cv::Mat yuyv = bench::ToYUYV(bgr);
+    bool fixed = frcvision::FindFixedMorph(size, true) != nullptr;
+    bench::PrintHeader(fmt::format("Fixed size mask kernels, {}x{}{}",
+                                   size.width, size.height,
+                                   fixed ? "" : " (not compiled)"));
+
+    frcvision::ColorThreshold threshold;
+    threshold.SetBounds(frcvision::ColorThreshold::kHSV, {50, 100, 100},
+                        {90, 255, 255});
+    frcvision::BitMask mask, opened;
+    Compare("BGR threshold", [&] { threshold.Apply(bgr, mask); }, mask);
+    Compare("YUYV threshold", [&] { threshold.Apply(yuyv, mask); }, mask);
+
+    threshold.Apply(bgr, mask);
+    Compare(
+        "open 3x3",
+        [&] {
+          frcvision::ErodeMask(mask, opened, {3, 3});
+          frcvision::DilateMask(opened, opened, {3, 3});
+        },
+        opened);
+
+    // the "target" pipeline's mask stage, straight from the camera
+    Compare(
+        "YUYV threshold + open 3x3",
+        [&] {
+          threshold.Apply(yuyv, opened);
+          frcvision::ErodeMask(opened, opened, {3, 3});
+          frcvision::DilateMask(opened, opened, {3, 3});
+        },
+        opened);
+  }
+}
+
+}  // namespace
+
+BENCHMARK("fixed", "mask kernels compiled for the camera mode vs generic",
+          FixedBench);
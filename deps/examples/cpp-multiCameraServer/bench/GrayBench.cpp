@@ -0,0 +1,85 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <vector>
+
+#include <fmt/format.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/Luma.h"
+#include "frcvision/ScaledSink.h"
+
+namespace {
+
+double MaxDiff(const cv::Mat& a, const cv::Mat& b) {
+  if (a.size() != b.size() || a.type() != b.type()) return -1;
+  return cv::norm(a, b, cv::NORM_INF);
+}
+
+void GrayBench() {
+  for (auto size : {cv::Size{320, 240}, cv::Size{640, 480}}) {
+    cv::Mat bgr = bench::TestImage(size.width, size.height);
+    bench::PrintHeader(
+        fmt::format("Grayscale, {}x{}", size.width, size.height));
+
+    cv::Mat ref, out, tmp;
+
+    // MJPEG: luma-only decode vs color decode + conversion
+    std::vector<uint8_t> jpeg;
+    cv::imencode(".jpg", bgr, jpeg, {cv::IMWRITE_JPEG_QUALITY, 85});
+    auto base = bench::Measure([&] {
+      frcvision::DecodeJpeg(jpeg, 1, false, tmp);
+      cv::cvtColor(tmp, ref, cv::COLOR_BGR2GRAY);
+    });
+    bench::PrintRow("MJPEG color decode + cvtColor", base);
+    auto fast =
+        bench::Measure([&] { frcvision::DecodeJpeg(jpeg, 1, true, out); });
+    bench::PrintRow("MJPEG luma-only decode", fast,
+                    fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+    // the color path clamps RGB before recomputing luma, so saturated
+    // colors differ slightly; compare on average
+    double diff = MaxDiff(ref, out);
+    double mean =
+        diff < 0 ? -1 : cv::norm(ref, out, cv::NORM_L1) / ref.total();
+    bench::PrintCheck("MJPEG luma vs cvtColor", mean >= 0 && mean <= 0.5,
+                      fmt::format("mean diff {:.3f}, max {}", mean, diff));
+
+    // YUYV: Y extraction
+    cv::Mat yuyv = bench::ToYUYV(bgr);
+    base = bench::Measure(
+        [&] { cv::cvtColor(yuyv, ref, cv::COLOR_YUV2GRAY_YUYV); });
+    bench::PrintRow("YUYV cvtColor(YUV2GRAY_YUYV)", base);
+    fast = bench::Measure([&] { frcvision::ExtractLumaYUYV(yuyv, out); });
+    bench::PrintRow("YUYV ExtractLumaYUYV", fast,
+                    fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+    diff = MaxDiff(ref, out);
+    bench::PrintCheck("YUYV luma vs cvtColor", diff == 0,
+                      fmt::format("max diff {}", diff));
+
+    // BGR: weighted sum
+    base = bench::Measure([&] { cv::cvtColor(bgr, ref, cv::COLOR_BGR2GRAY); });
+    bench::PrintRow("BGR cvtColor(BGR2GRAY)", base);
+    fast = bench::Measure([&] { frcvision::BgrToGray(bgr, out); });
+    bench::PrintRow("BGR BgrToGray", fast,
+                    fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+    diff = MaxDiff(ref, out);
+    bench::PrintCheck("BGR luma vs cvtColor", diff == 0,
+                      fmt::format("max diff {}", diff));
+
+    // odd widths exercise the scalar tails
+    cv::Mat odd = bgr(cv::Rect{0, 0, size.width - 3, size.height});
+    cv::cvtColor(odd, ref, cv::COLOR_BGR2GRAY);
+    frcvision::BgrToGray(odd, out);
+    diff = MaxDiff(ref, out);
+    bench::PrintCheck("BGR luma, odd width ROI", diff == 0,
+                      fmt::format("max diff {}", diff));
+  }
+}
+
+}  // namespace
+
+BENCHMARK("gray", "luma-only paths for MJPEG, YUYV and BGR vs cvtColor",
+          GrayBench);
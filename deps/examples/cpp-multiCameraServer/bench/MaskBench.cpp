@@ -0,0 +1,148 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include <fmt/format.h>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/BitMask.h"
+
+namespace {
+
+using BlobKey = std::tuple<int, int, int, int, int, double, double>;
+
+// OpenCV labels in a different order, so compare sorted
+std::vector<BlobKey> SortedBlobs(const std::vector<frcvision::Blob>& blobs) {
+  std::vector<BlobKey> keys;
+  for (auto&& b : blobs) {
+    keys.emplace_back(b.box.y, b.box.x, b.box.width, b.box.height, b.area,
+                      b.centroid.x, b.centroid.y);
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+std::vector<BlobKey> SortedStats(const cv::Mat& stats,
+                                 const cv::Mat& centroids) {
+  std::vector<BlobKey> keys;
+  for (int i = 1; i < stats.rows; ++i) {  // label 0 is the background
+    keys.emplace_back(stats.at<int>(i, cv::CC_STAT_TOP),
+                      stats.at<int>(i, cv::CC_STAT_LEFT),
+                      stats.at<int>(i, cv::CC_STAT_WIDTH),
+                      stats.at<int>(i, cv::CC_STAT_HEIGHT),
+                      stats.at<int>(i, cv::CC_STAT_AREA),
+                      centroids.at<double>(i, 0), centroids.at<double>(i, 1));
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+bool SameMask(const cv::Mat& a, const cv::Mat& b) {
+  return a.size() == b.size() && cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+void MaskBench() {
+  // 424 leaves a partial word at the end of every row
+  for (auto size :
+       {cv::Size{320, 240}, cv::Size{424, 240}, cv::Size{640, 480}}) {
+    cv::Mat gray;
+    cv::cvtColor(bench::TestImage(size.width, size.height), gray,
+                 cv::COLOR_BGR2GRAY);
+    cv::Mat mask;
+    cv::threshold(gray, mask, 128, 255, cv::THRESH_BINARY);
+    bench::PrintHeader(
+        fmt::format("Binary mask, {}x{}", size.width, size.height));
+
+    frcvision::BitMask bits, tmp, out;
+    cv::Mat ref, ref2, unpacked;
+    auto stats = bench::Measure([&] { frcvision::PackMask(mask, bits); });
+    bench::PrintRow("PackMask", stats);
+    stats = bench::Measure([&] { frcvision::UnpackMask(bits, unpacked); });
+    bench::PrintRow("UnpackMask", stats);
+    bench::PrintCheck("pack round trip", SameMask(mask, unpacked));
+
+    // opening (erode then dilate) is the usual noise cleanup
+    for (int k : {3, 5}) {
+      cv::Size ksize{k, k};
+      cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, ksize);
+      auto base = bench::Measure([&] {
+        cv::erode(mask, ref2, kernel);
+        cv::dilate(ref2, ref, kernel);
+      });
+      bench::PrintRow(fmt::format("cv::erode + dilate {}x{}", k, k), base);
+      auto fast = bench::Measure([&] {
+        frcvision::ErodeMask(bits, tmp, ksize);
+        frcvision::DilateMask(tmp, out, ksize);
+      });
+      bench::PrintRow(fmt::format("ErodeMask + DilateMask {}x{}", k, k), fast,
+                      fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+      frcvision::UnpackMask(tmp, unpacked);
+      bench::PrintCheck(fmt::format("erode {}x{} vs OpenCV", k, k),
+                        SameMask(ref2, unpacked));
+      frcvision::UnpackMask(out, unpacked);
+      bench::PrintCheck(fmt::format("dilate {}x{} vs OpenCV", k, k),
+                        SameMask(ref, unpacked));
+    }
+
+    // non-square kernels exercise the anchor and the row edges
+    for (auto ksize : {cv::Size{7, 1}, cv::Size{4, 2}}) {
+      cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, ksize);
+      cv::dilate(mask, ref, kernel);
+      frcvision::DilateMask(bits, out, ksize);
+      frcvision::UnpackMask(out, unpacked);
+      bench::PrintCheck(
+          fmt::format("dilate {}x{} vs OpenCV", ksize.width, ksize.height),
+          SameMask(ref, unpacked));
+    }
+
+    // connected components of the cleaned up mask
+    cv::Mat labels, ccStats, centroids;
+    std::vector<frcvision::Blob> blobs;
+    for (int connectivity : {8, 4}) {
+      auto base = bench::Measure([&] {
+        cv::connectedComponentsWithStats(mask, labels, ccStats, centroids,
+                                         connectivity, CV_32S);
+      });
+      bench::PrintRow(
+          fmt::format("connectedComponentsWithStats, {}-way", connectivity),
+          base);
+      auto fast = bench::Measure(
+          [&] { frcvision::FindBlobs(bits, blobs, connectivity); });
+      bench::PrintRow(fmt::format("FindBlobs, {}-way", connectivity), fast,
+                      fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+      bool same = SortedBlobs(blobs) == SortedStats(ccStats, centroids);
+      bench::PrintCheck(
+          fmt::format("blobs vs OpenCV, {}-way", connectivity), same,
+          fmt::format("{} blobs, OpenCV {}", blobs.size(), ccStats.rows - 1));
+    }
+
+    // the whole mask stage: open 3x3, then blobs
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, {3, 3});
+    auto base = bench::Measure([&] {
+      cv::morphologyEx(mask, ref, cv::MORPH_OPEN, kernel);
+      cv::connectedComponentsWithStats(ref, labels, ccStats, centroids, 8,
+                                       CV_32S);
+    });
+    bench::PrintRow("OpenCV open 3x3 + components", base);
+    auto fast = bench::Measure([&] {
+      frcvision::PackMask(mask, bits);
+      frcvision::ErodeMask(bits, tmp, {3, 3});
+      frcvision::DilateMask(tmp, out, {3, 3});
+      frcvision::FindBlobs(out, blobs);
+    });
+    bench::PrintRow("pack + open 3x3 + FindBlobs", fast,
+                    fmt::format("{:.1f}x", base.medianUs / fast.medianUs));
+    bench::PrintCheck("mask stage blobs vs OpenCV",
+                      SortedBlobs(blobs) == SortedStats(ccStats, centroids));
+  }
+}
+
+}  // namespace
+
+BENCHMARK("mask", "bit-packed erode/dilate and blob stats vs OpenCV",
+          MaskBench);
@@ -0,0 +1,70 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <atomic>
+#include <thread>
+
+#include <fmt/format.h>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/WorkPool.h"
+
+namespace {
+
+void PoolBench() {
+  // OpenCV's own threading would hide the pool's effect
+  int cvThreads = cv::getNumThreads();
+  cv::setNumThreads(1);
+
+  frcvision::WorkPool pool;
+  cv::Mat bgr = bench::TestImage(640, 480);
+  cv::Mat ref, out{bgr.size(), bgr.type()};
+
+  // one heavy pipeline: a per-pixel conversion split into row bands
+  bench::PrintHeader(fmt::format("Work pool ({} threads), 640x480 BGR2HSV",
+                                 pool.GetNumThreads()));
+  auto base =
+      bench::Measure([&] { cv::cvtColor(bgr, ref, cv::COLOR_BGR2HSV); });
+  bench::PrintRow("single thread", base);
+  auto par = bench::Measure([&] {
+    pool.ParallelFor(0, bgr.rows, 32, [&](int begin, int end) {
+      cv::Mat dst = out.rowRange(begin, end);
+      cv::cvtColor(bgr.rowRange(begin, end), dst, cv::COLOR_BGR2HSV);
+    });
+  });
+  bench::PrintRow("ParallelFor, 32 row bands", par,
+                  fmt::format("{:.1f}x", base.medianUs / par.medianUs));
+  bench::PrintCheck("bands match single thread",
+                    cv::norm(ref, out, cv::NORM_INF) == 0);
+
+  // several light pipelines: frames submitted as prioritized tasks
+  constexpr int kCameras = 4;
+  cv::Mat outs[kCameras];
+  auto serial = bench::Measure([&] {
+    for (auto& o : outs) cv::cvtColor(bgr, o, cv::COLOR_BGR2HSV);
+  });
+  bench::PrintRow(fmt::format("{} frames, one thread", kCameras), serial);
+  auto pooled = bench::Measure([&] {
+    std::atomic<int> remaining{kCameras};
+    for (int i = 0; i < kCameras; ++i) {
+      pool.Submit(i, [&, i] {
+        cv::cvtColor(bgr, outs[i], cv::COLOR_BGR2HSV);
+        remaining.fetch_sub(1, std::memory_order_release);
+      });
+    }
+    while (remaining.load(std::memory_order_acquire) > 0)
+      std::this_thread::yield();
+  });
+  bench::PrintRow(fmt::format("{} frames, submitted to pool", kCameras),
+                  pooled,
+                  fmt::format("{:.1f}x", serial.medianUs / pooled.medianUs));
+
+  cv::setNumThreads(cvThreads);
+}
+
+}  // namespace
+
+BENCHMARK("pool", "work-stealing pool: split frame and multi-camera",
+          PoolBench);
@@ -0,0 +1,101 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "Bench.h"
+#include "frcvision/Profiler.h"
+
+namespace {
+
+constexpr int kScopes = 1000;  // per measurement, to amortize the call
+constexpr int kThreads = 4;
+constexpr int kRecords = 100000;  // per thread
+
+// the stage whose samples a check finds in the summary, or null
+const wpi::json* FindStage(const wpi::json& summary, std::string_view pipeline,
+                           std::string_view stage) {
+  for (auto&& camera : summary["cameras"]) {
+    for (auto&& p : camera["pipelines"]) {
+      if (p["name"].get<std::string>() != pipeline) continue;
+      for (auto&& s : p["stages"]) {
+        if (s["name"].get<std::string>() == stage) return &s;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void ProfileBench() {
+  using namespace std::chrono_literals;
+  auto& profiler = frcvision::Profiler::GetInstance();
+
+  bench::PrintHeader(fmt::format("Probe overhead ({} scopes)", kScopes));
+  volatile int sink = 0;
+  auto bare = bench::Measure([&] {
+    for (int i = 0; i < kScopes; ++i) sink = sink + 1;
+  });
+  bench::PrintRow("no probe", bare);
+  int probe = profiler.GetProbe("bench", "scope");
+  auto timed = bench::Measure([&] {
+    for (int i = 0; i < kScopes; ++i) {
+      frcvision::ProfileScope scope{probe};
+      sink = sink + 1;
+    }
+  });
+  bench::PrintRow("ProfileScope", timed,
+                  fmt::format("{:.0f} ns per scope",
+                              (timed.medianUs - bare.medianUs) * 1000 /
+                                  kScopes));
+
+  // percentiles land in the bucket of the exact value, at most 25% wide
+  frcvision::LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; ++i) histogram.Record(i * 10us);
+  frcvision::LatencyHistogram::Snapshot snapshot;
+  histogram.Read(snapshot);
+  bool ok = snapshot.count == 1000;
+  for (double fraction : {0.5, 0.9, 0.99}) {
+    double exact = fraction * 10;  // ms
+    double limit = snapshot.GetPercentileMs(fraction);
+    ok = ok && limit >= exact && limit <= exact * 1.25;
+  }
+  bench::PrintCheck("percentiles within one bucket", ok,
+                    fmt::format("p50 {} ms, p99 {} ms (exact 5, 9.9)",
+                                snapshot.GetPercentileMs(0.5),
+                                snapshot.GetPercentileMs(0.99)));
+
+  // a summary taken while threads are recording counts every sample once
+  int threadProbe = profiler.GetProbe("bench", "threads");
+  profiler.Summarize(0);  // start a fresh interval
+  std::vector<std::thread> threads;
+  uint64_t seen = 0;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kRecords; ++i) profiler.Record(threadProbe, 2us);
+    });
+  }
+  auto countStage = [&](const wpi::json& summary) {
+    auto stage = FindStage(summary, "bench", "threads");
+    if (stage) seen += (*stage)["count"].get<uint64_t>();
+  };
+  for (int i = 0; i < 10; ++i) {
+    countStage(profiler.Summarize(1));
+    std::this_thread::sleep_for(1ms);
+  }
+  for (auto&& thread : threads) thread.join();
+  countStage(profiler.Summarize(1));
+  bench::PrintCheck("concurrent summaries count every sample once",
+                    seen == static_cast<uint64_t>(kThreads) * kRecords,
+                    fmt::format("{} of {}", seen, kThreads * kRecords));
+}
+
+}  // namespace
+
+BENCHMARK("profile", "stage probe overhead and histogram accuracy",
+          ProfileBench);
@@ -0,0 +1,123 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <networktables/DoubleArrayTopic.h>
+#include <networktables/NetworkTableInstance.h>
+#include <networktables/StructArrayTopic.h>
+
+#include "Bench.h"
+#include "frcvision/ResultPublisher.h"
+
+namespace {
+
+constexpr int kTargets = 8;
+
+std::vector<frcvision::Target> MakeTargets(int frame) {
+  std::vector<frcvision::Target> targets;
+  for (int i = 0; i < kTargets; ++i) {
+    double v = frame * kTargets + i;
+    targets.push_back({v, v + 0.25, v + 0.5, v + 0.75, v * 2});
+  }
+  return targets;
+}
+
+// waits for the frame published at time to arrive, and compares it
+bool RoundTrip(const nt::StructArraySubscriber<frcvision::Target>& sub,
+               const std::vector<frcvision::Target>& expected, int64_t time) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto value = sub.GetAtomic();
+    if (value.time == time) {
+      if (value.value.size() != expected.size()) return false;
+      for (size_t i = 0; i < expected.size(); ++i) {
+        const auto& a = value.value[i];
+        const auto& b = expected[i];
+        if (a.x != b.x || a.y != b.y || a.width != b.width ||
+            a.height != b.height || a.area != b.area)
+          return false;
+      }
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+void Run(nt::NetworkTableInstance inst) {
+  bench::PrintHeader(
+      fmt::format("Publishing {} targets per frame (pipeline thread)",
+                  kTargets));
+  auto targets = MakeTargets(0);
+  int64_t time = 1;
+
+  // one topic per field, as most examples do it; a reader can see fields
+  // of different frames
+  std::vector<nt::DoubleArrayPublisher> fieldPubs;
+  for (auto field : {"x", "y", "width", "height", "area"}) {
+    fieldPubs.emplace_back(
+        inst.GetDoubleArrayTopic(fmt::format("/bench/fields/{}", field))
+            .Publish());
+  }
+  std::vector<double> values(kTargets);
+  auto fields = bench::Measure([&] {
+    ++time;
+    for (int f = 0; f < 5; ++f) {
+      for (int i = 0; i < kTargets; ++i) {
+        const auto& t = targets[i];
+        double v[] = {t.x, t.y, t.width, t.height, t.area};
+        values[i] = v[f];
+      }
+      fieldPubs[f].Set(values, time);
+    }
+    inst.Flush();
+  });
+  bench::PrintRow("5 double array topics + flush", fields);
+
+  auto structPub =
+      inst.GetStructArrayTopic<frcvision::Target>("/bench/struct").Publish();
+  auto inline_ = bench::Measure([&] {
+    structPub.Set(targets, ++time);
+    inst.Flush();
+  });
+  bench::PrintRow("struct array + flush, inline", inline_,
+                  fmt::format("{:.1f}x", fields.medianUs / inline_.medianUs));
+
+  frcvision::ResultPublisher publisher{inst, "/bench/results"};
+  auto handoff = bench::Measure([&] {
+    publisher.Publish(targets, frcvision::FrameTime{++time, 0});
+  });
+  bench::PrintRow("ResultPublisher::Publish", handoff,
+                  fmt::format("{:.1f}x", fields.medianUs / handoff.medianUs));
+
+  // every frame arrives whole and with its capture time
+  auto sub = inst.GetStructArrayTopic<frcvision::Target>("/bench/results")
+                 .Subscribe({});
+  bool ok = true;
+  for (int frame = 1; frame <= 20 && ok; ++frame) {
+    auto expected = MakeTargets(frame);
+    publisher.Publish(expected, frcvision::FrameTime{++time, 0});
+    ok = RoundTrip(sub, expected, time);
+  }
+  bench::PrintCheck("published frames read back whole", ok,
+                    fmt::format("{} replaced while measuring",
+                                publisher.GetSkipped()));
+}
+
+void PublishBench() {
+  // local instance only, so this measures the pipeline side and not the
+  // network
+  auto inst = nt::NetworkTableInstance::Create();
+  Run(inst);
+  nt::NetworkTableInstance::Destroy(inst);
+}
+
+}  // namespace
+
+BENCHMARK("publish", "struct result publishing vs per-field topics",
+          PublishBench);
@@ -0,0 +1,127 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cscore_raw.h>
+#include <fmt/format.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/FramePyramid.h"
+#include "frcvision/ScaledSink.h"
+
+namespace {
+
+// what a pipeline attached to the camera processes
+struct Consumer {
+  cv::Size size;
+  bool gray;
+};
+
+// the frame the camera delivered; the pyramid doesn't own the data
+void FillFrame(wpi::RawFrame& frame, std::vector<uint8_t>& jpeg,
+               cv::Size size) {
+  frame.data = reinterpret_cast<char*>(jpeg.data());
+  frame.size = jpeg.size();
+  frame.pixelFormat = cs::VideoMode::kMJPEG;
+  frame.width = size.width;
+  frame.height = size.height;
+}
+
+void BenchConsumers(const std::vector<uint8_t>& source, cv::Size size,
+                    const std::vector<Consumer>& consumers) {
+  std::string label;
+  for (auto&& c : consumers) {
+    if (!label.empty()) label += ", ";
+    label += fmt::format("{}x{} {}", c.size.width, c.size.height,
+                         c.gray ? "gray" : "color");
+  }
+  bench::PrintHeader(fmt::format("{}x{} MJPEG frame for {}", size.width,
+                                 size.height, label));
+
+  std::vector<uint8_t> jpeg = source;
+  std::vector<cv::Mat> separate(consumers.size());
+  std::vector<cv::Mat> shared(consumers.size());
+
+  // every pipeline with its own sink decodes the frame itself
+  wpi::RawFrame frame;
+  FillFrame(frame, jpeg, size);
+  cv::Mat decoded;
+  auto base = bench::Measure([&] {
+    for (size_t i = 0; i < consumers.size(); ++i) {
+      auto&& c = consumers[i];
+      int scale = frcvision::ChooseJpegScale(size.width, size.height,
+                                             c.size.width, c.size.height);
+      frcvision::ConvertRawFrame(frame, scale, c.gray, decoded);
+      if (decoded.size() == c.size)
+        decoded.copyTo(separate[i]);
+      else
+        cv::resize(decoded, separate[i], c.size, 0, 0, cv::INTER_AREA);
+    }
+  });
+  bench::PrintRow("decode per pipeline", base);
+
+  // the runtime: one pyramid per frame, each pipeline copies its level
+  frcvision::FramePyramid pyramid;
+  auto fast = bench::Measure([&] {
+    FillFrame(pyramid.Reset(), jpeg, size);
+    int baseLevel = frcvision::FramePyramid::kMaxLevels;
+    bool allGray = true;
+    for (auto&& c : consumers) {
+      baseLevel = std::min(baseLevel, pyramid.ChooseLevel(c.size));
+      allGray = allGray && c.gray;
+    }
+    pyramid.SetBase(baseLevel, allGray);
+    for (size_t i = 0; i < consumers.size(); ++i) {
+      auto&& c = consumers[i];
+      const cv::Mat& level = pyramid.GetLevel(pyramid.ChooseLevel(c.size),
+                                              c.gray);
+      if (level.size() == c.size)
+        level.copyTo(shared[i]);
+      else
+        cv::resize(level, shared[i], c.size, 0, 0, cv::INTER_AREA);
+    }
+  });
+  bench::PrintRow("shared pyramid", fast,
+                  fmt::format("{:.1f}x faster, {} levels built",
+                              base.medianUs / fast.medianUs,
+                              pyramid.GetBuildCount()));
+
+  bool same = true;
+  for (size_t i = 0; i < consumers.size(); ++i) {
+    same = same && shared[i].size() == separate[i].size() &&
+           shared[i].type() == separate[i].type();
+  }
+  bench::PrintCheck("same sizes and types as separate decodes", same);
+  bench::PrintCheck("at most one level built beyond the outputs",
+                    pyramid.GetBuildCount() <=
+                        static_cast<int>(consumers.size()) + 1,
+                    fmt::format("{} levels", pyramid.GetBuildCount()));
+
+  // the pyramid never owned the data
+  frame.data = nullptr;
+  pyramid.Reset().data = nullptr;
+}
+
+void PyramidBench() {
+  cv::Size size{640, 480};
+  std::vector<uint8_t> jpeg;
+  cv::imencode(".jpg", bench::TestImage(size.width, size.height), jpeg,
+               {cv::IMWRITE_JPEG_QUALITY, 85});
+
+  BenchConsumers(jpeg, size, {{{320, 240}, true}, {{160, 120}, false}});
+  BenchConsumers(jpeg, size,
+                 {{{640, 480}, false}, {{320, 240}, true}, {{160, 120}, true}});
+  BenchConsumers(jpeg, size, {{{160, 120}, true}, {{80, 60}, true}});
+}
+
+}  // namespace
+
+BENCHMARK("pyramid",
+          "shared per-camera frame pyramid vs a decode per pipeline",
+          PyramidBench);
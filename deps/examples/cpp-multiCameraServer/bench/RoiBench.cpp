@@ -0,0 +1,133 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+#include <fmt/format.h>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/BitMask.h"
+#include "frcvision/ColorThreshold.h"
+#include "frcvision/RoiTracker.h"
+
+namespace {
+
+constexpr int kFrames = 60;
+constexpr int64_t kFramePeriod = 33333;  // 30 fps
+
+// a green target sweeping across a gray scene, lost for a few frames
+std::vector<cv::Mat> MakeFrames(cv::Size size) {
+  cv::Mat gray, background;
+  cv::cvtColor(bench::TestImage(size.width, size.height), gray,
+               cv::COLOR_BGR2GRAY);
+  cv::cvtColor(gray, background, cv::COLOR_GRAY2BGR);
+  std::vector<cv::Mat> frames;
+  for (int i = 0; i < kFrames; ++i) {
+    cv::Mat frame = background.clone();
+    if (i < 40 || i >= 44) {
+      double t = static_cast<double>(i) / kFrames;
+      cv::Point center{static_cast<int>(size.width * (0.15 + 0.7 * t)),
+                       static_cast<int>(size.height *
+                                        (0.5 + 0.3 * std::sin(6 * t)))};
+      cv::Size target{size.width / 16, size.height / 16};
+      cv::rectangle(frame, cv::Rect{center - cv::Point{target.width / 2,
+                                                       target.height / 2},
+                                    target},
+                    cv::Scalar{0, 255, 0}, cv::FILLED);
+    }
+    frames.emplace_back(std::move(frame));
+  }
+  return frames;
+}
+
+// threshold, opening and largest blob over the window, in frame
+// coordinates
+struct TargetFinder {
+  std::optional<frcvision::Blob> Find(const cv::Mat& image,
+                                      const cv::Rect& window) {
+    threshold.Apply(image(window), mask);
+    frcvision::ErodeMask(mask, mask, {3, 3});
+    frcvision::DilateMask(mask, mask, {3, 3});
+    frcvision::FindBlobs(mask, blobs);
+    std::optional<frcvision::Blob> best;
+    for (auto&& blob : blobs) {
+      if (!best || blob.area > best->area) best = blob;
+    }
+    if (best) {
+      best->box += window.tl();
+      best->centroid += cv::Point2d{window.tl()};
+    }
+    return best;
+  }
+
+  frcvision::ColorThreshold threshold;
+  frcvision::BitMask mask;
+  std::vector<frcvision::Blob> blobs;
+};
+
+void RoiBench() {
+  for (auto size : {cv::Size{320, 240}, cv::Size{640, 480}}) {
+    auto frames = MakeFrames(size);
+    bench::PrintHeader(fmt::format("Target tracking, {} frames of {}x{}",
+                                   kFrames, size.width, size.height));
+
+    TargetFinder finder;
+    finder.threshold.SetBounds(frcvision::ColorThreshold::kHSV,
+                               {50, 100, 100}, {90, 255, 255});
+    std::vector<std::optional<frcvision::Blob>> ref(kFrames);
+    auto base = bench::Measure([&] {
+      for (int i = 0; i < kFrames; ++i)
+        ref[i] = finder.Find(frames[i], cv::Rect{{0, 0}, size});
+    });
+    bench::PrintRow("full frames", base);
+
+    std::vector<std::optional<frcvision::Blob>> found(kFrames);
+    std::vector<cv::Rect> windows(kFrames);
+    frcvision::RoiTracker tracker;
+    int64_t time = 0;
+    auto tracked = bench::Measure([&] {
+      tracker.Reset();
+      for (int i = 0; i < kFrames; ++i) {
+        windows[i] = tracker.Begin(size, time += kFramePeriod);
+        found[i] = finder.Find(frames[i], windows[i]);
+        std::optional<cv::Rect2d> box;
+        if (found[i]) box = cv::Rect2d{found[i]->box};
+        tracker.End(box);
+      }
+    });
+    bench::PrintRow("tracked windows", tracked,
+                    fmt::format("{:.1f}x", base.medianUs / tracked.medianUs));
+
+    // the last pass over the sequence
+    int roiFrames = 0, hits = 0, same = 0;
+    double area = 0;
+    for (int i = 0; i < kFrames; ++i) {
+      area += static_cast<double>(windows[i].area()) / size.area();
+      if (windows[i].size() != size) {
+        ++roiFrames;
+        if (found[i]) ++hits;
+      }
+      if (ref[i].has_value() == found[i].has_value() &&
+          (!ref[i] || (ref[i]->box == found[i]->box &&
+                       ref[i]->area == found[i]->area)))
+        ++same;
+    }
+    bench::PrintCheck("same target as full frames", same == kFrames,
+                      fmt::format("{} of {} frames", same, kFrames));
+    bench::PrintCheck("windows used while tracking", roiFrames > kFrames / 2,
+                      fmt::format("hit rate {:.0f}%, {:.0f}% of the pixels "
+                                  "processed",
+                                  100.0 * hits / std::max(roiFrames, 1),
+                                  100 * area / kFrames));
+  }
+}
+
+}  // namespace
+
+BENCHMARK("roi", "predictive region of interest tracking vs full frames",
+          RoiBench);
@@ -0,0 +1,109 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string_view>
+#include <thread>
+
+#include <fmt/format.h>
+#include <opencv2/imgproc.hpp>
+
+#include "Bench.h"
+#include "frcvision/TiledStages.h"
+
+namespace {
+
+bool SameImage(const cv::Mat& a, const cv::Mat& b) {
+  return a.size() == b.size() && a.type() == b.type() &&
+         cv::norm(a, b, cv::NORM_INF) == 0;
+}
+
+// runs fn as a pool task, as a pipeline's Process is run, so the calling
+// worker is one of the pool's threads
+void RunInPool(frcvision::WorkPool& pool, const std::function<void()>& fn) {
+  std::atomic_bool done{false};
+  pool.Submit(0, [&] {
+    fn();
+    done.store(true, std::memory_order_release);
+  });
+  while (!done.load(std::memory_order_acquire)) std::this_thread::yield();
+}
+
+struct Stage {
+  std::string_view name;
+  std::function<void(frcvision::TiledStages& tiles)> run;
+  std::function<bool()> same;  // output matches the untiled one
+};
+
+void TileBench() {
+  // OpenCV's own threading would hide the bands' effect
+  int cvThreads = cv::getNumThreads();
+  cv::setNumThreads(1);
+
+  cv::Size size{1280, 720};
+  cv::Mat bgr = bench::TestImage(size.width, size.height);
+  frcvision::ColorThreshold threshold;
+  threshold.SetBounds(frcvision::ColorThreshold::kHSV, {50, 100, 100},
+                      {90, 255, 255});
+  frcvision::BitMask mask, refMask, opened, refOpened;
+  threshold.Apply(bgr, mask);
+  cv::Mat image, refImage;
+
+  Stage stages[] = {
+      {"threshold",
+       [&](auto& tiles) { tiles.Threshold(threshold, bgr, opened); },
+       [&] { return bench::SameBits(opened, refOpened); }},
+      {"open 3x3",
+       [&](auto& tiles) {
+         tiles.Erode(mask, opened, {3, 3});
+         tiles.Dilate(opened, opened, {3, 3});
+       },
+       [&] { return bench::SameBits(opened, refOpened); }},
+      {"GaussianBlur 5x5",
+       [&](auto& tiles) { tiles.GaussianBlur(bgr, image, {5, 5}, 0); },
+       [&] { return SameImage(image, refImage); }},
+      {"cvtColor BGR2HSV",
+       [&](auto& tiles) { tiles.CvtColor(bgr, image, cv::COLOR_BGR2HSV); },
+       [&] { return SameImage(image, refImage); }},
+  };
+
+  int maxThreads = static_cast<int>(
+      std::clamp(std::thread::hardware_concurrency(), 1u, 4u));
+  for (auto&& stage : stages) {
+    bench::PrintHeader(fmt::format("Tiled {}, {}x{}", stage.name, size.width,
+                                   size.height));
+    // the whole frame on one thread, as below TileSettings::minPixels
+    frcvision::WorkPool single{1};
+    frcvision::TiledStages untiled{single, {0, 0}};
+    bench::Stats base;
+    RunInPool(single,
+              [&] { base = bench::Measure([&] { stage.run(untiled); }); });
+    bench::PrintRow("untiled", base);
+    refOpened = opened;
+    refImage = image.clone();
+
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+      frcvision::WorkPool pool{threads};
+      frcvision::TiledStages tiles{pool, {1, 0}};
+      bench::Stats stats;
+      RunInPool(pool,
+                [&] { stats = bench::Measure([&] { stage.run(tiles); }); });
+      bench::PrintRow(
+          fmt::format("{} core{}", threads, threads == 1 ? "" : "s"), stats,
+          fmt::format("{:.1f}x", base.medianUs / stats.medianUs));
+      bench::PrintCheck(
+          fmt::format("{} on {} cores vs untiled", stage.name, threads),
+          stage.same());
+    }
+  }
+
+  cv::setNumThreads(cvThreads);
+}
+
+}  // namespace
+
+BENCHMARK("tile", "stages split into bands over 1 to 4 cores, 1280x720",
+          TileBench);
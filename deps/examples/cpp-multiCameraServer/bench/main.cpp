@@ -0,0 +1,64 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "BenchRegistry.h"
+
+static void Usage() {
+  fmt::print(stderr,
+             "usage: multiCameraServerBench [-i image] [-t seconds] "
+             "[benchmark ...]\n\nbenchmarks:\n");
+  for (auto&& b : bench::GetBenchmarks())
+    fmt::print(stderr, "  {:<12} {}\n", b.name, b.description);
+}
+
+int main(int argc, char* argv[]) {
+  auto& options = bench::MutableOptions();
+  std::vector<std::string_view> names;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg{argv[i]};
+    if (arg == "-i" && i + 1 < argc) {
+      options.image = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      options.seconds = std::atof(argv[++i]);
+    } else if (arg == "-h" || arg == "--help" || arg[0] == '-') {
+      Usage();
+      return EXIT_FAILURE;
+    } else {
+      names.push_back(arg);
+    }
+  }
+
+  for (auto name : names) {
+    bool found = false;
+    for (auto&& b : bench::GetBenchmarks()) {
+      if (name == b.name) found = true;
+    }
+    if (!found) {
+      fmt::print(stderr, "unknown benchmark '{}'\n", name);
+      Usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  for (auto&& b : bench::GetBenchmarks()) {
+    bool selected = names.empty();
+    for (auto name : names) {
+      if (name == b.name) selected = true;
+    }
+    if (selected) b.func();
+  }
+
+  if (int failures = bench::CheckFailures(); failures != 0) {
+    fmt::print(stderr, "\n{} check{} failed\n", failures,
+               failures == 1 ? "" : "s");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,353 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "BitMask.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "FixedKernels.h"
+
+using namespace frcvision;
+
+namespace {
+
+// bits of one mask byte expanded to 8 pixels of 0 or 255
+std::array<std::array<uint8_t, 8>, 256> MakeExpandTable() {
+  std::array<std::array<uint8_t, 8>, 256> table;
+  for (int b = 0; b < 256; ++b) {
+    for (int i = 0; i < 8; ++i) table[b][i] = (b >> i) & 1 ? 255 : 0;
+  }
+  return table;
+}
+
+// works for both uint64_t and cv::v_uint64
+template <bool kErode, typename T>
+T Combine(const T& a, const T& b) {
+  if constexpr (kErode)
+    return a & b;
+  else
+    return a | b;
+}
+
+// combines the pixels from left to the left through right to the right of
+// each bit; load(d) returns the word (or words) d words away
+template <bool kErode, typename T, typename Load>
+T Window(Load load, int left, int right) {
+  T center = load(0);
+  T acc = center;
+  if (right > 0) {
+    T next = load(1);
+    for (int s = 1; s <= right; ++s)
+      acc = Combine<kErode>(acc, (center >> s) | (next << (64 - s)));
+  }
+  if (left > 0) {
+    T prev = load(-1);
+    for (int s = 1; s <= left; ++s)
+      acc = Combine<kErode>(acc, (center << s) | (prev >> (64 - s)));
+  }
+  return acc;
+}
+
+// rows [begin, end) of dst, which is already src's size; the horizontal
+// pass covers the rows above and below the band that the kernel reaches,
+// so dst may only be src if the band is the whole mask
+template <bool kErode>
+void MorphRows(const BitMask& src, BitMask& dst, cv::Size kernel, int begin,
+               int end) {
+  // the usual 3x3 opening at a camera mode has its own compiled kernel
+  if (kernel == cv::Size{3, 3}) {
+    if (auto fixed = FindFixedMorph({src.Width(), src.Height()}, kErode)) {
+      fixed(src, dst, begin, end);
+      return;
+    }
+  }
+  CV_Assert(kernel.width > 0 && kernel.width < 128 && kernel.height > 0 &&
+            kernel.height < 128);
+  int width = src.Width();
+  int height = src.Height();
+  int words = src.WordsPerRow();
+  // anchor at the center, as cv::erode and cv::dilate default to
+  int left = kernel.width / 2;
+  int right = kernel.width - 1 - left;
+  int up = kernel.height / 2;
+  int down = kernel.height - 1 - up;
+  // the default border never changes the result: erosion sees set pixels
+  // outside the image, dilation clear ones
+  const uint64_t fill = kErode ? ~uint64_t{0} : 0;
+  const uint64_t lastMask =
+      width % 64 == 0 ? ~uint64_t{0} : (uint64_t{1} << (width % 64)) - 1;
+
+  thread_local BitMask tmp;
+  thread_local std::vector<uint64_t> padded;
+  tmp.Create(width, height);
+  if (words == 0 || begin >= end) return;
+  padded.resize(words + 2);
+  uint64_t* row = padded.data() + 1;
+#if CV_SIMD
+  const int lanes = cv::VTraits<cv::v_uint64>::vlanes();
+#endif
+
+  // horizontal pass, one row at a time with a word of border either side
+  for (int y = std::max(0, begin - up); y < std::min(height, end + down);
+       ++y) {
+    std::copy_n(src.Row(y), words, row);
+    row[-1] = fill;
+    row[words - 1] |= fill & ~lastMask;
+    row[words] = fill;
+    uint64_t* out = tmp.Row(y);
+    int w = 0;
+#if CV_SIMD
+    for (; w <= words - lanes; w += lanes) {
+      cv::v_store(out + w, Window<kErode, cv::v_uint64>(
+                               [&](int d) { return cv::vx_load(row + w + d); },
+                               left, right));
+    }
+#endif
+    for (; w < words; ++w) {
+      out[w] = Window<kErode, uint64_t>([&](int d) { return row[w + d]; },
+                                        left, right);
+    }
+    out[words - 1] &= lastMask;
+  }
+
+  // vertical pass; rows outside the image are left out
+  for (int y = begin; y < end; ++y) {
+    int first = std::max(0, y - up);
+    int last = std::min(height - 1, y + down);
+    uint64_t* out = dst.Row(y);
+    int w = 0;
+#if CV_SIMD
+    for (; w <= words - lanes; w += lanes) {
+      cv::v_uint64 acc = cv::vx_load(tmp.Row(first) + w);
+      for (int r = first + 1; r <= last; ++r)
+        acc = Combine<kErode>(acc, cv::vx_load(tmp.Row(r) + w));
+      cv::v_store(out + w, acc);
+    }
+#endif
+    for (; w < words; ++w) {
+      uint64_t acc = tmp.Row(first)[w];
+      for (int r = first + 1; r <= last; ++r)
+        acc = Combine<kErode>(acc, tmp.Row(r)[w]);
+      out[w] = acc;
+    }
+  }
+}
+
+template <bool kErode>
+void Morph(const BitMask& src, BitMask& dst, cv::Size kernel) {
+  dst.Create(src.Width(), src.Height());
+  MorphRows<kErode>(src, dst, kernel, 0, src.Height());
+}
+
+struct Run {
+  int start;
+  int end;
+  int label;
+};
+
+struct BlobSums {
+  int64_t sumX = 0;
+  int64_t sumY = 0;
+  int area = 0;
+  int minX = INT32_MAX;
+  int minY = INT32_MAX;
+  int maxX = -1;
+  int maxY = -1;
+};
+
+// first pixel at or after x that is set (or clear); words * 64 if none
+int NextPixel(const uint64_t* row, int words, int x, bool set) {
+  int w = x / 64;
+  if (w >= words) return words * 64;
+  uint64_t word = (set ? row[w] : ~row[w]) & (~uint64_t{0} << (x % 64));
+  while (word == 0) {
+    if (++w == words) return words * 64;
+    word = set ? row[w] : ~row[w];
+  }
+  return w * 64 + std::countr_zero(word);
+}
+
+int FindRoot(std::vector<int>& parent, int label) {
+  while (parent[label] != label) {
+    parent[label] = parent[parent[label]];
+    label = parent[label];
+  }
+  return label;
+}
+
+// the smaller label becomes the root, so a set's root is its first label
+int Merge(std::vector<int>& parent, int a, int b) {
+  a = FindRoot(parent, a);
+  b = FindRoot(parent, b);
+  if (a < b) {
+    parent[b] = a;
+    return a;
+  }
+  parent[a] = b;
+  return b;
+}
+
+}  // namespace
+
+void BitMask::Create(int width, int height) {
+  m_width = width;
+  m_height = height;
+  m_words = (width + 63) / 64;
+  m_bits.resize(static_cast<size_t>(m_words) * height);
+}
+
+void frcvision::PackMask(const cv::Mat& mask, BitMask& bits) {
+  CV_Assert(mask.type() == CV_8UC1);
+  bits.Create(mask.cols, mask.rows);
+  int width = mask.cols;
+  for (int y = 0; y < mask.rows; ++y) {
+    const uint8_t* src = mask.ptr<uint8_t>(y);
+    uint64_t* dst = bits.Row(y);
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    const cv::v_uint8 zero = cv::vx_setzero_u8();
+    const uint64_t laneBits =
+        lanes >= 64 ? ~uint64_t{0} : (uint64_t{1} << lanes) - 1;
+    for (; x <= width - 64; x += 64) {
+      uint64_t word = 0;
+      for (int i = 0; i < 64; i += lanes) {
+        auto set = cv::v_signmask(cv::vx_load(src + x + i) > zero);
+        word |= (static_cast<uint64_t>(set) & laneBits) << i;
+      }
+      dst[x / 64] = word;
+    }
+#endif
+    for (; x < width; x += 64) {
+      int n = std::min(64, width - x);
+      uint64_t word = 0;
+      for (int i = 0; i < n; ++i)
+        word |= static_cast<uint64_t>(src[x + i] != 0) << i;
+      dst[x / 64] = word;
+    }
+  }
+}
+
+void frcvision::UnpackMask(const BitMask& bits, cv::Mat& mask) {
+  static const auto table = MakeExpandTable();
+  mask.create(bits.Height(), bits.Width(), CV_8UC1);
+  int width = bits.Width();
+  for (int y = 0; y < bits.Height(); ++y) {
+    const uint64_t* src = bits.Row(y);
+    uint8_t* dst = mask.ptr<uint8_t>(y);
+    int x = 0;
+    for (; x <= width - 8; x += 8) {
+      uint8_t byte = src[x / 64] >> (x % 64);
+      std::memcpy(dst + x, table[byte].data(), 8);
+    }
+    for (; x < width; ++x) dst[x] = (src[x / 64] >> (x % 64)) & 1 ? 255 : 0;
+  }
+}
+
+void frcvision::ErodeMask(const BitMask& src, BitMask& dst,
+                          cv::Size kernel) {
+  Morph<true>(src, dst, kernel);
+}
+
+void frcvision::DilateMask(const BitMask& src, BitMask& dst,
+                           cv::Size kernel) {
+  Morph<false>(src, dst, kernel);
+}
+
+void frcvision::ErodeMaskRows(const BitMask& src, BitMask& dst,
+                              cv::Size kernel, int begin, int end) {
+  MorphRows<true>(src, dst, kernel, begin, end);
+}
+
+void frcvision::DilateMaskRows(const BitMask& src, BitMask& dst,
+                               cv::Size kernel, int begin, int end) {
+  MorphRows<false>(src, dst, kernel, begin, end);
+}
+
+void frcvision::FindBlobs(const BitMask& mask, std::vector<Blob>& blobs,
+                          int connectivity) {
+  CV_Assert(connectivity == 4 || connectivity == 8);
+  // how far apart runs in adjacent rows can be and still touch
+  const int reach = connectivity == 8 ? 1 : 0;
+  int width = mask.Width();
+  int words = mask.WordsPerRow();
+
+  thread_local std::vector<Run> runs;
+  thread_local std::vector<size_t> rowStart;
+  thread_local std::vector<int> parent;
+  runs.clear();
+  rowStart.clear();
+  parent.clear();
+
+  // first pass: runs of each row, labeled from the runs they touch in the
+  // row above
+  for (int y = 0; y < mask.Height(); ++y) {
+    size_t prev = y > 0 ? rowStart.back() : 0;
+    size_t prevEnd = runs.size();
+    rowStart.push_back(runs.size());
+    const uint64_t* row = mask.Row(y);
+    for (int x = NextPixel(row, words, 0, true); x < width;
+         x = NextPixel(row, words, x, true)) {
+      int end = NextPixel(row, words, x, false);
+      while (prev < prevEnd && runs[prev].end + reach <= x) ++prev;
+      int label = -1;
+      for (size_t i = prev; i < prevEnd && runs[i].start < end + reach; ++i) {
+        label = label < 0 ? FindRoot(parent, runs[i].label)
+                          : Merge(parent, label, runs[i].label);
+      }
+      if (label < 0) {
+        label = parent.size();
+        parent.push_back(label);
+      }
+      runs.push_back({x, end, label});
+      x = end;
+    }
+  }
+  rowStart.push_back(runs.size());
+
+  // number the sets in order of their roots, which is raster order of the
+  // first pixel
+  thread_local std::vector<int> index;
+  index.resize(parent.size());
+  int count = 0;
+  for (size_t i = 0; i < parent.size(); ++i) {
+    int root = FindRoot(parent, i);
+    index[i] = root == static_cast<int>(i) ? count++ : index[root];
+  }
+
+  // second pass: statistics per blob
+  thread_local std::vector<BlobSums> sums;
+  sums.assign(count, BlobSums{});
+  for (int y = 0; y < mask.Height(); ++y) {
+    for (size_t i = rowStart[y]; i < rowStart[y + 1]; ++i) {
+      const Run& run = runs[i];
+      BlobSums& s = sums[index[run.label]];
+      int length = run.end - run.start;
+      s.area += length;
+      s.sumX += static_cast<int64_t>(run.start + run.end - 1) * length / 2;
+      s.sumY += static_cast<int64_t>(y) * length;
+      s.minX = std::min(s.minX, run.start);
+      s.maxX = std::max(s.maxX, run.end - 1);
+      s.minY = std::min(s.minY, y);
+      s.maxY = y;
+    }
+  }
+
+  blobs.resize(count);
+  for (int i = 0; i < count; ++i) {
+    const BlobSums& s = sums[i];
+    blobs[i].box = cv::Rect{s.minX, s.minY, s.maxX - s.minX + 1,
+                            s.maxY - s.minY + 1};
+    blobs[i].area = s.area;
+    // same operations as OpenCV, so the centroids compare equal
+    blobs[i].centroid =
+        cv::Point2d{static_cast<double>(s.sumX) / s.area,
+                    static_cast<double>(s.sumY) / s.area};
+  }
+}
@@ -0,0 +1,90 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_BITMASK_H_
+#define FRCVISION_BITMASK_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace frcvision {
+
+/*
+   Binary image packed 64 pixels to a word, for the mask stage of target
+   pipelines (threshold, clean up with erode/dilate, then find blobs).
+
+   Bit x % 64 of word x / 64 in a row is pixel x.  Bits past the width in
+   the last word of each row are always 0.
+ */
+class BitMask {
+ public:
+  void Create(int width, int height);
+
+  int Width() const { return m_width; }
+  int Height() const { return m_height; }
+  int WordsPerRow() const { return m_words; }
+
+  uint64_t* Row(int y) { return m_bits.data() + y * m_words; }
+  const uint64_t* Row(int y) const { return m_bits.data() + y * m_words; }
+
+ private:
+  std::vector<uint64_t> m_bits;
+  int m_width = 0;
+  int m_height = 0;
+  int m_words = 0;
+};
+
+/*
+   Conversions to and from CV_8UC1 masks; nonzero pixels are set, and
+   unpacking writes 255 for set pixels.
+ */
+void PackMask(const cv::Mat& mask, BitMask& bits);
+void UnpackMask(const BitMask& bits, cv::Mat& mask);
+
+/*
+   Morphology with a rectangular kernel of all ones, anchored at the
+   center, matching cv::erode and cv::dilate on the unpacked mask with the
+   default border.  Each pass handles 64 pixels per word, and a SIMD
+   register of words at a time with OpenCV's universal intrinsics (NEON on
+   the rPi, SSE/AVX on a desktop).  3x3 kernels on masks of a common
+   camera mode run a version compiled for that size (see FixedKernels.h).
+   Kernel sides must be below 128.  dst may be the same as src.
+ */
+void ErodeMask(const BitMask& src, BitMask& dst, cv::Size kernel);
+void DilateMask(const BitMask& src, BitMask& dst, cv::Size kernel);
+
+/*
+   Rows [begin, end) of ErodeMask and DilateMask, for splitting a mask into
+   bands run on different threads (see TiledStages.h).  Each band reads
+   the kernel's reach of rows above and below it from src, so dst must
+   already have src's size and must not be src.
+ */
+void ErodeMaskRows(const BitMask& src, BitMask& dst, cv::Size kernel,
+                   int begin, int end);
+void DilateMaskRows(const BitMask& src, BitMask& dst, cv::Size kernel,
+                    int begin, int end);
+
+struct Blob {
+  cv::Rect box;
+  int area = 0;
+  cv::Point2d centroid;
+};
+
+/*
+   Finds the connected components of the set pixels (connectivity 4 or 8)
+   in two passes over runs of set pixels, skipping empty words.  Blobs are
+   in raster order of their first pixel.  Each has the same box, area and
+   centroid as cv::connectedComponentsWithStats reports for its label,
+   though OpenCV's block-based 8-connectivity labeling numbers the labels
+   in a different order.
+ */
+void FindBlobs(const BitMask& mask, std::vector<Blob>& blobs,
+               int connectivity = 8);
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_BITMASK_H_
@@ -0,0 +1,183 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "ColorThreshold.h"
+
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+#include "FixedKernels.h"
+
+using namespace frcvision;
+
+namespace {
+
+// table index of pixel x in a row: the first channel (B, or Y) is most
+// significant
+template <bool kYUYV>
+inline uint32_t Index(const uint8_t* row, int x, int bits) {
+  int shift = 8 - bits;
+  uint32_t c0, c1, c2;
+  if constexpr (kYUYV) {
+    // Y0 U Y1 V: both pixels of a pair share U and V
+    const uint8_t* pair = row + 4 * (x / 2);
+    c0 = row[2 * x];
+    c1 = pair[1];
+    c2 = pair[3];
+  } else {
+    const uint8_t* p = row + 3 * x;
+    c0 = p[0];
+    c1 = p[1];
+    c2 = p[2];
+  }
+  return ((c0 >> shift) << (2 * bits)) | ((c1 >> shift) << bits) |
+         (c2 >> shift);
+}
+
+inline uint64_t Lookup(const uint64_t* table, uint32_t index) {
+  return (table[index / 64] >> (index % 64)) & 1;
+}
+
+template <bool kYUYV>
+void LookupMask(const cv::Mat& image, const uint64_t* table, int bits,
+                cv::Mat& mask) {
+  mask.create(image.rows, image.cols, CV_8UC1);
+  for (int y = 0; y < image.rows; ++y) {
+    const uint8_t* src = image.ptr<uint8_t>(y);
+    uint8_t* dst = mask.ptr<uint8_t>(y);
+    for (int x = 0; x < image.cols; ++x) {
+      uint64_t set = Lookup(table, Index<kYUYV>(src, x, bits));
+      dst[x] = set ? 255 : 0;
+    }
+  }
+}
+
+// rows [begin, end) of the mask, which is already the image's size
+template <bool kYUYV>
+void LookupBits(const cv::Mat& image, const uint64_t* table, int bits,
+                BitMask& mask, int begin, int end) {
+  int width = image.cols;
+  for (int y = begin; y < end; ++y) {
+    const uint8_t* src = image.ptr<uint8_t>(y);
+    uint64_t* dst = mask.Row(y);
+    for (int x = 0; x < width; x += 64) {
+      int n = std::min(64, width - x);
+      uint64_t word = 0;
+      for (int i = 0; i < n; ++i)
+        word |= Lookup(table, Index<kYUYV>(src, x + i, bits)) << i;
+      dst[x / 64] = word;
+    }
+  }
+}
+
+}  // namespace
+
+ColorThreshold::ColorThreshold(int bits) : m_bits{bits} {
+  CV_Assert(bits >= 4 && bits <= 8);
+}
+
+bool ColorThreshold::SetBounds(Space space, const cv::Scalar& low,
+                               const cv::Scalar& high) {
+  if (space == m_space && low == m_low && high == m_high) return false;
+  m_space = space;
+  m_low = low;
+  m_high = high;
+  m_bgr.valid = false;
+  m_yuyv.valid = false;
+  return true;
+}
+
+void ColorThreshold::Apply(const cv::Mat& image, cv::Mat& mask) {
+  const uint64_t* table = GetTable(image.type());
+  if (image.type() == CV_8UC2)
+    LookupMask<true>(image, table, m_bits, mask);
+  else
+    LookupMask<false>(image, table, m_bits, mask);
+}
+
+void ColorThreshold::Apply(const cv::Mat& image, BitMask& mask) {
+  Prepare(image, mask);
+  ApplyRows(image, mask, 0, image.rows);
+}
+
+void ColorThreshold::Prepare(const cv::Mat& image, BitMask& mask) {
+  GetTable(image.type());
+  mask.Create(image.cols, image.rows);
+}
+
+void ColorThreshold::ApplyRows(const cv::Mat& image, BitMask& mask,
+                               int begin, int end) const {
+  bool yuyv = image.type() == CV_8UC2;
+  const uint64_t* table = yuyv ? m_yuyv.bits.data() : m_bgr.bits.data();
+  if (m_bits == kFixedThresholdBits) {
+    if (auto fixed = FindFixedThreshold(image.size(), image.type())) {
+      fixed(image, table, mask, begin, end);
+      return;
+    }
+  }
+  if (yuyv)
+    LookupBits<true>(image, table, m_bits, mask, begin, end);
+  else
+    LookupBits<false>(image, table, m_bits, mask, begin, end);
+}
+
+const uint64_t* ColorThreshold::GetTable(int type) {
+  CV_Assert(type == CV_8UC3 || type == CV_8UC2);
+  bool yuyv = type == CV_8UC2;
+  Table& table = yuyv ? m_yuyv : m_bgr;
+  if (!table.valid) Build(table, yuyv);
+  return table.bits.data();
+}
+
+void ColorThreshold::Build(Table& table, bool yuyv) {
+  int cells = 1 << m_bits;
+  int shift = 8 - m_bits;
+  auto center = [&](int i) {
+    return shift == 0 ? i : (i << shift) | (1 << (shift - 1));
+  };
+  table.bits.assign((size_t{1} << (3 * m_bits)) / 64, 0);
+
+  // one slice of the first channel at a time, so the conversion buffers
+  // stay small even for the full 8 bit table
+  cv::Mat slice, bgr, converted, inRange;
+  for (int c0 = 0; c0 < cells; ++c0) {
+    if (yuyv) {
+      // each cell as a pair of identical pixels, converted the same way as
+      // the camera's frames
+      slice.create(cells * cells, 2, CV_8UC2);
+      for (int c1 = 0; c1 < cells; ++c1) {
+        for (int c2 = 0; c2 < cells; ++c2) {
+          uint8_t* p = slice.ptr<uint8_t>(c1 * cells + c2);
+          p[0] = p[2] = center(c0);
+          p[1] = center(c1);
+          p[3] = center(c2);
+        }
+      }
+      cv::cvtColor(slice, bgr, cv::COLOR_YUV2BGR_YUYV);
+    } else {
+      bgr.create(cells * cells, 1, CV_8UC3);
+      for (int c1 = 0; c1 < cells; ++c1) {
+        for (int c2 = 0; c2 < cells; ++c2) {
+          uint8_t* p = bgr.ptr<uint8_t>(c1 * cells + c2);
+          p[0] = center(c0);
+          p[1] = center(c1);
+          p[2] = center(c2);
+        }
+      }
+    }
+    cv::cvtColor(bgr, converted,
+                 m_space == kHSV ? cv::COLOR_BGR2HSV : cv::COLOR_BGR2YCrCb);
+    cv::inRange(converted, m_low, m_high, inRange);
+
+    size_t base = static_cast<size_t>(c0) * cells * cells;
+    for (int i = 0; i < cells * cells; ++i) {
+      // first pixel of the row, which for YUYV is the first of the pair
+      if (inRange.ptr<uint8_t>(i)[0] != 0)
+        table.bits[(base + i) / 64] |= uint64_t{1} << ((base + i) % 64);
+    }
+  }
+  table.valid = true;
+  ++m_builds;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_COLORTHRESHOLD_H_
+#define FRCVISION_COLORTHRESHOLD_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "BitMask.h"
+
+namespace frcvision {
+
+/*
+   Color threshold as a single table lookup per pixel, replacing
+   cv::cvtColor + cv::inRange.
+
+   The HSV or YCrCb bounds are compiled into a bit table indexed directly
+   by the source pixel (BGR, or YUYV straight from the camera), with each
+   channel quantized to the given number of bits.  Each table cell is
+   decided by converting its center color with cv::cvtColor, so at 8 bits
+   the result matches cvtColor + inRange exactly; at the default 6 bits
+   the table is 32 KiB and stays in L1 cache, and only colors within one
+   quantization step of a bound can differ.  At 6 bits, frames of a common
+   camera mode are looked up into a BitMask by a version compiled for
+   their size and format (see FixedKernels.h).
+
+   Tables are built on first use and rebuilt only after SetBounds changes
+   the bounds, so bounds can be fed from NetworkTables every frame.
+ */
+class ColorThreshold {
+ public:
+  enum Space { kHSV, kYCrCb };
+
+  // bits per channel, 4 to 8
+  explicit ColorThreshold(int bits = 6);
+
+  // inclusive bounds per channel in the given color space, as for
+  // cv::inRange; returns false (and keeps the tables) if unchanged
+  bool SetBounds(Space space, const cv::Scalar& low, const cv::Scalar& high);
+
+  // image is CV_8UC3 BGR or CV_8UC2 YUYV (even width); the mask is 255
+  // where the color is in bounds
+  void Apply(const cv::Mat& image, cv::Mat& mask);
+  void Apply(const cv::Mat& image, BitMask& mask);
+
+  // Apply to a BitMask in row bands, for splitting a frame over threads
+  // (see TiledStages.h): Prepare once, which builds the table and sizes
+  // the mask, then ApplyRows may run concurrently for disjoint bands
+  void Prepare(const cv::Mat& image, BitMask& mask);
+  void ApplyRows(const cv::Mat& image, BitMask& mask, int begin,
+                 int end) const;
+
+  // table rebuilds so far, for checking that bounds aren't churning
+  int GetBuildCount() const { return m_builds; }
+
+ private:
+  struct Table {
+    std::vector<uint64_t> bits;
+    bool valid = false;
+  };
+
+  const uint64_t* GetTable(int type);
+  void Build(Table& table, bool yuyv);
+
+  int m_bits;
+  Space m_space = kHSV;
+  cv::Scalar m_low;
+  cv::Scalar m_high{255, 255, 255};
+  Table m_bgr;
+  Table m_yuyv;
+  int m_builds = 0;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_COLORTHRESHOLD_H_
@@ -0,0 +1,171 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "FixedKernels.h"
+
+#include <atomic>
+#include <utility>
+
+using namespace frcvision;
+
+namespace {
+
+constexpr int kBits = kFixedThresholdBits;
+constexpr int kShift = 8 - kBits;
+
+// table lookups of kCount pixels (kCount <= 64) into one mask word; the
+// indices are computed first, in a loop the compiler can vectorize
+template <bool kYUYV, int kCount>
+inline uint64_t LookupWord(const uint8_t* src, const uint64_t* table) {
+  uint32_t index[kCount];
+  if constexpr (kYUYV) {
+    static_assert(kCount % 2 == 0);
+    // Y0 U Y1 V: both pixels of a pair share U and V
+    for (int i = 0; i < kCount; i += 2) {
+      const uint8_t* pair = src + 2 * i;
+      uint32_t uv = ((pair[1] >> kShift) << kBits) | (pair[3] >> kShift);
+      index[i] = ((pair[0] >> kShift) << (2 * kBits)) | uv;
+      index[i + 1] = ((pair[2] >> kShift) << (2 * kBits)) | uv;
+    }
+  } else {
+    for (int i = 0; i < kCount; ++i) {
+      const uint8_t* p = src + 3 * i;
+      index[i] = ((p[0] >> kShift) << (2 * kBits)) |
+                 ((p[1] >> kShift) << kBits) | (p[2] >> kShift);
+    }
+  }
+  uint64_t word = 0;
+  for (int i = 0; i < kCount; ++i)
+    word |= ((table[index[i] / 64] >> (index[i] % 64)) & 1) << i;
+  return word;
+}
+
+template <int kWidth, int kHeight, bool kYUYV>
+void Threshold(const cv::Mat& image, const uint64_t* table, BitMask& mask,
+               int begin, int end) {
+  static_assert(!kYUYV || kWidth % 2 == 0);
+  constexpr int kFullWords = kWidth / 64;
+  constexpr int kTail = kWidth % 64;
+  constexpr int kPixelBytes = kYUYV ? 2 : 3;
+  for (int y = begin; y < end; ++y) {
+    const uint8_t* src = image.ptr<uint8_t>(y);
+    uint64_t* dst = mask.Row(y);
+    for (int w = 0; w < kFullWords; ++w)
+      dst[w] = LookupWord<kYUYV, 64>(src + w * 64 * kPixelBytes, table);
+    if constexpr (kTail != 0) {
+      const uint8_t* tail = src + kFullWords * 64 * kPixelBytes;
+      dst[kFullWords] = LookupWord<kYUYV, kTail>(tail, table);
+    }
+  }
+}
+
+template <bool kErode>
+inline uint64_t Combine(uint64_t a, uint64_t b) {
+  if constexpr (kErode)
+    return a & b;
+  else
+    return a | b;
+}
+
+// one row through a 1x3 kernel, with the same border as Morph in
+// BitMask.cpp: erosion sees set pixels outside the image, dilation clear
+// ones
+template <int kWidth, bool kErode>
+inline void Horizontal(const uint64_t* in, uint64_t* out) {
+  constexpr int kWords = (kWidth + 63) / 64;
+  constexpr uint64_t kFill = kErode ? ~uint64_t{0} : 0;
+  constexpr uint64_t kLastMask =
+      kWidth % 64 == 0 ? ~uint64_t{0} : (uint64_t{1} << (kWidth % 64)) - 1;
+  for (int w = 0; w < kWords; ++w) {
+    uint64_t center = in[w];
+    if (w == kWords - 1) center |= kFill & ~kLastMask;
+    uint64_t prev = w > 0 ? in[w - 1] : kFill;
+    uint64_t next = w < kWords - 1 ? in[w + 1] : kFill;
+    out[w] = Combine<kErode>(
+        Combine<kErode>(center, (center >> 1) | (next << 63)),
+        (center << 1) | (prev >> 63));
+  }
+  out[kWords - 1] &= kLastMask;
+}
+
+// both passes at once, keeping the horizontal results of three rows; each
+// row of dst is written after the last row of src it needs was read, so
+// dst may be src.  A band starts from the row above it, as the whole
+// image would have reached it.
+template <int kWidth, int kHeight, bool kErode>
+void Morph3x3(const BitMask& src, BitMask& dst, int begin, int end) {
+  constexpr int kWords = (kWidth + 63) / 64;
+  uint64_t rows[3][kWords];
+  uint64_t* above = rows[0];
+  uint64_t* center = rows[1];
+  uint64_t* below = rows[2];
+  if (begin >= end) return;
+  if (begin > 0) Horizontal<kWidth, kErode>(src.Row(begin - 1), above);
+  Horizontal<kWidth, kErode>(src.Row(begin), center);
+  for (int y = begin; y < end; ++y) {
+    // rows outside the image are left out; combining a row with itself
+    // changes nothing, so they are replaced by the center row
+    const uint64_t* up = y > 0 ? above : center;
+    const uint64_t* down = center;
+    if (y + 1 < kHeight) {
+      Horizontal<kWidth, kErode>(src.Row(y + 1), below);
+      down = below;
+    }
+    uint64_t* out = dst.Row(y);
+    for (int w = 0; w < kWords; ++w)
+      out[w] = Combine<kErode>(Combine<kErode>(up[w], center[w]), down[w]);
+    std::swap(above, center);
+    std::swap(center, below);
+  }
+}
+
+struct Kernels {
+  int width;
+  int height;
+  FixedThreshold bgr;
+  FixedThreshold yuyv;
+  FixedMorph erode;
+  FixedMorph dilate;
+};
+
+#define FRCVISION_FIXED_KERNELS(width, height)                       \
+  {width, height, &Threshold<width, height, false>,                  \
+   &Threshold<width, height, true>, &Morph3x3<width, height, true>, \
+   &Morph3x3<width, height, false>},
+
+constexpr Kernels kKernels[] = {
+    FRCVISION_FIXED_SIZES(FRCVISION_FIXED_KERNELS)};
+
+#undef FRCVISION_FIXED_KERNELS
+
+std::atomic<bool> fixedEnabled{true};
+
+const Kernels* FindKernels(cv::Size size) {
+  if (!fixedEnabled.load(std::memory_order_relaxed)) return nullptr;
+  for (auto&& kernels : kKernels) {
+    if (kernels.width == size.width && kernels.height == size.height)
+      return &kernels;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+FixedThreshold frcvision::FindFixedThreshold(cv::Size size, int type) {
+  auto kernels = FindKernels(size);
+  if (!kernels) return nullptr;
+  if (type == CV_8UC3) return kernels->bgr;
+  if (type == CV_8UC2) return kernels->yuyv;
+  return nullptr;
+}
+
+FixedMorph frcvision::FindFixedMorph(cv::Size size, bool erode) {
+  auto kernels = FindKernels(size);
+  if (!kernels) return nullptr;
+  return erode ? kernels->erode : kernels->dilate;
+}
+
+void frcvision::SetFixedKernelsEnabled(bool enabled) {
+  fixedEnabled = enabled;
+}
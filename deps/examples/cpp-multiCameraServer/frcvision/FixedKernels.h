@@ -0,0 +1,66 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_FIXEDKERNELS_H_
+#define FRCVISION_FIXEDKERNELS_H_
+
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+#include "BitMask.h"
+
+/*
+   Camera modes (width, height) the mask stage kernels are compiled for.
+   Add the mode from your /boot/frc.json (or the pipeline's "size") if it
+   isn't listed; widths must be even, as YUYV frames are.
+ */
+#define FRCVISION_FIXED_SIZES(X) \
+  X(160, 120)                    \
+  X(320, 240)                    \
+  X(424, 240)                    \
+  X(640, 360)                    \
+  X(640, 480)                    \
+  X(1280, 720)
+
+namespace frcvision {
+
+/*
+   Versions of the mask stage kernels compiled for one image size and
+   pixel format each, for the sizes above.  With the width, height and
+   table size as compile-time constants the loops have fixed trip counts:
+   the compiler unrolls them, keeps whole rows of a mask in registers,
+   vectorizes the table index arithmetic and drops the edge handling for
+   words that can't be at an edge.
+
+   ColorThreshold::Apply (to a BitMask, at the default 6 bits) and the 3x3
+   ErodeMask and DilateMask use them whenever the image has one of the
+   sizes, and otherwise run their generic code, so nothing needs to
+   change in a pipeline; the results are identical either way.  The
+   kernels work on a range of rows, so the bands TiledStages splits a
+   frame into use them as well.  A region of interest smaller than the
+   frame takes the generic path.
+ */
+constexpr int kFixedThresholdBits = 6;
+
+// rows [begin, end) of ColorThreshold's lookup into a BitMask of the
+// image's size, for a table of kFixedThresholdBits
+using FixedThreshold = void (*)(const cv::Mat& image, const uint64_t* table,
+                                BitMask& mask, int begin, int end);
+// rows [begin, end) of a 3x3 erosion or dilation into dst of src's size;
+// dst may be the same as src unless other bands are run at the same time
+using FixedMorph = void (*)(const BitMask& src, BitMask& dst, int begin,
+                            int end);
+
+// null if there is no kernel for the size and type (CV_8UC3 BGR or
+// CV_8UC2 YUYV), or the kernels are disabled
+FixedThreshold FindFixedThreshold(cv::Size size, int type);
+FixedMorph FindFixedMorph(cv::Size size, bool erode);
+
+// for comparing against the generic kernels; enabled by default
+void SetFixedKernelsEnabled(bool enabled);
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_FIXEDKERNELS_H_
@@ -0,0 +1,119 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "FramePool.h"
+
+#include <atomic>
+#include <utility>
+
+using namespace frcvision;
+
+namespace {
+
+std::atomic<uint64_t> totalAllocations{0};
+thread_local uint64_t threadAllocations = 0;
+
+// forwards to OpenCV's standard allocator, counting new buffers; the
+// buffers record the standard allocator as their owner, so they are freed
+// without passing through here
+class CountingAllocator : public cv::MatAllocator {
+ public:
+  explicit CountingAllocator(cv::MatAllocator* base) : m_base{base} {}
+
+  cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                         size_t* step, cv::AccessFlag flags,
+                         cv::UMatUsageFlags usageFlags) const override {
+    if (!data) {
+      totalAllocations.fetch_add(1, std::memory_order_relaxed);
+      ++threadAllocations;
+    }
+    return m_base->allocate(dims, sizes, type, data, step, flags,
+                            usageFlags);
+  }
+
+  bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                cv::UMatUsageFlags usageFlags) const override {
+    return m_base->allocate(data, accessFlags, usageFlags);
+  }
+
+  void deallocate(cv::UMatData* data) const override {
+    m_base->deallocate(data);
+  }
+
+ private:
+  cv::MatAllocator* m_base;
+};
+
+}  // namespace
+
+FramePool::Handle::Handle(Handle&& rhs) noexcept
+    : m_pool{std::exchange(rhs.m_pool, nullptr)},
+      m_mat{std::move(rhs.m_mat)} {}
+
+FramePool::Handle& FramePool::Handle::operator=(Handle&& rhs) noexcept {
+  if (this != &rhs) {
+    Release();
+    m_pool = std::exchange(rhs.m_pool, nullptr);
+    m_mat = std::move(rhs.m_mat);
+  }
+  return *this;
+}
+
+void FramePool::Handle::Release() {
+  if (m_pool) m_pool->Return(m_mat);
+  m_pool = nullptr;
+  m_mat.release();
+}
+
+FramePool::Handle FramePool::Acquire(cv::Size size, int type) {
+  {
+    std::scoped_lock lock{m_mutex};
+    auto it = m_free.find(Key{size.width, size.height, type});
+    if (it != m_free.end() && !it->second.empty()) {
+      cv::Mat mat = std::move(it->second.back());
+      it->second.pop_back();
+      return Handle{this, std::move(mat)};
+    }
+    ++m_allocations;
+  }
+  return Handle{this, cv::Mat{size, type}};
+}
+
+uint64_t FramePool::GetAllocations() const {
+  std::scoped_lock lock{m_mutex};
+  return m_allocations;
+}
+
+void FramePool::Clear() {
+  std::scoped_lock lock{m_mutex};
+  m_free.clear();
+}
+
+FramePool& FramePool::GetInstance() {
+  static FramePool inst;
+  return inst;
+}
+
+void FramePool::Return(cv::Mat& mat) {
+  // not ours to reuse if it was replaced by a view or is still shared
+  if (mat.empty() || mat.isSubmatrix() || !mat.u || mat.u->refcount != 1)
+    return;
+  std::scoped_lock lock{m_mutex};
+  // keyed on the current size and type, in case it was recreated
+  auto& free = m_free[Key{mat.cols, mat.rows, mat.type()}];
+  if (free.size() < m_maxFree) free.emplace_back(std::move(mat));
+}
+
+void frcvision::InstallMatAllocationCounter() {
+  static CountingAllocator allocator{cv::Mat::getStdAllocator()};
+  cv::Mat::setDefaultAllocator(&allocator);
+}
+
+uint64_t frcvision::GetMatAllocations() {
+  return totalAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t frcvision::GetThreadMatAllocations() {
+  return threadAllocations;
+}
@@ -0,0 +1,100 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_FRAMEPOOL_H_
+#define FRCVISION_FRAMEPOOL_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace frcvision {
+
+/*
+   Pool of image buffers keyed on size and type, so that steady state frame
+   processing does not allocate.
+
+   Acquire returns a Handle that owns a cv::Mat of the requested size and
+   type and gives it back to the pool when destroyed.  Use it for pipeline
+   intermediates instead of declaring a fresh cv::Mat per frame:
+
+     auto mask = FramePool::GetInstance().Acquire(image.size(), CV_8UC1);
+     cv::inRange(hsv, low, high, *mask);
+
+   If a copy of the cv::Mat still refers to the buffer when the handle is
+   destroyed, the buffer is not returned, so pooled memory is never shared.
+ */
+class FramePool {
+ public:
+  class Handle {
+   public:
+    Handle() = default;
+    Handle(Handle&& rhs) noexcept;
+    Handle& operator=(Handle&& rhs) noexcept;
+    ~Handle() { Release(); }
+
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+
+    cv::Mat& operator*() { return m_mat; }
+    cv::Mat* operator->() { return &m_mat; }
+    explicit operator bool() const { return m_pool != nullptr; }
+
+    // returns the buffer to the pool early
+    void Release();
+
+   private:
+    friend class FramePool;
+    Handle(FramePool* pool, cv::Mat mat) : m_pool{pool}, m_mat{mat} {}
+
+    FramePool* m_pool = nullptr;
+    cv::Mat m_mat;
+  };
+
+  // maxFree bounds the idle buffers kept for each size and type
+  explicit FramePool(size_t maxFree = 8) : m_maxFree{maxFree} {}
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  Handle Acquire(cv::Size size, int type);
+
+  // buffers the pool had to allocate; constant once warmed up
+  uint64_t GetAllocations() const;
+
+  // frees all idle buffers
+  void Clear();
+
+  static FramePool& GetInstance();
+
+ private:
+  using Key = std::tuple<int, int, int>;
+
+  void Return(cv::Mat& mat);
+
+  size_t m_maxFree;
+  mutable std::mutex m_mutex;
+  std::map<Key, std::vector<cv::Mat>> m_free;
+  uint64_t m_allocations = 0;
+};
+
+/*
+   Counts cv::Mat buffer allocations (from any cv::Mat, pooled or not) by
+   installing a counting allocator as OpenCV's default.  Counts are kept
+   both in total and per thread, so a pipeline can measure what one frame
+   allocated on its own thread.  Installing is idempotent and should happen
+   before any images are allocated.
+ */
+void InstallMatAllocationCounter();
+uint64_t GetMatAllocations();
+uint64_t GetThreadMatAllocations();
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_FRAMEPOOL_H_
@@ -0,0 +1,115 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "FramePyramid.h"
+
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+#include "Luma.h"
+#include "ScaledSink.h"
+
+using namespace frcvision;
+
+wpi::RawFrame& FramePyramid::Reset() {
+  for (auto&& levels : m_levels) {
+    for (auto&& level : levels) level.built = false;
+  }
+  m_builds = 0;
+  m_baseLevel = kMaxLevels;
+  m_baseGray = true;
+  return m_frame;
+}
+
+cv::Size FramePyramid::GetSize(int level) const {
+  int scale = 1 << level;
+  return {(m_frame.width + scale - 1) / scale,
+          (m_frame.height + scale - 1) / scale};
+}
+
+int FramePyramid::ChooseLevel(cv::Size size) const {
+  if (size.width <= 0 || size.height <= 0) return 0;
+  int level = 0;
+  while (level + 1 < kMaxLevels) {
+    cv::Size next = GetSize(level + 1);
+    if (next.width < size.width || next.height < size.height) break;
+    ++level;
+  }
+  return level;
+}
+
+void FramePyramid::SetBase(int level, bool gray) {
+  m_baseLevel = std::clamp(level, 0, kMaxLevels - 1);
+  m_baseGray = gray;
+}
+
+const cv::Mat& FramePyramid::GetLevel(int level, bool gray) {
+  CV_Assert(level >= 0 && level < kMaxLevels);
+  Level& l = m_levels[gray][level];
+  if (!l.built.load(std::memory_order_acquire)) {
+    std::scoped_lock lock{l.mutex};
+    if (!l.built.load(std::memory_order_relaxed)) {
+      Build(level, gray, l.image);
+      ++m_builds;
+      l.built.store(true, std::memory_order_release);
+    }
+  }
+  return l.image;
+}
+
+cv::Mat FramePyramid::GetYUYV() const {
+  if (m_frame.pixelFormat != cs::VideoMode::kYUYV || !m_frame.data)
+    return {};
+  size_t stride = m_frame.stride > 0 ? m_frame.stride : m_frame.width * 2;
+  if (m_frame.size < stride * m_frame.height) return {};
+  return cv::Mat{m_frame.height, m_frame.width, CV_8UC2, m_frame.data, stride};
+}
+
+const FramePyramid::Level* FramePyramid::FinerBuilt(int level,
+                                                     bool gray) const {
+  for (int i = level - 1; i >= 0; --i) {
+    const Level& l = m_levels[gray][i];
+    if (l.built.load(std::memory_order_acquire) && !l.image.empty())
+      return &l;
+  }
+  return nullptr;
+}
+
+void FramePyramid::Build(int level, bool gray, cv::Mat& image) {
+  // builds only ever wait on finer levels, or gray on BGR, so concurrent
+  // builds can't deadlock
+  cv::Size size = GetSize(level);
+  bool bgrBuilt = m_levels[0][level].built.load(std::memory_order_acquire);
+  if (auto finer = FinerBuilt(level, gray)) {
+    cv::resize(finer->image, image, size, 0, 0, cv::INTER_AREA);
+  } else if (gray && (bgrBuilt || (!m_baseGray && level >= m_baseLevel))) {
+    const cv::Mat& bgr = GetLevel(level, false);
+    if (bgr.empty())
+      image.release();
+    else
+      BgrToGray(bgr, image);
+  } else if (level > m_baseLevel) {
+    const cv::Mat& base = GetLevel(m_baseLevel, gray);
+    if (base.empty())
+      image.release();
+    else
+      cv::resize(base, image, size, 0, 0, cv::INTER_AREA);
+  } else {
+    // the finest level the raw frame converts to directly: JPEG decodes
+    // scaled by up to 8, other formats convert at full size
+    int direct = m_frame.pixelFormat == cs::VideoMode::kMJPEG
+                     ? std::min(level, 3)
+                     : 0;
+    if (level == direct) {
+      if (!ConvertRawFrame(m_frame, 1 << level, gray, image)) image.release();
+    } else {
+      const cv::Mat& src = GetLevel(direct, gray);
+      if (src.empty())
+        image.release();
+      else
+        cv::resize(src, image, size, 0, 0, cv::INTER_AREA);
+    }
+  }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_FRAMEPYRAMID_H_
+#define FRCVISION_FRAMEPYRAMID_H_
+
+#include <atomic>
+#include <mutex>
+
+#include <cscore_raw.h>
+#include <opencv2/core/core.hpp>
+
+namespace frcvision {
+
+/*
+   One camera frame at every size a pipeline asked for, shared by all the
+   pipelines attached to the camera.
+
+   Level 0 is the camera resolution and each level is half the one before
+   (rounded up, as libjpeg scales).  Levels are built on first use, BGR or
+   gray, from the cheapest source available: a finer level that is already
+   built (a 2x or larger cv::resize), the same level in BGR for gray, or
+   the raw frame, which MJPEG decodes straight to levels 0 to 3 with the
+   scaled IDCT (see ScaledSink.h).  With SetBase, the raw frame is decoded
+   only once, at the finest level the consumers need, and all coarser
+   levels are derived from it.  Several pipelines may ask for levels at
+   the same time; each level is built once and the others wait for it.
+
+   Levels are read-only once built.  The runtime recycles pyramids with
+   their buffers, so steady state frames allocate nothing.
+ */
+class FramePyramid {
+ public:
+  static constexpr int kMaxLevels = 6;
+
+  FramePyramid() = default;
+  FramePyramid(const FramePyramid&) = delete;
+  FramePyramid& operator=(const FramePyramid&) = delete;
+
+  // the frame to fill, and forgets the levels of the previous one; must
+  // not be called while the pyramid is shared
+  wpi::RawFrame& Reset();
+
+  // the finest level the frame's consumers will ask for, and whether they
+  // all want gray; call after Reset and before sharing
+  void SetBase(int level, bool gray);
+
+  cv::Size GetSize(int level = 0) const;
+
+  // the coarsest level at least size in both dimensions; 0 for 0x0
+  int ChooseLevel(cv::Size size) const;
+
+  // CV_8UC3 BGR or CV_8UC1 gray; empty if the frame could not be decoded
+  const cv::Mat& GetLevel(int level, bool gray);
+
+  // the raw frame as CV_8UC2 if the camera delivers YUYV, for stages that
+  // work on it directly (ColorThreshold); empty for other formats.  Only
+  // valid while the pyramid is shared.
+  cv::Mat GetYUYV() const;
+
+  // levels built since Reset, for checking that they are shared
+  int GetBuildCount() const { return m_builds; }
+
+ private:
+  struct Level {
+    std::mutex mutex;
+    std::atomic_bool built{false};
+    cv::Mat image;
+  };
+
+  void Build(int level, bool gray, cv::Mat& image);
+  const Level* FinerBuilt(int level, bool gray) const;
+
+  wpi::RawFrame m_frame;
+  int m_baseLevel = kMaxLevels;  // none: decode every level directly
+  bool m_baseGray = true;
+  Level m_levels[2][kMaxLevels];  // [gray][level]
+  std::atomic<int> m_builds{0};
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_FRAMEPYRAMID_H_
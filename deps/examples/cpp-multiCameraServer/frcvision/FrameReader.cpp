@@ -0,0 +1,93 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "FrameReader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include <fmt/format.h>
+#include <opencv2/imgcodecs.hpp>
+#include <wpi/StringExtras.h>
+
+using namespace frcvision;
+
+namespace {
+
+bool IsImage(const std::filesystem::path& path) {
+  auto ext = wpi::to_lower(path.extension().string());
+  return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" ||
+         ext == ".ppm" || ext == ".pgm";
+}
+
+}  // namespace
+
+bool FrameReader::Open(std::string_view path, double fps,
+                       std::string& error) {
+  m_path = path;
+  m_fps = fps > 0 ? fps : 30;
+  m_files.clear();
+  m_video.release();
+
+  std::error_code ec;
+  std::filesystem::path fsPath{m_path};
+  if (std::filesystem::is_directory(fsPath, ec)) {
+    for (auto&& entry : std::filesystem::directory_iterator{fsPath, ec}) {
+      if (entry.is_regular_file() && IsImage(entry.path()))
+        m_files.emplace_back(entry.path().string());
+    }
+    if (ec) {
+      error = fmt::format("could not read '{}': {}", m_path, ec.message());
+      return false;
+    }
+    if (m_files.empty()) {
+      error = fmt::format("no images in '{}'", m_path);
+      return false;
+    }
+    std::sort(m_files.begin(), m_files.end());
+  } else if (IsImage(fsPath)) {
+    m_files.emplace_back(m_path);
+  } else if (!m_video.open(m_path)) {
+    error = fmt::format("could not open video '{}'", m_path);
+    return false;
+  }
+
+  m_index = 0;
+  return true;
+}
+
+bool FrameReader::Read(cv::Mat& frame, double& time) {
+  if (m_files.empty()) {
+    if (!m_video.read(frame) || frame.empty()) return false;
+    double ms = m_video.get(cv::CAP_PROP_POS_MSEC);
+    time = (ms > 0 || m_index == 0) ? ms / 1000 : m_index / m_fps;
+    m_name = fmt::format("{}", m_index++);
+    return true;
+  }
+
+  while (m_index < static_cast<int>(m_files.size())) {
+    const auto& file = m_files[m_index];
+    frame = cv::imread(file, cv::IMREAD_COLOR);
+    time = m_index++ / m_fps;
+    if (!frame.empty()) {
+      m_name = std::filesystem::path{file}.filename().string();
+      return true;
+    }
+    fmt::print(stderr, "skipping unreadable image '{}'\n", file);
+  }
+  return false;
+}
+
+void FrameReader::Rewind() {
+  m_index = 0;
+  // seeking isn't exact for every codec; reopening is
+  if (m_files.empty()) m_video.open(m_path);
+}
+
+int FrameReader::GetCount() const {
+  if (!m_files.empty()) return m_files.size();
+  double count = m_video.get(cv::CAP_PROP_FRAME_COUNT);
+  return count > 0 ? static_cast<int>(count) : -1;
+}
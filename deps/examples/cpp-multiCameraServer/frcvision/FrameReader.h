@@ -0,0 +1,56 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_FRAMEREADER_H_
+#define FRCVISION_FRAMEREADER_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/videoio.hpp>
+
+namespace frcvision {
+
+/*
+   Recorded frames, read back in order: a directory of images (in file
+   name order, as saved by a recorder numbering its frames), a single
+   image, or a video file.
+
+   Each frame has a time in seconds from the first frame: the video's own
+   timestamps if it has them, otherwise the frame number divided by fps.
+ */
+class FrameReader {
+ public:
+  // fps is only used for images and videos without timestamps
+  bool Open(std::string_view path, double fps, std::string& error);
+
+  // false after the last frame; unreadable images are skipped
+  bool Read(cv::Mat& frame, double& time);
+
+  // back to the first frame
+  void Rewind();
+
+  // the image file or video frame number last read, for results
+  const std::string& GetName() const { return m_name; }
+
+  // total frames, or -1 if the video doesn't say
+  int GetCount() const;
+
+  // the rate frames without timestamps are given
+  double GetFps() const { return m_fps; }
+
+ private:
+  std::string m_path;
+  double m_fps = 30;
+  std::vector<std::string> m_files;  // empty for a video
+  cv::VideoCapture m_video;
+  int m_index = 0;  // of the next frame
+  std::string m_name;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_FRAMEREADER_H_
@@ -0,0 +1,80 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_LATESTMAILBOX_H_
+#define FRCVISION_LATESTMAILBOX_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+namespace frcvision {
+
+/*
+   Lock-free single-producer, single-consumer mailbox that only keeps the
+   newest item (a triple buffer).
+
+   The writer fills GetWriteBuffer() and calls Publish(); the reader calls
+   Take() and then uses GetReadBuffer().  Each side owns one of the three
+   buffers at all times and the third is swapped through an atomic, so
+   neither side ever waits for the other and the reader never sees a buffer
+   the writer is filling.  An item published before the reader took the
+   previous one replaces it and is counted as skipped.
+ */
+template <typename T>
+class LatestMailbox {
+ public:
+  LatestMailbox() = default;
+  LatestMailbox(const LatestMailbox&) = delete;
+  LatestMailbox& operator=(const LatestMailbox&) = delete;
+
+  // writer side
+  T& GetWriteBuffer() { return m_buffers[m_write]; }
+
+  // makes the write buffer the newest item; returns true if this replaced
+  // an item the reader never took
+  bool Publish() {
+    uint8_t old =
+        m_middle.exchange(m_write | kFresh, std::memory_order_acq_rel);
+    m_write = old & kIndexMask;
+    if ((old & kFresh) == 0) return false;
+    m_skipped.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // reader side
+  bool HasNew() const {
+    return (m_middle.load(std::memory_order_acquire) & kFresh) != 0;
+  }
+
+  // moves the newest item to the read buffer; returns false (and leaves
+  // the read buffer alone) if nothing was published since the last Take
+  bool Take() {
+    if (!HasNew()) return false;
+    uint8_t old = m_middle.exchange(m_read, std::memory_order_acq_rel);
+    m_read = old & kIndexMask;
+    return true;
+  }
+
+  T& GetReadBuffer() { return m_buffers[m_read]; }
+
+  // items replaced before the reader took them
+  uint64_t GetSkipped() const {
+    return m_skipped.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kFresh = 0x4;
+
+  T m_buffers[3];
+  uint8_t m_write = 0;               // writer only
+  uint8_t m_read = 1;                // reader only
+  std::atomic<uint8_t> m_middle{2};  // index, plus kFresh if unread
+  std::atomic<uint64_t> m_skipped{0};
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_LATESTMAILBOX_H_
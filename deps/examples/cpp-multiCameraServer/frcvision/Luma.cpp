@@ -0,0 +1,86 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "Luma.h"
+
+#include <stdint.h>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+using namespace frcvision;
+
+namespace {
+
+// BT.601 weights in 15 bit fixed point, as used by cv::cvtColor
+constexpr int kShift = 15;
+constexpr uint32_t kB = 3735;
+constexpr uint32_t kG = 19235;
+constexpr uint32_t kR = 9798;
+
+}  // namespace
+
+void frcvision::ExtractLumaYUYV(const cv::Mat& yuyv, cv::Mat& gray) {
+  CV_Assert(yuyv.type() == CV_8UC2);
+  gray.create(yuyv.rows, yuyv.cols, CV_8UC1);
+  int width = yuyv.cols;
+  for (int y = 0; y < yuyv.rows; ++y) {
+    const uint8_t* src = yuyv.ptr<uint8_t>(y);
+    uint8_t* dst = gray.ptr<uint8_t>(y);
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    for (; x <= width - lanes; x += lanes) {
+      cv::v_uint8 luma, chroma;
+      cv::v_load_deinterleave(src + 2 * x, luma, chroma);
+      cv::v_store(dst + x, luma);
+    }
+#endif
+    for (; x < width; ++x) dst[x] = src[2 * x];
+  }
+}
+
+void frcvision::BgrToGray(const cv::Mat& bgr, cv::Mat& gray) {
+  CV_Assert(bgr.type() == CV_8UC3);
+  gray.create(bgr.rows, bgr.cols, CV_8UC1);
+  int width = bgr.cols;
+  for (int y = 0; y < bgr.rows; ++y) {
+    const uint8_t* src = bgr.ptr<uint8_t>(y);
+    uint8_t* dst = gray.ptr<uint8_t>(y);
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    const cv::v_uint32 vb = cv::vx_setall_u32(kB);
+    const cv::v_uint32 vg = cv::vx_setall_u32(kG);
+    const cv::v_uint32 vr = cv::vx_setall_u32(kR);
+    const cv::v_uint32 round = cv::vx_setall_u32(1 << (kShift - 1));
+    // weighted sum of one quarter of the lanes, widened to 32 bits
+    auto weigh = [&](const cv::v_uint32& b, const cv::v_uint32& g,
+                     const cv::v_uint32& r) {
+      return (b * vb + g * vg + r * vr + round) >> kShift;
+    };
+    for (; x <= width - lanes; x += lanes) {
+      cv::v_uint8 b8, g8, r8;
+      cv::v_load_deinterleave(src + 3 * x, b8, g8, r8);
+      cv::v_uint16 b16[2], g16[2], r16[2];
+      cv::v_expand(b8, b16[0], b16[1]);
+      cv::v_expand(g8, g16[0], g16[1]);
+      cv::v_expand(r8, r16[0], r16[1]);
+      cv::v_uint16 y16[2];
+      for (int i = 0; i < 2; ++i) {
+        cv::v_uint32 b[2], g[2], r[2];
+        cv::v_expand(b16[i], b[0], b[1]);
+        cv::v_expand(g16[i], g[0], g[1]);
+        cv::v_expand(r16[i], r[0], r[1]);
+        y16[i] = cv::v_pack(weigh(b[0], g[0], r[0]), weigh(b[1], g[1], r[1]));
+      }
+      cv::v_store(dst + x, cv::v_pack(y16[0], y16[1]));
+    }
+#endif
+    for (; x < width; ++x) {
+      const uint8_t* p = src + 3 * x;
+      dst[x] = (p[0] * kB + p[1] * kG + p[2] * kR + (1 << (kShift - 1))) >>
+               kShift;
+    }
+  }
+}
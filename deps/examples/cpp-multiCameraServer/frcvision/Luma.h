@@ -0,0 +1,26 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_LUMA_H_
+#define FRCVISION_LUMA_H_
+
+#include <opencv2/core/core.hpp>
+
+namespace frcvision {
+
+/*
+   Grayscale conversions for pipelines that only need luminance.  Both use
+   OpenCV's universal intrinsics, so they vectorize with NEON on the rPi and
+   SSE/AVX on a desktop, and both match cv::cvtColor bit for bit.
+ */
+
+// copies the Y samples out of a CV_8UC2 YUYV image (COLOR_YUV2GRAY_YUYV)
+void ExtractLumaYUYV(const cv::Mat& yuyv, cv::Mat& gray);
+
+// CV_8UC3 BGR to CV_8UC1 luma (COLOR_BGR2GRAY)
+void BgrToGray(const cv::Mat& bgr, cv::Mat& gray);
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_LUMA_H_
@@ -0,0 +1,69 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "Overlay.h"
+
+#include <algorithm>
+#include <string>
+
+#include <opencv2/imgproc.hpp>
+
+#include "cameraserver/CameraServer.h"
+
+using namespace frcvision;
+
+OverlayOutput::OverlayOutput(std::string_view name, int fps)
+    : m_source{name, cs::VideoMode::kMJPEG, 0, 0, fps},
+      m_period{1000000u / static_cast<unsigned int>(std::max(fps, 1))} {
+  m_server = frc::CameraServer::StartAutomaticCapture(m_source);
+}
+
+bool OverlayOutput::IsDue(uint64_t time) const {
+  // the source is only enabled while a stream client is connected;
+  // allow a quarter period of early arrival so camera jitter doesn't make
+  // the cap skip an extra frame
+  return m_source.IsEnabled() && time + m_period / 4 >= m_next;
+}
+
+void OverlayOutput::PutFrame(cv::Mat& frame, uint64_t time,
+                             const DrawFunc& draw) {
+  cv::Mat* canvas = &frame;
+  if (frame.channels() == 1) {
+    cv::cvtColor(frame, m_canvas, cv::COLOR_GRAY2BGR);
+    canvas = &m_canvas;
+  }
+  draw(*canvas);
+  m_source.PutFrame(*canvas);
+
+  // advance by whole periods to keep the average rate at the cap, but
+  // don't build up a backlog after an idle period
+  m_next = std::max(m_next + m_period, time);
+}
+
+static int LineWidth(const cv::Mat& image) {
+  return std::max(1, image.cols / 320);
+}
+
+void frcvision::DrawBox(cv::Mat& image, const cv::Rect& box,
+                        const cv::Scalar& color) {
+  cv::rectangle(image, box, color, LineWidth(image));
+}
+
+void frcvision::DrawContours(
+    cv::Mat& image, const std::vector<std::vector<cv::Point>>& contours,
+    const cv::Scalar& color) {
+  cv::drawContours(image, contours, -1, color, LineWidth(image));
+}
+
+void frcvision::DrawLabel(cv::Mat& image, std::string_view text,
+                          cv::Point origin, const cv::Scalar& color) {
+  double scale = std::max(0.35, image.cols / 640.0);
+  int thickness = LineWidth(image);
+  std::string str{text};
+  // dark outline so the text is readable on any background
+  cv::putText(image, str, origin, cv::FONT_HERSHEY_SIMPLEX, scale,
+              cv::Scalar{0, 0, 0}, thickness + 2, cv::LINE_AA);
+  cv::putText(image, str, origin, cv::FONT_HERSHEY_SIMPLEX, scale, color,
+              thickness, cv::LINE_AA);
+}
@@ -0,0 +1,74 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_OVERLAY_H_
+#define FRCVISION_OVERLAY_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include <cscore.h>
+#include <cscore_cv.h>
+#include <opencv2/core/core.hpp>
+
+namespace frcvision {
+
+/*
+   Annotated output stream: pipeline results drawn onto the frame the
+   pipeline processed, served as a normal camera stream.
+
+   Frames are only produced when a client is connected and the frame rate
+   cap allows it, so an unwatched overlay costs nothing.  Color frames are
+   drawn on in place; there is no copy beyond the one cscore makes when the
+   frame is handed to the stream.  Gray frames are converted to BGR into a
+   reused buffer first so annotations can be drawn in color.
+ */
+class OverlayOutput {
+ public:
+  using DrawFunc = std::function<void(cv::Mat&)>;
+
+  // starts an MJPEG server for the stream, like a camera
+  OverlayOutput(std::string_view name, int fps);
+
+  OverlayOutput(const OverlayOutput&) = delete;
+  OverlayOutput& operator=(const OverlayOutput&) = delete;
+
+  // true if a frame with the given frame time (wpi::Now() base) should be
+  // drawn and sent: a client is watching and the frame rate cap allows it
+  bool IsDue(uint64_t time) const;
+
+  // calls draw on frame (or a BGR copy if it is gray) and sends the result;
+  // frame is modified in place
+  void PutFrame(cv::Mat& frame, uint64_t time, const DrawFunc& draw);
+
+  cs::CvSource GetSource() const { return m_source; }
+  cs::MjpegServer GetServer() const { return m_server; }
+
+ private:
+  cs::CvSource m_source;
+  cs::MjpegServer m_server;
+  cv::Mat m_canvas;
+  uint64_t m_period;
+  uint64_t m_next = 0;
+};
+
+/*
+   Drawing helpers with a consistent look across pipelines.  Line widths and
+   text size scale with the image so annotations remain readable on both
+   reduced-size and full-size frames.
+ */
+void DrawBox(cv::Mat& image, const cv::Rect& box,
+             const cv::Scalar& color = {0, 255, 0});
+void DrawContours(cv::Mat& image,
+                  const std::vector<std::vector<cv::Point>>& contours,
+                  const cv::Scalar& color = {0, 255, 0});
+void DrawLabel(cv::Mat& image, std::string_view text, cv::Point origin,
+               const cv::Scalar& color = {255, 255, 255});
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_OVERLAY_H_
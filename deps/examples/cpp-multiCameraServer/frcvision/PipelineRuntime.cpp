@@ -0,0 +1,229 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "PipelineRuntime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#include <fmt/format.h>
+#include <opencv2/imgproc.hpp>
+
+using namespace frcvision;
+
+PipelineRuntime::Camera::Camera(cs::VideoSource source)
+    : source{source},
+      sink{fmt::format("pipelines {}", source.GetName()), 0, 0} {
+  sink.SetSource(source);
+}
+
+PipelineRuntime::PipelineRuntime(nt::NetworkTableInstance inst,
+                                 const TimeSync& timeSync, int threads)
+    : m_inst{inst}, m_timeSync{timeSync}, m_pool{threads} {
+  InstallMatAllocationCounter();
+  Profiler::GetInstance().Start();
+}
+
+PipelineRuntime::~PipelineRuntime() {
+  m_active = false;
+  for (auto&& camera : m_cameras) {
+    if (camera->feeder.joinable()) camera->feeder.join();
+  }
+}
+
+void PipelineRuntime::AddType(std::string_view type, Factory factory) {
+  m_types.insert_or_assign(std::string{type}, std::move(factory));
+}
+
+bool PipelineRuntime::Attach(cs::VideoSource source,
+                             const PipelineSettings& settings,
+                             OverlayOutput* overlay) {
+  auto it = m_types.find(settings.type);
+  if (it == m_types.end()) return false;
+
+  auto slot = std::make_unique<Slot>(settings);
+  slot->pipeline = it->second(settings, m_pool);
+  if (!slot->pipeline) return false;
+  slot->overlay = overlay;
+  slot->skippedPub =
+      m_inst
+          .GetIntegerTopic(fmt::format(
+              "/multiCameraServer/pipelines/{}/skippedFrames", settings.name))
+          .Publish();
+  slot->skippedPub.Set(0);
+  slot->allocationsPub =
+      m_inst
+          .GetIntegerTopic(fmt::format(
+              "/multiCameraServer/pipelines/{}/allocations", settings.name))
+          .Publish();
+  if (settings.fps > 0) {
+    slot->period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / settings.fps));
+  }
+
+  // a frame's budget is the time until the pipeline gets the next one
+  auto& profiler = Profiler::GetInstance();
+  double fps = source.GetVideoMode().fps;
+  if (settings.fps > 0 && (fps <= 0 || settings.fps < fps)) fps = settings.fps;
+  profiler.SetPipeline(settings.name, source.GetName(),
+                       fps > 0 ? 1000 / fps : 0);
+  slot->frameProbe = profiler.GetProbe(settings.name, "frame");
+  slot->copyProbe = profiler.GetProbe(settings.name, "copy");
+
+  // pipelines on the same camera share its frames
+  Camera* camera = nullptr;
+  for (auto&& c : m_cameras) {
+    if (c->source == source) camera = c.get();
+  }
+  bool start = !camera;
+  if (start)
+    camera = m_cameras.emplace_back(std::make_unique<Camera>(source)).get();
+  {
+    std::scoped_lock lock{camera->slotsMutex};
+    camera->slots.emplace_back(slot.get());
+  }
+  m_slots.emplace_back(std::move(slot));
+  if (start)
+    camera->feeder = std::thread([this, camera] { FeedThreadMain(*camera); });
+  return true;
+}
+
+void PipelineRuntime::FeedThreadMain(Camera& camera) {
+  while (m_active) {
+    auto pyramid = AcquirePyramid(camera);
+    uint64_t time = camera.sink.GrabRawFrame(pyramid->Reset());
+    if (time == 0) {
+      fmt::print(stderr, "pipelines on '{}': {}\n", camera.source.GetName(),
+                 camera.sink.GetError());
+      continue;
+    }
+
+    auto now = Clock::now();
+    std::scoped_lock lock{camera.slotsMutex};
+    camera.due.clear();
+    for (Slot* slot : camera.slots) {
+      if (slot->period != Clock::duration::zero()) {
+        // allow a quarter period early so camera jitter doesn't halve the
+        // rate; whole periods keep the average, and skip ahead after a
+        // stall
+        if (now + slot->period / 4 < slot->next) continue;
+        slot->next = std::max(slot->next + slot->period, now);
+      }
+      camera.due.emplace_back(slot);
+    }
+    if (camera.due.empty()) continue;
+
+    // decode once, at the finest size any of the pipelines needs
+    int base = FramePyramid::kMaxLevels;
+    bool gray = true;
+    for (Slot* slot : camera.due) {
+      base = std::min(base, pyramid->ChooseLevel(slot->settings.size));
+      gray = gray && slot->settings.gray;
+    }
+    pyramid->SetBase(base, gray);
+
+    for (Slot* slot : camera.due) {
+      auto& buf = slot->mailbox.GetWriteBuffer();
+      buf.pyramid = pyramid;
+      buf.time = time;
+      slot->mailbox.Publish();
+      // drop our hold on a frame the pipeline never took
+      slot->mailbox.GetWriteBuffer().pyramid.reset();
+      Schedule(*slot);
+    }
+  }
+
+  // don't return while a pool task still refers to the slots
+  std::scoped_lock lock{camera.slotsMutex};
+  for (Slot* slot : camera.slots) {
+    while (slot->scheduled)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+PipelineRuntime::PyramidPtr PipelineRuntime::AcquirePyramid(Camera& camera) {
+  std::unique_ptr<FramePyramid> pyramid;
+  {
+    std::scoped_lock lock{camera.freeMutex};
+    if (!camera.free.empty()) {
+      pyramid = std::move(camera.free.back());
+      camera.free.pop_back();
+    }
+  }
+  if (!pyramid) pyramid = std::make_unique<FramePyramid>();
+
+  // back to the camera, buffers and all, when the last pipeline is done
+  return {pyramid.release(), [&camera](FramePyramid* p) {
+            std::scoped_lock lock{camera.freeMutex};
+            camera.free.emplace_back(p);
+          }};
+}
+
+void PipelineRuntime::Schedule(Slot& slot) {
+  // pairs with the fence in RunFrame: either the task sees the new frame or
+  // we see that it finished and queue another
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (slot.scheduled.exchange(true)) return;
+  m_pool.Submit(slot.settings.priority, [this, &slot] { RunFrame(slot); });
+}
+
+void PipelineRuntime::RunFrame(Slot& slot) {
+  if (slot.mailbox.Take()) {
+    auto& buf = slot.mailbox.GetReadBuffer();
+    uint64_t allocations = GetThreadMatAllocations();
+    std::optional<ProfileScope> frameScope{std::in_place, slot.frameProbe};
+    bool copied;
+    {
+      ProfileScope scope{slot.copyProbe};
+      copied = CopyLevel(slot, *buf.pyramid);
+    }
+    if (copied) {
+      slot.pipeline->m_pyramid = buf.pyramid.get();
+      slot.pipeline->Process(slot.image, m_timeSync.GetFrameTime(buf.time));
+      slot.pipeline->m_pyramid = nullptr;
+      if (slot.overlay && slot.overlay->IsDue(buf.time)) {
+        slot.overlay->PutFrame(slot.image, buf.time, [&](cv::Mat& image) {
+          slot.pipeline->Draw(image);
+        });
+      }
+    }
+    frameScope.reset();
+    // the last of the camera's pipelines to finish recycles the frame
+    buf.pyramid.reset();
+
+    // only counts this thread, not chunks the pipeline ran on other workers
+    int64_t frameAllocations = GetThreadMatAllocations() - allocations;
+    if (frameAllocations != slot.lastAllocations) {
+      slot.allocationsPub.Set(frameAllocations);
+      slot.lastAllocations = frameAllocations;
+    }
+
+    uint64_t skipped = slot.mailbox.GetSkipped();
+    if (skipped != slot.lastSkipped) {
+      slot.skippedPub.Set(skipped);
+      slot.lastSkipped = skipped;
+    }
+  }
+
+  // one frame per task, so other cameras' frames are interleaved by
+  // priority; requeue if a newer frame arrived meanwhile
+  slot.scheduled = false;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (slot.mailbox.HasNew()) Schedule(slot);
+}
+
+bool PipelineRuntime::CopyLevel(Slot& slot, FramePyramid& pyramid) {
+  const auto& size = slot.settings.size;
+  const cv::Mat& level =
+      pyramid.GetLevel(pyramid.ChooseLevel(size), slot.settings.gray);
+  if (level.empty()) return false;
+
+  // a private copy: the pipeline and the overlay may draw on it
+  if (size.empty() || level.size() == size)
+    level.copyTo(slot.image);
+  else
+    cv::resize(level, slot.image, size, 0, 0, cv::INTER_AREA);
+  return true;
+}
@@ -0,0 +1,194 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_PIPELINERUNTIME_H_
+#define FRCVISION_PIPELINERUNTIME_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <cscore_raw.h>
+#include <networktables/IntegerTopic.h>
+#include <networktables/NetworkTableInstance.h>
+#include <opencv2/core/core.hpp>
+#include <wpi/json.h>
+
+#include "FramePool.h"
+#include "FramePyramid.h"
+#include "LatestMailbox.h"
+#include "Overlay.h"
+#include "Profiler.h"
+#include "ScaledSink.h"
+#include "TimeSync.h"
+#include "WorkPool.h"
+
+namespace frcvision {
+
+/*
+   Pipeline run by PipelineRuntime.  Process is called on a pool thread
+   for each frame, never concurrently for the same pipeline; it can spread
+   its own work over spare cores with WorkPool::ParallelFor.
+ */
+class CameraPipeline {
+ public:
+  virtual ~CameraPipeline() = default;
+
+  virtual void Process(cv::Mat& image, const FrameTime& time) = 0;
+
+  // draws results for the camera's overlay stream, after Process
+  virtual void Draw(cv::Mat& image) {}
+
+ protected:
+  // the frame being processed at other sizes, shared read-only with the
+  // camera's other pipelines; only valid during Process
+  FramePyramid& GetPyramid() const { return *m_pyramid; }
+
+ private:
+  friend class PipelineRuntime;
+  friend class ReplayCameraPipeline;
+  FramePyramid* m_pyramid = nullptr;
+};
+
+struct PipelineSettings {
+  std::string name;    // used for results, e.g. /vision/<name>
+  std::string type;    // registered pipeline type
+  std::string camera;  // camera name
+  int priority = 0;    // higher priority frames are processed first
+  double fps = 0;      // maximum processing rate, 0 for every frame
+  cv::Size size;       // processing size, 0x0 for camera resolution
+  bool gray = false;   // process luminance only
+  wpi::json config;    // pipeline specific settings
+};
+
+/*
+   Runs any number of pipelines, each attached to a camera, on one shared
+   WorkPool sized to the core count.
+
+   Each camera has a feeder thread that only waits for raw frames (cscore
+   delivers frames to a blocking sink) and never waits for a pipeline.
+   Every frame goes into a FramePyramid that is handed to each of the
+   camera's pipelines through its LatestMailbox, and decoding and
+   processing run as a pool task per pipeline at the camera's priority, so
+   a slow pipeline always gets the newest complete frame instead of
+   falling behind.  Frames replaced before the pipeline got to them are
+   published to /multiCameraServer/pipelines/<name>/skippedFrames.  Frames
+   arriving faster than the pipeline's fps target are dropped by the
+   feeder and not counted as skipped.
+
+   The pyramid decodes the frame once per size for all pipelines: each
+   pipeline gets a private copy of the coarsest level that covers its
+   "size" (resized if it isn't exact), and can read other levels through
+   GetPyramid().  Pyramids are recycled, buffers and all, once the last
+   pipeline on the camera is done with the frame.
+
+   The runtime installs the cv::Mat allocation counter (see FramePool.h)
+   and publishes the buffers allocated on the pool thread for the latest
+   frame to /multiCameraServer/pipelines/<name>/allocations, which should
+   settle at 0 once the pipeline's buffers are pooled or reused.
+
+   It also starts the Profiler, registers each pipeline with its camera's
+   frame budget, and times every frame ("frame", from taking it to the
+   end of Draw) and the copy out of the pyramid ("copy"); pipelines add
+   probes for their own stages.
+ */
+class PipelineRuntime {
+ public:
+  using Factory = std::function<std::unique_ptr<CameraPipeline>(
+      const PipelineSettings& settings, WorkPool& pool)>;
+
+  // threads <= 0 uses one thread per core
+  PipelineRuntime(nt::NetworkTableInstance inst, const TimeSync& timeSync,
+                  int threads = 0);
+  ~PipelineRuntime();
+
+  PipelineRuntime(const PipelineRuntime&) = delete;
+  PipelineRuntime& operator=(const PipelineRuntime&) = delete;
+
+  void AddType(std::string_view type, Factory factory);
+
+  // creates a pipeline of settings.type and starts processing frames from
+  // source; if overlay is given, the pipeline draws on it (the overlay must
+  // outlive the runtime).  Returns false if the type is not registered.
+  bool Attach(cs::VideoSource source, const PipelineSettings& settings,
+              OverlayOutput* overlay = nullptr);
+
+  WorkPool& GetPool() { return m_pool; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  using PyramidPtr = std::shared_ptr<FramePyramid>;
+
+  struct TimedFrame {
+    PyramidPtr pyramid;
+    uint64_t time = 0;
+  };
+
+  struct Slot {
+    explicit Slot(const PipelineSettings& settings) : settings{settings} {}
+
+    PipelineSettings settings;
+    std::unique_ptr<CameraPipeline> pipeline;
+    OverlayOutput* overlay = nullptr;
+    LatestMailbox<TimedFrame> mailbox;
+    std::atomic_bool scheduled{false};  // a pool task is queued or running
+
+    // feeder only
+    Clock::duration period{0};
+    Clock::time_point next;
+
+    // pool task only
+    cv::Mat image;
+    int frameProbe = -1;
+    int copyProbe = -1;
+    uint64_t lastSkipped = 0;
+    nt::IntegerPublisher skippedPub;
+    int64_t lastAllocations = -1;
+    nt::IntegerPublisher allocationsPub;
+  };
+
+  // frames of one camera, grabbed once for all its pipelines
+  struct Camera {
+    explicit Camera(cs::VideoSource source);
+
+    cs::VideoSource source;
+    ScaledSink sink;
+    std::mutex slotsMutex;
+    std::vector<Slot*> slots;
+    std::vector<Slot*> due;  // feeder only: slots getting the current frame
+    std::mutex freeMutex;
+    std::vector<std::unique_ptr<FramePyramid>> free;  // recycled pyramids
+    std::thread feeder;
+  };
+
+  void FeedThreadMain(Camera& camera);
+  PyramidPtr AcquirePyramid(Camera& camera);
+  void Schedule(Slot& slot);
+  void RunFrame(Slot& slot);
+  bool CopyLevel(Slot& slot, FramePyramid& pyramid);
+
+  nt::NetworkTableInstance m_inst;
+  const TimeSync& m_timeSync;
+  std::map<std::string, Factory, std::less<>> m_types;
+  // cameras before slots, as released frames go back to their camera
+  std::vector<std::unique_ptr<Camera>> m_cameras;
+  std::vector<std::unique_ptr<Slot>> m_slots;
+  std::atomic_bool m_active{true};
+
+  // declared last so workers are joined before the slots are destroyed
+  WorkPool m_pool;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_PIPELINERUNTIME_H_
@@ -0,0 +1,243 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "Profiler.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+using namespace frcvision;
+
+namespace {
+
+// bucket 0 starts the first octave at 2^10 ns, about 1 us
+constexpr int kFirstOctave = 10;
+constexpr int kSubBits = 2;  // log2(kSubBuckets)
+
+// hundredths of a millisecond are plenty for the dashboard
+double Round(double value) {
+  return std::round(value * 100) / 100;
+}
+
+}  // namespace
+
+int LatencyHistogram::GetBucket(std::chrono::nanoseconds duration) {
+  uint64_t ns = duration.count() > 0 ? duration.count() : 0;
+  int octave = std::bit_width(ns) - 1;
+  if (octave < kFirstOctave) return 0;
+  int bucket = (octave - kFirstOctave) * kSubBuckets +
+               static_cast<int>((ns >> (octave - kSubBits)) &
+                                (kSubBuckets - 1));
+  return std::min(bucket, kBuckets - 1);
+}
+
+double LatencyHistogram::GetBucketLimitMs(int bucket) {
+  if (bucket >= kBuckets - 1) bucket = kBuckets - 2;  // open ended
+  int octave = kFirstOctave + bucket / kSubBuckets;
+  uint64_t ns = static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets + 1)
+                << (octave - kSubBits);
+  return ns / 1e6;
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds duration) {
+  Increment(m_counts[GetBucket(duration)], 1);
+  Increment(m_sumNs, duration.count() > 0 ? duration.count() : 0);
+  // publishes the bucket with the count (see Read)
+  m_count.store(m_count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+}
+
+void LatencyHistogram::Read(Snapshot& snapshot) const {
+  // the count is read first, so it never exceeds the buckets' sum
+  snapshot.count = m_count.load(std::memory_order_acquire);
+  snapshot.sumNs = m_sumNs.load(std::memory_order_relaxed);
+  for (int i = 0; i < kBuckets; ++i)
+    snapshot.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot& LatencyHistogram::Snapshot::operator-=(
+    const Snapshot& other) {
+  for (int i = 0; i < kBuckets; ++i) counts[i] -= other.counts[i];
+  count -= other.count;
+  sumNs -= other.sumNs;
+  return *this;
+}
+
+LatencyHistogram::Snapshot& LatencyHistogram::Snapshot::operator+=(
+    const Snapshot& other) {
+  for (int i = 0; i < kBuckets; ++i) counts[i] += other.counts[i];
+  count += other.count;
+  sumNs += other.sumNs;
+  return *this;
+}
+
+double LatencyHistogram::Snapshot::GetMeanMs() const {
+  return count == 0 ? 0 : sumNs / 1e6 / count;
+}
+
+double LatencyHistogram::Snapshot::GetPercentileMs(double fraction) const {
+  if (count == 0) return 0;
+  uint64_t rank = std::max<uint64_t>(std::ceil(fraction * count), 1);
+  uint64_t seen = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) return GetBucketLimitMs(i);
+  }
+  return GetBucketLimitMs(kBuckets - 1);
+}
+
+Profiler& Profiler::GetInstance() {
+  // never destroyed, so threads can still record during exit
+  static Profiler* instance = new Profiler;
+  return *instance;
+}
+
+int Profiler::GetProbe(std::string_view pipeline, std::string_view stage) {
+  std::scoped_lock lock{m_mutex};
+  for (size_t i = 0; i < m_probes.size(); ++i) {
+    if (m_probes[i].pipeline == pipeline && m_probes[i].stage == stage)
+      return i;
+  }
+  if (m_probes.size() >= kMaxProbes) return -1;
+  m_probes.push_back({std::string{pipeline}, std::string{stage}});
+  return m_probes.size() - 1;
+}
+
+void Profiler::SetPipeline(std::string_view pipeline, std::string_view camera,
+                           double budgetMs) {
+  std::scoped_lock lock{m_mutex};
+  for (auto&& info : m_pipelines) {
+    if (info.name == pipeline) {
+      info.camera = camera;
+      info.budgetMs = budgetMs;
+      return;
+    }
+  }
+  m_pipelines.push_back(
+      {std::string{pipeline}, std::string{camera}, budgetMs});
+}
+
+Profiler::ThreadData& Profiler::GetThreadData() {
+  thread_local ThreadData* data = nullptr;
+  if (!data) {
+    std::scoped_lock lock{m_mutex};
+    data = m_threads.emplace_back(std::make_unique<ThreadData>()).get();
+  }
+  return *data;
+}
+
+void Profiler::Record(int probe, std::chrono::nanoseconds duration) {
+  if (probe < 0 || probe >= kMaxProbes) return;
+  ThreadData& data = GetThreadData();
+  ProbeData* probeData = data.probes[probe].load(std::memory_order_relaxed);
+  if (!probeData) {
+    // first use of the probe on this thread
+    probeData = data.owned.emplace_back(std::make_unique<ProbeData>()).get();
+    data.probes[probe].store(probeData, std::memory_order_release);
+  }
+  probeData->histogram.Record(duration);
+}
+
+void Profiler::Start() {
+  std::call_once(m_started, [this] {
+    std::thread([this] { ThreadMain(); }).detach();
+  });
+}
+
+wpi::json Profiler::Summarize(double seconds) {
+  std::scoped_lock lock{m_mutex};
+
+  // every probe's samples since the last summary, over all threads
+  std::vector<LatencyHistogram::Snapshot> totals(m_probes.size());
+  LatencyHistogram::Snapshot now;
+  for (auto&& thread : m_threads) {
+    for (size_t i = 0; i < m_probes.size(); ++i) {
+      ProbeData* probeData = thread->probes[i].load(std::memory_order_acquire);
+      if (!probeData) continue;
+      probeData->histogram.Read(now);
+      LatencyHistogram::Snapshot delta = now;
+      delta -= probeData->last;
+      probeData->last = now;
+      totals[i] += delta;
+    }
+  }
+
+  wpi::json cameras = wpi::json::array();
+  auto getCamera = [&](std::string_view name) -> wpi::json& {
+    for (auto&& camera : cameras) {
+      if (camera["name"].get<std::string>() == name) return camera;
+    }
+    return cameras.emplace_back(
+        wpi::json{{"name", name}, {"pipelines", wpi::json::array()}});
+  };
+  // each pipeline has its own budget, as an fps limit lengthens it
+  auto addPipeline = [&](std::string_view name, std::string_view camera,
+                         double budgetMs) {
+    wpi::json pipeline = {{"name", name},
+                          {"budgetMs", Round(budgetMs)},
+                          {"fps", 0},
+                          {"stages", wpi::json::array()}};
+    for (size_t i = 0; i < m_probes.size(); ++i) {
+      const auto& total = totals[i];
+      if (m_probes[i].pipeline != name) continue;
+      if (m_probes[i].stage == "frame" && seconds > 0)
+        pipeline["fps"] = Round(total.count / seconds);
+      if (total.count == 0) continue;
+      pipeline["stages"].emplace_back(
+          wpi::json{{"name", m_probes[i].stage},
+                    {"count", total.count},
+                    {"meanMs", Round(total.GetMeanMs())},
+                    {"p50Ms", Round(total.GetPercentileMs(0.5))},
+                    {"p90Ms", Round(total.GetPercentileMs(0.9))},
+                    {"p99Ms", Round(total.GetPercentileMs(0.99))},
+                    {"maxMs", Round(total.GetPercentileMs(1))}});
+    }
+    getCamera(camera)["pipelines"].emplace_back(std::move(pipeline));
+  };
+
+  for (auto&& info : m_pipelines)
+    addPipeline(info.name, info.camera, info.budgetMs);
+
+  // probes of pipelines the runtime doesn't know about, once each
+  for (size_t i = 0; i < m_probes.size(); ++i) {
+    const auto& name = m_probes[i].pipeline;
+    bool listed = false;
+    for (auto&& info : m_pipelines) listed = listed || info.name == name;
+    for (size_t j = 0; j < i; ++j)
+      listed = listed || m_probes[j].pipeline == name;
+    if (!listed) addPipeline(name, "", 0);
+  }
+
+  return {{"type", "visionProfile"}, {"cameras", std::move(cameras)}};
+}
+
+void Profiler::ThreadMain() {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(kTelemetryPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  auto last = std::chrono::steady_clock::now();
+  Summarize(0);  // start the first interval now
+  for (;;) {
+    std::this_thread::sleep_until(last + std::chrono::seconds{1});
+    auto now = std::chrono::steady_clock::now();
+    auto summary =
+        Summarize(std::chrono::duration<double>(now - last).count());
+    last = now;
+
+    if (fd < 0) continue;
+    auto str = summary.dump();
+    sendto(fd, str.data(), str.size(), 0,
+           reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+  }
+}
@@ -0,0 +1,174 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_PROFILER_H_
+#define FRCVISION_PROFILER_H_
+
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <wpi/json.h>
+
+namespace frcvision {
+
+/*
+   Duration histogram with 4 log-spaced buckets per octave from 1 us to
+   about 1 s (each bucket spans 25% or less), written by one thread and
+   read by any other without locks.  Counts only ever increase; a reader
+   takes the difference of two snapshots for an interval.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBuckets = 4;
+  static constexpr int kBuckets = 20 * kSubBuckets + 1;  // last: >= 1 s
+
+  struct Snapshot {
+    std::array<uint64_t, kBuckets> counts{};
+    uint64_t count = 0;
+    uint64_t sumNs = 0;
+
+    Snapshot& operator-=(const Snapshot& other);
+    Snapshot& operator+=(const Snapshot& other);
+
+    double GetMeanMs() const;
+    // upper bound of the bucket holding the given fraction of samples
+    double GetPercentileMs(double fraction) const;
+  };
+
+  // the owning thread only
+  void Record(std::chrono::nanoseconds duration);
+
+  void Read(Snapshot& snapshot) const;
+
+  static int GetBucket(std::chrono::nanoseconds duration);
+  static double GetBucketLimitMs(int bucket);
+
+ private:
+  // single writer: plain load and store, no read-modify-write needed
+  static void Increment(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<uint64_t>, kBuckets> m_counts{};
+  std::atomic<uint64_t> m_count{0};
+  std::atomic<uint64_t> m_sumNs{0};
+};
+
+/*
+   Collects stage timings from pipeline threads and sends a summary every
+   second to configServer, which shows it on the Vision Status page.
+
+   A probe names one stage of one pipeline; get it once (e.g. in the
+   pipeline's constructor) and time a scope with it:
+
+       m_thresholdProbe = Profiler::GetInstance().GetProbe(name, "threshold");
+       ...
+       { ProfileScope scope{m_thresholdProbe}; Threshold(image, mask); }
+
+   Each thread records into its own histograms, so a probe costs two clock
+   reads and a few uncontended stores, with no locks or shared cache
+   lines.  The reporter sums the threads' histograms over the last second.
+
+   PipelineRuntime registers every pipeline with its camera and frame
+   budget (the camera's frame period, or the pipeline's fps limit), and
+   times the whole frame as the "frame" stage; its rate is the pipeline's
+   fps.  The summary is a "visionProfile" JSON message on the vision
+   telemetry port (UDP 6667 on localhost):
+
+       {"type": "visionProfile", "cameras": [{"name", "pipelines":
+        [{"name", "budgetMs", "fps", "stages": [{"name", "count",
+        "meanMs", "p50Ms", "p90Ms", "p99Ms", "maxMs"}]}]}]}
+
+   Pipelines that were not registered are listed under an unnamed camera.
+ */
+class Profiler {
+ public:
+  static constexpr int kMaxProbes = 128;
+  static constexpr int kTelemetryPort = 6667;
+
+  static Profiler& GetInstance();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  // the same pipeline and stage always give the same probe; -1 once
+  // kMaxProbes are in use (recording -1 does nothing)
+  int GetProbe(std::string_view pipeline, std::string_view stage);
+
+  // the camera a pipeline runs on and its time per frame
+  void SetPipeline(std::string_view pipeline, std::string_view camera,
+                   double budgetMs);
+
+  void Record(int probe, std::chrono::nanoseconds duration);
+
+  // starts sending summaries; later calls do nothing
+  void Start();
+
+  // the summary over the interval since the previous call
+  wpi::json Summarize(double seconds);
+
+ private:
+  Profiler() = default;
+
+  struct ProbeData {
+    LatencyHistogram histogram;
+    LatencyHistogram::Snapshot last;  // reporter only: at the last summary
+  };
+
+  struct ThreadData {
+    std::array<std::atomic<ProbeData*>, kMaxProbes> probes{};
+    std::vector<std::unique_ptr<ProbeData>> owned;  // thread only
+  };
+
+  struct Probe {
+    std::string pipeline;
+    std::string stage;
+  };
+
+  struct PipelineInfo {
+    std::string name;
+    std::string camera;
+    double budgetMs = 0;
+  };
+
+  ThreadData& GetThreadData();
+  void ThreadMain();
+
+  std::mutex m_mutex;
+  std::vector<Probe> m_probes;
+  std::vector<PipelineInfo> m_pipelines;
+  std::vector<std::unique_ptr<ThreadData>> m_threads;
+  std::once_flag m_started;
+};
+
+/* times the enclosing scope into a probe */
+class ProfileScope {
+ public:
+  explicit ProfileScope(int probe)
+      : m_probe{probe}, m_start{std::chrono::steady_clock::now()} {}
+  ~ProfileScope() {
+    Profiler::GetInstance().Record(
+        m_probe, std::chrono::steady_clock::now() - m_start);
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  int m_probe;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_PROFILER_H_
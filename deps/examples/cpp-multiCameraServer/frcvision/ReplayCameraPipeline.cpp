@@ -0,0 +1,37 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "ReplayCameraPipeline.h"
+
+#include <wpi/timestamp.h>
+
+using namespace frcvision;
+
+ReplayCameraPipeline::ReplayCameraPipeline(CameraPipeline& pipeline)
+    : m_pipeline{pipeline}, m_start{static_cast<int64_t>(wpi::Now())} {}
+
+ReplayCameraPipeline::~ReplayCameraPipeline() {
+  // the pixels are m_frame's, not the raw frame's to free
+  m_pyramid.Reset().data = nullptr;
+}
+
+void ReplayCameraPipeline::Process(cv::Mat& image, double time) {
+  // the pyramid keeps its own copy, as the pipeline may draw on image
+  image.copyTo(m_frame);
+  wpi::RawFrame& frame = m_pyramid.Reset();
+  frame.data = reinterpret_cast<char*>(m_frame.data);
+  frame.size = m_frame.total() * m_frame.elemSize();
+  frame.pixelFormat = m_frame.channels() == 1 ? cs::VideoMode::kGray
+                                              : cs::VideoMode::kBGR;
+  frame.width = m_frame.cols;
+  frame.height = m_frame.rows;
+  frame.stride = m_frame.step;
+  m_pyramid.SetBase(0, m_frame.channels() == 1);
+
+  FrameTime frameTime;
+  frameTime.local = m_start + static_cast<int64_t>(time * 1e6);
+  m_pipeline.m_pyramid = &m_pyramid;
+  m_pipeline.Process(image, frameTime);
+  m_pipeline.m_pyramid = nullptr;
+}
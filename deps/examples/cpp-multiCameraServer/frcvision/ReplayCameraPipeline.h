@@ -0,0 +1,53 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_REPLAYCAMERAPIPELINE_H_
+#define FRCVISION_REPLAYCAMERAPIPELINE_H_
+
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+#include "FramePyramid.h"
+#include "PipelineRuntime.h"
+
+namespace frcvision {
+
+/*
+   Runs a CameraPipeline in ReplayRunner, the way PipelineRuntime runs it
+   on a camera:
+
+       TargetPipeline pipeline{settings, inst, pool};
+       ReplayCameraPipeline replay{pipeline};
+       ReplayRunner<ReplayCameraPipeline> runner{reader, &replay, listener};
+
+   Each recorded frame becomes the base of a FramePyramid, so GetPyramid()
+   works during Process as it does live (GetYUYV() is empty, as recordings
+   are decoded to BGR), and the FrameTime follows the recorded timestamps:
+   local is wpi::Now() when the adapter was created plus the frame's time
+   in the recording, and server is 0 (not synchronized).  Time based
+   stages such as RoiTracker therefore see the recorded frame rate, not
+   the replay's.
+ */
+class ReplayCameraPipeline {
+ public:
+  explicit ReplayCameraPipeline(CameraPipeline& pipeline);
+  ~ReplayCameraPipeline();
+
+  ReplayCameraPipeline(const ReplayCameraPipeline&) = delete;
+  ReplayCameraPipeline& operator=(const ReplayCameraPipeline&) = delete;
+
+  // time is seconds from the first recorded frame (ReplayRunner's)
+  void Process(cv::Mat& image, double time);
+
+ private:
+  CameraPipeline& m_pipeline;
+  int64_t m_start;  // local time of the recording's first frame
+  FramePyramid m_pyramid;
+  cv::Mat m_frame;  // what the pyramid's raw frame points to
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_REPLAYCAMERAPIPELINE_H_
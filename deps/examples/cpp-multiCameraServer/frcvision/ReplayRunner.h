@@ -0,0 +1,211 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_REPLAYRUNNER_H_
+#define FRCVISION_REPLAYRUNNER_H_
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <fmt/format.h>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <wpi/fs.h>
+#include <wpi/json.h>
+#include <wpi/raw_ostream.h>
+
+#include "FrameReader.h"
+#include "Profiler.h"
+
+namespace frcvision {
+
+struct ReplayOptions {
+  // wait until each frame's time, and like a live camera, skip the frames
+  // that arrived while the pipeline was busy; otherwise as fast as possible
+  bool realTime = false;
+  int loops = 1;
+  cv::Size size;        // resize frames to the pipeline's size, if given
+  bool gray = false;    // give the pipeline luminance only
+  std::string results;  // per-frame results file (JSON lines), if given
+};
+
+struct ReplayStats {
+  int frames = 0;      // processed
+  int skipped = 0;     // real time only: replaced while the pipeline was busy
+  double seconds = 0;  // wall time
+  LatencyHistogram::Snapshot process;  // Process and the listener
+  LatencyHistogram::Snapshot latency;  // real time only: frame time to result
+};
+
+/*
+   Runs an frc::VisionPipeline on recorded frames (see FrameReader), the
+   same way frc::VisionRunner and TimedVisionRunner run it on a camera, to
+   time it and to compare its results between versions.  A pipeline whose
+   Process also takes the frame's time in seconds, such as
+   ReplayCameraPipeline for a CameraPipeline, gets the recorded time.
+
+   The listener is called after each frame's Process, as with VisionRunner;
+   what it returns is written to the results file, one line per frame:
+
+       {"frame": <image file or video frame>, "time": <s>, "results": ...}
+
+   Frames are decoded (and resized) outside of the timed Process, so the
+   process times are the pipeline's alone; ReplayStats::seconds includes
+   decoding.  In real time the frame clock is paused while a frame is
+   decoded, so decoding neither adds to the latency nor makes frames due
+   that a camera would not have delivered yet.
+ */
+template <typename Pipeline>
+class ReplayRunner {
+ public:
+  using Listener = std::function<wpi::json(Pipeline&)>;
+
+  ReplayRunner(FrameReader& reader, Pipeline* pipeline, Listener listener)
+      : m_reader{reader},
+        m_pipeline{pipeline},
+        m_listener{std::move(listener)} {}
+
+  bool Run(const ReplayOptions& options, ReplayStats& stats,
+           std::string& error) {
+    std::optional<wpi::raw_fd_ostream> results;
+    if (!options.results.empty()) {
+      std::error_code ec;
+      results.emplace(options.results, ec, fs::F_Text);
+      if (ec) {
+        error = fmt::format("could not write '{}': {}", options.results,
+                            ec.message());
+        return false;
+      }
+    }
+
+    m_options = options;
+    m_loop = 0;
+    m_loopFrames = 0;
+    m_offset = 0;
+    m_lastTime = 0;
+    m_reader.Rewind();
+    LatencyHistogram process;
+    LatencyHistogram latency;
+    stats = {};
+    auto begin = Clock::now();
+    m_start = begin;
+
+    // read one frame ahead, to know whether a newer one is already due
+    Frame frame;
+    Frame next;
+    bool have = ReadFrameUntimed(frame);
+    while (have) {
+      bool haveNext = ReadFrameUntimed(next);
+      if (options.realTime) {
+        if (haveNext && GetDue(next) <= Clock::now()) {
+          ++stats.skipped;
+          std::swap(frame, next);
+          continue;
+        }
+        std::this_thread::sleep_until(GetDue(frame));
+      }
+
+      auto start = Clock::now();
+      if constexpr (requires { m_pipeline->Process(frame.image, 0.0); })
+        m_pipeline->Process(frame.image, frame.time);
+      else
+        m_pipeline->Process(frame.image);
+      wpi::json result = m_listener ? m_listener(*m_pipeline) : wpi::json{};
+      auto end = Clock::now();
+      process.Record(end - start);
+      if (options.realTime) latency.Record(end - GetDue(frame));
+      ++stats.frames;
+
+      if (results) {
+        wpi::json line = {{"frame", frame.name},
+                          {"time", frame.time},
+                          {"results", std::move(result)}};
+        line.dump(*results);
+        *results << '\n';
+      }
+
+      std::swap(frame, next);
+      have = haveNext;
+    }
+
+    stats.seconds =
+        std::chrono::duration<double>(Clock::now() - begin).count();
+    process.Read(stats.process);
+    latency.Read(stats.latency);
+    return true;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Frame {
+    cv::Mat image;
+    std::string name;
+    double time = 0;  // seconds from the first frame of the first loop
+  };
+
+  // ReadFrame with the frame clock moved on by the time it took
+  bool ReadFrameUntimed(Frame& frame) {
+    auto start = Clock::now();
+    bool rv = ReadFrame(frame);
+    m_start += Clock::now() - start;
+    return rv;
+  }
+
+  bool ReadFrame(Frame& frame) {
+    double time;
+    while (!m_reader.Read(m_raw, time)) {
+      if (++m_loop >= m_options.loops || m_loopFrames == 0) return false;
+      // the next loop starts a frame period after this one ended
+      double period = m_loopFrames > 1
+                          ? (m_lastTime - m_offset) / (m_loopFrames - 1)
+                          : 1 / m_reader.GetFps();
+      m_offset = m_lastTime + period;
+      m_loopFrames = 0;
+      m_reader.Rewind();
+    }
+    ++m_loopFrames;
+    frame.time = m_offset + time;
+    m_lastTime = frame.time;
+    frame.name = m_reader.GetName();
+
+    // a fresh image per frame: the pipeline may draw on it
+    const cv::Mat* src = &m_raw;
+    if (!m_options.size.empty() && m_raw.size() != m_options.size) {
+      cv::resize(m_raw, m_resized, m_options.size, 0, 0, cv::INTER_AREA);
+      src = &m_resized;
+    }
+    if (m_options.gray)
+      cv::cvtColor(*src, frame.image, cv::COLOR_BGR2GRAY);
+    else
+      src->copyTo(frame.image);
+    return true;
+  }
+
+  Clock::time_point GetDue(const Frame& frame) const {
+    return m_start + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(frame.time));
+  }
+
+  FrameReader& m_reader;
+  Pipeline* m_pipeline;
+  Listener m_listener;
+  ReplayOptions m_options;
+  Clock::time_point m_start;  // frame clock zero, moved on while decoding
+  cv::Mat m_raw;
+  cv::Mat m_resized;
+  int m_loop = 0;
+  int m_loopFrames = 0;
+  double m_offset = 0;
+  double m_lastTime = 0;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_REPLAYRUNNER_H_
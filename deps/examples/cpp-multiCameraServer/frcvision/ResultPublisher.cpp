@@ -0,0 +1,48 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "ResultPublisher.h"
+
+using namespace frcvision;
+
+ResultPublisher::ResultPublisher(nt::NetworkTableInstance inst,
+                                 std::string_view topic)
+    : m_inst{inst},
+      m_pub{inst.GetStructArrayTopic<Target>(topic).Publish()},
+      m_thread{[this] { ThreadMain(); }} {}
+
+ResultPublisher::~ResultPublisher() {
+  m_active = false;
+  m_published.fetch_add(1, std::memory_order_release);
+  m_published.notify_one();
+  m_thread.join();
+}
+
+void ResultPublisher::Publish(std::span<const Target> targets,
+                              const FrameTime& time) {
+  // the vector keeps its capacity, so this stops allocating once the
+  // largest target count has been seen in each of the three buffers
+  Batch& batch = m_mailbox.GetWriteBuffer();
+  batch.targets.assign(targets.begin(), targets.end());
+  batch.time = time.local;
+  m_mailbox.Publish();
+  m_published.fetch_add(1, std::memory_order_release);
+  m_published.notify_one();
+}
+
+void ResultPublisher::ThreadMain() {
+  uint32_t seen = 0;
+  for (;;) {
+    m_published.wait(seen, std::memory_order_acquire);
+    seen = m_published.load(std::memory_order_acquire);
+    if (!m_active) break;
+    if (!m_mailbox.Take()) continue;
+
+    // the capture time as the NT timestamp, then out right away rather
+    // than at the next periodic flush
+    const Batch& batch = m_mailbox.GetReadBuffer();
+    m_pub.Set(batch.targets, batch.time);
+    m_inst.Flush();
+  }
+}
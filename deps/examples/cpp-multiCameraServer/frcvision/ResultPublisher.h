@@ -0,0 +1,104 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_RESULTPUBLISHER_H_
+#define FRCVISION_RESULTPUBLISHER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <networktables/NetworkTableInstance.h>
+#include <networktables/StructArrayTopic.h>
+#include <wpi/struct/Struct.h>
+
+#include "LatestMailbox.h"
+#include "TimeSync.h"
+
+namespace frcvision {
+
+/* One target found in a frame, in pixels of the processed image */
+struct Target {
+  double x = 0;  // center
+  double y = 0;
+  double width = 0;
+  double height = 0;
+  double area = 0;
+};
+
+/*
+   Publishes a frame's whole target list as a single NT4 struct array
+   (schema "VisionTarget"), so robot code always gets the targets of one
+   frame together instead of fields from different frames, and the NT
+   timestamp of the value is the frame capture time.
+
+   Publish only copies the targets into a LatestMailbox and wakes the
+   publisher thread, which sets the value and flushes it to the network
+   right away; the pipeline never waits on a lock or on NetworkTables.  If
+   the publisher thread falls behind, only the newest frame's targets are
+   sent.  Publish must not be called concurrently, which holds for a
+   CameraPipeline's Process.
+ */
+class ResultPublisher {
+ public:
+  ResultPublisher(nt::NetworkTableInstance inst, std::string_view topic);
+  ~ResultPublisher();
+
+  ResultPublisher(const ResultPublisher&) = delete;
+  ResultPublisher& operator=(const ResultPublisher&) = delete;
+
+  void Publish(std::span<const Target> targets, const FrameTime& time);
+
+  // frames whose targets were replaced before they were sent
+  uint64_t GetSkipped() const { return m_mailbox.GetSkipped(); }
+
+ private:
+  struct Batch {
+    std::vector<Target> targets;
+    int64_t time = 0;
+  };
+
+  void ThreadMain();
+
+  nt::NetworkTableInstance m_inst;
+  nt::StructArrayPublisher<Target> m_pub;
+  LatestMailbox<Batch> m_mailbox;
+  std::atomic<uint32_t> m_published{0};  // bumped on every Publish
+  std::atomic_bool m_active{true};
+  std::thread m_thread;
+};
+
+}  // namespace frcvision
+
+template <>
+struct wpi::Struct<frcvision::Target> {
+  static constexpr std::string_view GetTypeString() {
+    return "struct:VisionTarget";
+  }
+  static constexpr size_t GetSize() { return 40; }
+  static constexpr std::string_view GetSchema() {
+    return "double x;double y;double width;double height;double area";
+  }
+
+  static frcvision::Target Unpack(std::span<const uint8_t> data) {
+    return {wpi::UnpackStruct<double, 0>(data),
+            wpi::UnpackStruct<double, 8>(data),
+            wpi::UnpackStruct<double, 16>(data),
+            wpi::UnpackStruct<double, 24>(data),
+            wpi::UnpackStruct<double, 32>(data)};
+  }
+  static void Pack(std::span<uint8_t> data, const frcvision::Target& value) {
+    wpi::PackStruct<0>(data, value.x);
+    wpi::PackStruct<8>(data, value.y);
+    wpi::PackStruct<16>(data, value.width);
+    wpi::PackStruct<24>(data, value.height);
+    wpi::PackStruct<32>(data, value.area);
+  }
+};
+
+#endif  // FRCVISION_RESULTPUBLISHER_H_
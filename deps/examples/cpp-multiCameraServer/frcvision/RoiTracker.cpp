@@ -0,0 +1,139 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "RoiTracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <fmt/format.h>
+
+using namespace frcvision;
+
+namespace {
+
+// alpha-beta gains: fairly responsive, still smoothing detection jitter
+constexpr double kAlpha = 0.8;
+constexpr double kBeta = 0.4;
+constexpr double kSizeGain = 0.5;
+
+constexpr int64_t kStatsPeriod = 1000000;
+
+}  // namespace
+
+RoiTracker::RoiTracker(const RoiSettings& settings) : m_settings{settings} {}
+
+void RoiTracker::Publish(nt::NetworkTableInstance inst,
+                         std::string_view name) {
+  auto prefix = fmt::format("/multiCameraServer/pipelines/{}/roi/", name);
+  m_hitRatePub = inst.GetDoubleTopic(prefix + "hitRate").Publish();
+  m_savedPub = inst.GetDoubleTopic(prefix + "savedMs").Publish();
+}
+
+cv::Rect RoiTracker::Begin(cv::Size frame, int64_t time) {
+  if (frame != m_frame) {
+    // new resolution: the tracked box and full frame time are stale
+    m_frame = frame;
+    m_fullUs = 0;
+    Reset();
+  }
+  m_time = time;
+  m_window = cv::Rect{{0, 0}, frame};
+
+  if (m_tracking && m_fullUs > 0) {
+    double dt = static_cast<double>(time - m_lastTime);
+    cv::Point2d center = m_center + m_velocity * dt;
+    double grow = std::ldexp(1.0, m_misses);
+    double halfWidth = std::max(
+        (m_size.width / 2 + m_settings.margin * m_size.width) * grow,
+        m_settings.minSize / 2.0);
+    double halfHeight = std::max(
+        (m_size.height / 2 + m_settings.margin * m_size.height) * grow,
+        m_settings.minSize / 2.0);
+    cv::Rect window{cv::Point{cvFloor(center.x - halfWidth),
+                              cvFloor(center.y - halfHeight)},
+                    cv::Point{cvCeil(center.x + halfWidth),
+                              cvCeil(center.y + halfHeight)}};
+    window &= m_window;
+    if (window.empty())
+      Reset();  // predicted out of the frame
+    else
+      m_window = window;
+  }
+
+  m_start = std::chrono::steady_clock::now();
+  return m_window;
+}
+
+void RoiTracker::End(const std::optional<cv::Rect2d>& target) {
+  double elapsed = std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - m_start)
+                       .count();
+  bool full = m_window.size() == m_frame;
+
+  // statistics
+  if (m_windowStart == 0 || m_time < m_windowStart) m_windowStart = m_time;
+  ++m_frames;
+  if (full) {
+    m_fullUs = m_fullUs == 0 ? elapsed : 0.9 * m_fullUs + 0.1 * elapsed;
+  } else {
+    ++m_roiFrames;
+    if (target) ++m_hits;
+    m_saved += std::max(m_fullUs - elapsed, 0.0);
+  }
+  if (m_time - m_windowStart >= kStatsPeriod) {
+    m_hitRate = m_roiFrames == 0 ? 0 : static_cast<double>(m_hits) /
+                                           m_roiFrames;
+    m_savedUs = m_saved / m_frames;
+    if (m_hitRatePub) {
+      m_hitRatePub.Set(m_hitRate);
+      m_savedPub.Set(m_savedUs / 1000);
+    }
+    m_windowStart = m_time;
+    m_frames = m_roiFrames = m_hits = 0;
+    m_saved = 0;
+  }
+
+  // tracking
+  if (!target) {
+    if (m_tracking && ++m_misses >= m_settings.maxMisses) Reset();
+    return;
+  }
+  cv::Point2d center{target->x + target->width / 2,
+                     target->y + target->height / 2};
+  cv::Size2d size = target->size();
+  if (!m_tracking) {
+    m_tracking = true;
+    m_center = center;
+    m_velocity = {0, 0};
+    m_size = size;
+  } else {
+    double dt = static_cast<double>(std::max<int64_t>(m_time - m_lastTime, 1));
+    cv::Point2d predicted = m_center + m_velocity * dt;
+    cv::Point2d residual = center - predicted;
+    m_center = predicted + kAlpha * residual;
+    m_velocity += (kBeta / dt) * residual;
+
+    // a box touching a window edge inside the frame may be cut off
+    cv::Rect box{cv::Point{cvFloor(target->x), cvFloor(target->y)},
+                 cv::Point{cvCeil(target->br().x), cvCeil(target->br().y)}};
+    bool clipped =
+        (box.x <= m_window.x && m_window.x > 0) ||
+        (box.y <= m_window.y && m_window.y > 0) ||
+        (box.br().x >= m_window.br().x && m_window.br().x < m_frame.width) ||
+        (box.br().y >= m_window.br().y && m_window.br().y < m_frame.height);
+    if (clipped) {
+      size.width = std::max(size.width, m_size.width);
+      size.height = std::max(size.height, m_size.height);
+    }
+    m_size += (size - m_size) * kSizeGain;
+  }
+  m_lastTime = m_time;
+  m_misses = 0;
+}
+
+void RoiTracker::Reset() {
+  m_tracking = false;
+  m_misses = 0;
+}
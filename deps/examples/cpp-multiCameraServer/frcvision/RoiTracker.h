@@ -0,0 +1,145 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_ROITRACKER_H_
+#define FRCVISION_ROITRACKER_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include <networktables/DoubleTopic.h>
+#include <networktables/NetworkTableInstance.h>
+#include <opencv2/core/core.hpp>
+#include <vision/VisionPipeline.h>
+#include <wpi/timestamp.h>
+
+namespace frcvision {
+
+struct RoiSettings {
+  double margin = 1.0;  // border around the predicted box, in target sizes
+  int minSize = 32;     // smallest window side, in pixels
+  int maxMisses = 3;    // consecutive misses before going back to full frame
+};
+
+/*
+   Proposes the region of the next frame to search, so a pipeline that has
+   found its target only processes the area around it.
+
+   The target's center is tracked with a constant velocity (alpha-beta)
+   filter over the frame times, so the window follows a moving target and
+   dropped frames only widen the prediction step.  The window is the
+   predicted box plus a margin on every side; each consecutive miss doubles
+   it, and after maxMisses the next frame is processed whole again.  A box
+   cut off by the window edge does not shrink the tracked size.
+
+   Call Begin for every frame, process the returned window (a submatrix,
+   no copy), then call End with what was found, in frame coordinates.
+   Begin/End also time the processing: the full frame time is averaged
+   whenever the whole frame is processed, and each window frame counts the
+   difference as saved.  Over every second of frame time, the fraction of
+   window frames that found the target and the mean time saved per frame
+   are kept, and published to /multiCameraServer/pipelines/<name>/roi/
+   (hitRate, savedMs) if Publish was called.
+ */
+class RoiTracker {
+ public:
+  explicit RoiTracker(const RoiSettings& settings = {});
+
+  void Publish(nt::NetworkTableInstance inst, std::string_view name);
+
+  // window to process in a frame of the given size captured at time
+  // (microseconds, e.g. FrameTime::local); the whole frame if not tracking
+  cv::Rect Begin(cv::Size frame, int64_t time);
+
+  // the target found in the window, in frame coordinates
+  void End(const std::optional<cv::Rect2d>& target);
+
+  // back to full frames, e.g. when the pipeline's settings change
+  void Reset();
+
+  bool IsTracking() const { return m_tracking; }
+  const cv::Rect& GetWindow() const { return m_window; }
+
+  // over the last completed second; 0 until then
+  double GetHitRate() const { return m_hitRate; }
+  double GetSavedUs() const { return m_savedUs; }
+
+ private:
+  RoiSettings m_settings;
+
+  // filter state, in pixels and microseconds
+  bool m_tracking = false;
+  cv::Point2d m_center;
+  cv::Point2d m_velocity;
+  cv::Size2d m_size;
+  int64_t m_lastTime = 0;
+  int m_misses = 0;
+
+  // current frame
+  cv::Size m_frame;
+  cv::Rect m_window;
+  int64_t m_time = 0;
+  std::chrono::steady_clock::time_point m_start;
+
+  // statistics
+  double m_fullUs = 0;  // average full frame time
+  int64_t m_windowStart = 0;
+  int m_frames = 0;
+  int m_roiFrames = 0;
+  int m_hits = 0;
+  double m_saved = 0;
+  double m_hitRate = 0;
+  double m_savedUs = 0;
+  nt::DoublePublisher m_hitRatePub;
+  nt::DoublePublisher m_savedPub;
+};
+
+/*
+   Runs an frc::VisionPipeline on the tracked window only, so it can be
+   used with frc::VisionRunner or TimedVisionRunner unchanged.  locate
+   returns the target box the pipeline found in the image it was given
+   (window coordinates), or nothing; add GetOffset() to the pipeline's
+   results to get frame coordinates.
+ */
+template <typename Pipeline>
+class RoiVisionPipeline : public frc::VisionPipeline {
+ public:
+  using Locator = std::function<std::optional<cv::Rect2d>(Pipeline&)>;
+
+  RoiVisionPipeline(Pipeline* pipeline, Locator locate,
+                    const RoiSettings& settings = {})
+      : m_pipeline{pipeline},
+        m_locate{std::move(locate)},
+        m_tracker{settings} {}
+
+  void Process(cv::Mat& mat) override {
+    // the frame time isn't passed to VisionPipeline; processing starts
+    // right after the frame is grabbed, so now is close enough for the
+    // velocity estimate
+    cv::Rect window = m_tracker.Begin(mat.size(), wpi::Now());
+    cv::Mat roi = mat(window);
+    m_pipeline->Process(roi);
+    auto target = m_locate(*m_pipeline);
+    if (target) *target += cv::Point2d{window.tl()};
+    m_tracker.End(target);
+  }
+
+  Pipeline& GetPipeline() { return *m_pipeline; }
+  RoiTracker& GetTracker() { return m_tracker; }
+  cv::Point GetOffset() const { return m_tracker.GetWindow().tl(); }
+
+ private:
+  Pipeline* m_pipeline;
+  Locator m_locate;
+  RoiTracker m_tracker;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_ROITRACKER_H_
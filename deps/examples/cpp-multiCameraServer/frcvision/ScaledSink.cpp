@@ -0,0 +1,141 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "ScaledSink.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "Luma.h"
+
+using namespace frcvision;
+
+int frcvision::ChooseJpegScale(int srcWidth, int srcHeight, int width,
+                               int height) {
+  if (width <= 0 || height <= 0) return 1;
+  for (int scale = 8; scale > 1; scale /= 2) {
+    // libjpeg rounds scaled dimensions up
+    if ((srcWidth + scale - 1) / scale >= width &&
+        (srcHeight + scale - 1) / scale >= height)
+      return scale;
+  }
+  return 1;
+}
+
+bool frcvision::DecodeJpeg(std::span<const uint8_t> jpeg, int scale,
+                           bool gray, cv::Mat& out) {
+  int flags;
+  switch (scale) {
+    case 2:
+      flags =
+          gray ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+      break;
+    case 4:
+      flags =
+          gray ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+      break;
+    case 8:
+      flags =
+          gray ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+      break;
+    default:
+      flags = gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+      break;
+  }
+  cv::Mat buf{1, static_cast<int>(jpeg.size()), CV_8UC1,
+              const_cast<uint8_t*>(jpeg.data())};
+  cv::imdecode(buf, flags, &out);
+  return !out.empty();
+}
+
+ScaledSink::ScaledSink(std::string_view name, int width, int height,
+                       cs::VideoMode::PixelFormat pixelFormat)
+    : m_sink{name},
+      m_width{width},
+      m_height{height},
+      m_gray{pixelFormat == cs::VideoMode::kGray} {}
+
+uint64_t ScaledSink::GrabFrame(cv::Mat& image, double timeout) {
+  uint64_t time = GrabRawFrame(m_frame, timeout);
+  if (time == 0 || !ConvertFrame(m_frame, image)) return 0;
+  return time;
+}
+
+uint64_t ScaledSink::GrabRawFrame(wpi::RawFrame& frame, double timeout) {
+  // unknown pixel format gets the source's frame as-is (e.g. MJPEG)
+  frame.pixelFormat = cs::VideoMode::kUnknown;
+  frame.width = 0;
+  frame.height = 0;
+  return m_sink.GrabFrame(frame, timeout);
+}
+
+uint64_t ScaledSink::GrabFrameNoTimeout(cv::Mat& image) {
+  m_frame.pixelFormat = cs::VideoMode::kUnknown;
+  m_frame.width = 0;
+  m_frame.height = 0;
+  uint64_t time = m_sink.GrabFrameNoTimeout(m_frame);
+  if (time == 0 || !ConvertFrame(m_frame, image)) return 0;
+  return time;
+}
+
+bool frcvision::ConvertRawFrame(const wpi::RawFrame& frame, int jpegScale,
+                                bool gray, cv::Mat& out) {
+  int width = frame.width;
+  int height = frame.height;
+  size_t stride = frame.stride;
+  void* data = frame.data;
+
+  switch (frame.pixelFormat) {
+    case cs::VideoMode::kMJPEG:
+      return DecodeJpeg({reinterpret_cast<const uint8_t*>(data), frame.size},
+                        jpegScale, gray, out);
+    case cs::VideoMode::kYUYV: {
+      cv::Mat yuyv{height, width, CV_8UC2, data, stride};
+      if (gray)
+        ExtractLumaYUYV(yuyv, out);
+      else
+        cv::cvtColor(yuyv, out, cv::COLOR_YUV2BGR_YUYV);
+      return true;
+    }
+    case cs::VideoMode::kRGB565:
+      cv::cvtColor(cv::Mat{height, width, CV_8UC2, data, stride}, out,
+                   gray ? cv::COLOR_BGR5652GRAY : cv::COLOR_BGR5652BGR);
+      return true;
+    case cs::VideoMode::kBGR: {
+      cv::Mat bgr{height, width, CV_8UC3, data, stride};
+      if (gray)
+        BgrToGray(bgr, out);
+      else
+        bgr.copyTo(out);
+      return true;
+    }
+    case cs::VideoMode::kGray: {
+      cv::Mat grayFrame{height, width, CV_8UC1, data, stride};
+      if (gray)
+        grayFrame.copyTo(out);
+      else
+        cv::cvtColor(grayFrame, out, cv::COLOR_GRAY2BGR);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool ScaledSink::ConvertFrame(const wpi::RawFrame& frame, cv::Mat& image) {
+  m_scale = frame.pixelFormat == cs::VideoMode::kMJPEG
+                ? ChooseJpegScale(frame.width, frame.height, m_width,
+                                  m_height)
+                : 1;
+  if (!ConvertRawFrame(frame, m_scale, m_gray, m_decoded)) return false;
+
+  if (m_width <= 0 || m_height <= 0 ||
+      (m_decoded.cols == m_width && m_decoded.rows == m_height)) {
+    cv::swap(image, m_decoded);
+  } else {
+    cv::resize(m_decoded, image, cv::Size{m_width, m_height}, 0, 0,
+               cv::INTER_AREA);
+  }
+  return true;
+}
@@ -0,0 +1,94 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_SCALEDSINK_H_
+#define FRCVISION_SCALEDSINK_H_
+
+#include <stdint.h>
+
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <cscore_raw.h>
+#include <opencv2/core/core.hpp>
+
+namespace frcvision {
+
+/*
+   Returns the largest libjpeg IDCT scale denominator (1, 2, 4 or 8) that
+   still produces an image of at least width x height from a srcWidth x
+   srcHeight JPEG.  A width or height of 0 means full size.
+ */
+int ChooseJpegScale(int srcWidth, int srcHeight, int width, int height);
+
+/*
+   Decodes a JPEG at 1/scale size using libjpeg's scaled IDCT (through
+   OpenCV's IMREAD_REDUCED_* modes), which skips most of the work of a full
+   decode.  With gray, only the luma component is decoded; libjpeg skips
+   the chroma IDCT, upsampling and color conversion entirely.  Returns false
+   if the data could not be decoded.
+ */
+bool DecodeJpeg(std::span<const uint8_t> jpeg, int scale, bool gray,
+                cv::Mat& out);
+
+/*
+   Converts a raw frame to BGR (or gray) at camera resolution, except that
+   MJPEG is decoded at 1/jpegScale size.  Returns false if the pixel format
+   is not supported or the frame could not be decoded.
+ */
+bool ConvertRawFrame(const wpi::RawFrame& frame, int jpegScale, bool gray,
+                     cv::Mat& out);
+
+/*
+   Drop-in replacement for cs::CvSink for pipelines that process frames
+   smaller than the camera produces.
+
+   MJPEG frames are decoded with the largest scaled IDCT that still covers
+   the requested size, and only the remaining (at most 2x) reduction is done
+   with cv::resize.  Other pixel formats are converted and resized.  A size
+   of 0x0 delivers frames at camera resolution.
+
+   Like cs::CvSink, frames are delivered as kBGR or kGray.  In kGray the
+   chroma is never converted: MJPEG decodes only the luma component, YUYV
+   has its Y samples extracted and BGR sources use a vectorized conversion
+   (see Luma.h).
+ */
+class ScaledSink {
+ public:
+  ScaledSink() = default;
+  ScaledSink(std::string_view name, int width, int height,
+             cs::VideoMode::PixelFormat pixelFormat = cs::VideoMode::kBGR);
+
+  void SetSource(cs::VideoSource source) { m_sink.SetSource(source); }
+
+  // same return value as cs::CvSink::GrabFrame: frame time, or 0 on error
+  uint64_t GrabFrame(cv::Mat& image, double timeout = 0.225);
+  uint64_t GrabFrameNoTimeout(cv::Mat& image);
+
+  // GrabFrame in two steps, so the (cheap) wait for a frame and the
+  // decode can run on different threads.  One thread may grab into one
+  // frame while another converts a different one, but conversions must not
+  // overlap each other.
+  uint64_t GrabRawFrame(wpi::RawFrame& frame, double timeout = 0.225);
+  bool ConvertFrame(const wpi::RawFrame& frame, cv::Mat& image);
+
+  std::string GetError() const { return m_sink.GetError(); }
+
+  // scale denominator used for the last MJPEG frame (1 if not MJPEG)
+  int GetLastScale() const { return m_scale; }
+
+ private:
+  cs::RawSink m_sink;
+  wpi::RawFrame m_frame;
+  cv::Mat m_decoded;
+  int m_width = 0;
+  int m_height = 0;
+  bool m_gray = false;
+  int m_scale = 1;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_SCALEDSINK_H_
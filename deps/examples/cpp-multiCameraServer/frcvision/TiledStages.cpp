@@ -0,0 +1,121 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "TiledStages.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <opencv2/imgproc.hpp>
+
+using namespace frcvision;
+
+namespace {
+
+// bands are at least this high, so halos stay a small part of the work
+constexpr int kMinBandRows = 16;
+
+}  // namespace
+
+TiledStages::TiledStages(WorkPool& pool, const TileSettings& settings)
+    : m_pool{pool}, m_settings{settings} {}
+
+bool TiledStages::IsTiled(cv::Size size) const {
+  return m_settings.minPixels > 0 &&
+         size.width * size.height >= m_settings.minPixels &&
+         size.height >= 2 * kMinBandRows;
+}
+
+void TiledStages::Threshold(ColorThreshold& threshold, const cv::Mat& image,
+                            BitMask& mask) {
+  if (!IsTiled(image.size())) {
+    threshold.Apply(image, mask);
+    return;
+  }
+  threshold.Prepare(image, mask);
+  ForEachBand(image.size(), [&](int begin, int end) {
+    threshold.ApplyRows(image, mask, begin, end);
+  });
+}
+
+void TiledStages::Erode(const BitMask& src, BitMask& dst, cv::Size kernel) {
+  Morph(src, dst, kernel, true);
+}
+
+void TiledStages::Dilate(const BitMask& src, BitMask& dst, cv::Size kernel) {
+  Morph(src, dst, kernel, false);
+}
+
+void TiledStages::Morph(const BitMask& src, BitMask& dst, cv::Size kernel,
+                        bool erode) {
+  cv::Size size{src.Width(), src.Height()};
+  if (!IsTiled(size)) {
+    if (erode)
+      ErodeMask(src, dst, kernel);
+    else
+      DilateMask(src, dst, kernel);
+    return;
+  }
+  BitMask& out = &dst == &src ? m_mask : dst;
+  out.Create(size.width, size.height);
+  ForEachBand(size, [&](int begin, int end) {
+    if (erode)
+      ErodeMaskRows(src, out, kernel, begin, end);
+    else
+      DilateMaskRows(src, out, kernel, begin, end);
+  });
+  if (&out != &dst) std::swap(dst, m_mask);
+}
+
+void TiledStages::GaussianBlur(const cv::Mat& src, cv::Mat& dst,
+                               cv::Size kernel, double sigma) {
+  if (!IsTiled(src.size())) {
+    cv::GaussianBlur(src, dst, kernel, sigma);
+    return;
+  }
+  CV_Assert(kernel.width % 2 == 1 && kernel.height % 2 == 1);
+  bool inPlace = src.data == dst.data;
+  cv::Mat& out = inPlace ? m_image : dst;
+  out.create(src.size(), src.type());
+  int halo = kernel.height / 2;
+  ForEachBand(src.size(), [&](int begin, int end) {
+    // each band is blurred with its halo as an image of its own: the
+    // halo's rows take the border effects, and at the top and bottom of
+    // the frame the border is the frame's
+    int top = std::max(0, begin - halo);
+    int bottom = std::min(src.rows, end + halo);
+    thread_local cv::Mat blurred;
+    cv::GaussianBlur(src.rowRange(top, bottom), blurred, kernel, sigma, 0,
+                     cv::BORDER_DEFAULT | cv::BORDER_ISOLATED);
+    cv::Mat band = out.rowRange(begin, end);
+    blurred.rowRange(begin - top, end - top).copyTo(band);
+  });
+  if (inPlace) m_image.copyTo(dst);
+}
+
+void TiledStages::CvtColor(const cv::Mat& src, cv::Mat& dst, int code) {
+  if (!IsTiled(src.size())) {
+    cv::cvtColor(src, dst, code);
+    return;
+  }
+  // the output's width and type, from a conversion of the first row
+  thread_local cv::Mat first;
+  cv::cvtColor(src.rowRange(0, 1), first, code);
+  bool inPlace = src.data == dst.data;
+  cv::Mat& out = inPlace ? m_image : dst;
+  out.create(src.rows, first.cols, first.type());
+  ForEachBand(src.size(), [&](int begin, int end) {
+    cv::Mat band = out.rowRange(begin, end);
+    cv::cvtColor(src.rowRange(begin, end), band, code);
+  });
+  if (inPlace) m_image.copyTo(dst);
+}
+
+void TiledStages::ForEachBand(cv::Size size,
+                              const std::function<void(int, int)>& fn) {
+  int bands =
+      m_settings.bands > 0 ? m_settings.bands : m_pool.GetNumThreads();
+  int grain = std::max((size.height + bands - 1) / bands, kMinBandRows);
+  m_pool.ParallelFor(0, size.height, grain, fn);
+}
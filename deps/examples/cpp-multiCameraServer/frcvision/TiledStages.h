@@ -0,0 +1,84 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_TILEDSTAGES_H_
+#define FRCVISION_TILEDSTAGES_H_
+
+#include <functional>
+
+#include <opencv2/core/core.hpp>
+
+#include "BitMask.h"
+#include "ColorThreshold.h"
+#include "WorkPool.h"
+
+namespace frcvision {
+
+struct TileSettings {
+  // frames with at least this many pixels are split; 0 never splits
+  int minPixels = 640 * 480;
+  // bands per frame, 0 for one per pool thread
+  int bands = 0;
+};
+
+/*
+   Pipeline stages that split large frames into bands of rows and process
+   them on the WorkPool at the same time, so a single high resolution
+   camera keeps every core busy instead of one.
+
+   Stages whose output pixels depend on neighboring pixels (morphology and
+   blur) give each band a halo: the rows above and below it that the
+   kernel reaches are read from the source along with the band, so the
+   bands together produce exactly the whole-frame result.  For that the
+   output can't be written over the source while other bands still read
+   it; with dst the same as src, the bands go to a buffer kept by this
+   object, which then takes the place of dst.
+
+   Frames smaller than TileSettings::minPixels (and the region of interest
+   of a pipeline that only searches around its target) are processed on
+   the calling thread, as splitting them costs more than it saves.  Use
+   one TiledStages per pipeline, from its Process only.
+
+   OpenCV may split cvtColor and GaussianBlur over its own threads as
+   well; on a pool that already has a thread per core, bands are cheaper.
+ */
+class TiledStages {
+ public:
+  explicit TiledStages(WorkPool& pool, const TileSettings& settings = {});
+
+  const TileSettings& GetSettings() const { return m_settings; }
+
+  // whether frames of this size are split
+  bool IsTiled(cv::Size size) const;
+
+  // ColorThreshold::Apply into a BitMask
+  void Threshold(ColorThreshold& threshold, const cv::Mat& image,
+                 BitMask& mask);
+
+  // ErodeMask and DilateMask
+  void Erode(const BitMask& src, BitMask& dst, cv::Size kernel);
+  void Dilate(const BitMask& src, BitMask& dst, cv::Size kernel);
+
+  // cv::GaussianBlur with the default border; kernel sides must be odd
+  void GaussianBlur(const cv::Mat& src, cv::Mat& dst, cv::Size kernel,
+                    double sigma);
+
+  // cv::cvtColor for conversions of each pixel on its own, which is all
+  // but the Bayer and planar 4:2:0 ones
+  void CvtColor(const cv::Mat& src, cv::Mat& dst, int code);
+
+ private:
+  // fn(begin, end) for bands covering rows [0, size.height), on the pool
+  void ForEachBand(cv::Size size, const std::function<void(int, int)>& fn);
+  void Morph(const BitMask& src, BitMask& dst, cv::Size kernel, bool erode);
+
+  WorkPool& m_pool;
+  TileSettings m_settings;
+  BitMask m_mask;   // morphology output when dst is src
+  cv::Mat m_image;  // blur output when dst is src
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_TILEDSTAGES_H_
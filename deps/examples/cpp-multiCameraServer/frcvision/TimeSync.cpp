@@ -0,0 +1,99 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "TimeSync.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <fmt/format.h>
+
+using namespace frcvision;
+
+namespace {
+
+// samples kept; ntcore measures roughly every few seconds
+constexpr size_t kWindow = 16;
+
+// offset change that is treated as a server clock reset
+constexpr int64_t kResetThresholdUs = 100000;
+
+}  // namespace
+
+TimeSync::TimeSync(nt::NetworkTableInstance inst) : m_inst{inst} {
+  m_offsetPub =
+      inst.GetIntegerTopic("/multiCameraServer/timeSync/offsetUs").Publish();
+  m_jitterPub =
+      inst.GetIntegerTopic("/multiCameraServer/timeSync/jitterUs").Publish();
+  m_rttPub =
+      inst.GetIntegerTopic("/multiCameraServer/timeSync/rttUs").Publish();
+
+  // the server's clock is the local clock
+  if (inst.GetNetworkMode() & nt::NetworkTableInstance::kNetModeServer) {
+    AddSample(0, 0);
+    return;
+  }
+
+  m_listener = inst.AddTimeSyncListener(
+      true, [this](const nt::Event& event) {
+        auto data = event.GetTimeSyncEventData();
+        if (!data) return;
+        if (data->valid) {
+          AddSample(data->serverTimeOffset, data->rtt2 * 2);
+        } else {
+          // disconnected; keep the last estimate until a new one arrives
+          std::scoped_lock lock{m_mutex};
+          m_samples.clear();
+        }
+      });
+}
+
+TimeSync::~TimeSync() {
+  if (m_listener != 0) m_inst.RemoveListener(m_listener);
+}
+
+std::optional<int64_t> TimeSync::GetOffset() const {
+  if (!m_valid) return std::nullopt;
+  return m_offset.load();
+}
+
+std::optional<int64_t> TimeSync::ToServerTime(int64_t localTime) const {
+  if (!m_valid) return std::nullopt;
+  return localTime + m_offset;
+}
+
+FrameTime TimeSync::GetFrameTime(int64_t captureTime) const {
+  return {captureTime, ToServerTime(captureTime).value_or(0)};
+}
+
+void TimeSync::AddSample(int64_t offset, int64_t rtt) {
+  std::scoped_lock lock{m_mutex};
+
+  if (m_valid && std::llabs(offset - m_offset) > kResetThresholdUs + rtt) {
+    fmt::print("time sync: server clock changed by {} us\n",
+               offset - m_offset);
+    m_samples.clear();
+  }
+  m_samples.push_back({offset, rtt});
+  if (m_samples.size() > kWindow) m_samples.pop_front();
+
+  auto best = std::min_element(
+      m_samples.begin(), m_samples.end(),
+      [](const auto& a, const auto& b) { return a.rtt < b.rtt; });
+
+  double mean = 0;
+  for (auto&& s : m_samples) mean += s.offset;
+  mean /= m_samples.size();
+  double var = 0;
+  for (auto&& s : m_samples) var += (s.offset - mean) * (s.offset - mean);
+  var /= m_samples.size();
+
+  m_offset = best->offset;
+  m_valid = true;
+
+  m_offsetPub.Set(best->offset);
+  m_jitterPub.Set(std::lround(std::sqrt(var)));
+  m_rttPub.Set(best->rtt);
+}
@@ -0,0 +1,80 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_TIMESYNC_H_
+#define FRCVISION_TIMESYNC_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include <networktables/IntegerTopic.h>
+#include <networktables/NetworkTableInstance.h>
+
+namespace frcvision {
+
+/* Capture time of a frame in both time bases, in microseconds */
+struct FrameTime {
+  int64_t local = 0;   // wpi::Now() (monotonic) time on this coprocessor
+  int64_t server = 0;  // NT server (robot) time; 0 if not yet synchronized
+};
+
+/*
+   Continuously estimates the offset between wpi::Now() and the NT server
+   clock from the time sync measurements ntcore makes.
+
+   The offset of the sample with the smallest round trip time in a sliding
+   window is used, since it has the least queueing delay in it.  A step much
+   larger than the round trip time (e.g. the robot rebooted) restarts the
+   window.
+
+   Telemetry is published to /multiCameraServer/timeSync: offsetUs,
+   jitterUs (standard deviation of the offsets in the window) and rttUs.
+ */
+class TimeSync {
+ public:
+  explicit TimeSync(nt::NetworkTableInstance inst);
+  ~TimeSync();
+
+  TimeSync(const TimeSync&) = delete;
+  TimeSync& operator=(const TimeSync&) = delete;
+
+  bool IsSynchronized() const { return m_valid; }
+
+  // server time = local time + offset
+  std::optional<int64_t> GetOffset() const;
+
+  // converts a wpi::Now() time (e.g. a cscore frame time) to server time
+  std::optional<int64_t> ToServerTime(int64_t localTime) const;
+
+  FrameTime GetFrameTime(int64_t captureTime) const;
+
+ private:
+  struct Sample {
+    int64_t offset;
+    int64_t rtt;
+  };
+
+  void AddSample(int64_t offset, int64_t rtt);
+
+  nt::NetworkTableInstance m_inst;
+  NT_Listener m_listener = 0;
+
+  std::mutex m_mutex;
+  std::deque<Sample> m_samples;
+
+  std::atomic<int64_t> m_offset{0};
+  std::atomic_bool m_valid{false};
+
+  nt::IntegerPublisher m_offsetPub;
+  nt::IntegerPublisher m_jitterPub;
+  nt::IntegerPublisher m_rttPub;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_TIMESYNC_H_
@@ -0,0 +1,98 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_TIMEDVISIONRUNNER_H_
+#define FRCVISION_TIMEDVISIONRUNNER_H_
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include <cscore.h>
+#include <fmt/format.h>
+#include <opencv2/core/core.hpp>
+
+#include "Overlay.h"
+#include "ScaledSink.h"
+#include "TimeSync.h"
+
+namespace frcvision {
+
+/*
+   Like frc::VisionRunner, but the listener is also given the capture time
+   of the frame the pipeline just processed, in both the local and the NT
+   server (robot) time base.
+
+   Pass FrameTime::local as the timestamp when publishing results; ntcore
+   translates value timestamps to server time, so robot code sees them in
+   its own time base and can compensate for pipeline latency.
+
+   If the pipeline only needs a smaller image, pass its size and MJPEG
+   frames are decoded directly at reduced size; pass kGray if it only needs
+   luminance (see ScaledSink).
+
+   With SetOverlay, results can be drawn onto the processed frame and served
+   as a separate stream (see OverlayOutput).  Drawing happens after the
+   listener has run, directly on the frame the pipeline was given.
+ */
+template <typename Pipeline>
+class TimedVisionRunner {
+ public:
+  using Listener = std::function<void(Pipeline&, const FrameTime&)>;
+  using Drawer = std::function<void(Pipeline&, cv::Mat&)>;
+
+  TimedVisionRunner(
+      cs::VideoSource source, Pipeline* pipeline, Listener listener,
+      const TimeSync& timeSync, cv::Size size = {},
+      cs::VideoMode::PixelFormat pixelFormat = cs::VideoMode::kBGR)
+      : m_sink{"TimedVisionRunner " + source.GetName(), size.width,
+               size.height, pixelFormat},
+        m_pipeline{pipeline},
+        m_listener{std::move(listener)},
+        m_timeSync{timeSync} {
+    m_sink.SetSource(source);
+  }
+
+  void RunOnce() {
+    // frame time is when cscore received the frame, in wpi::Now() time
+    uint64_t frameTime = m_sink.GrabFrame(m_image);
+    if (frameTime == 0) {
+      fmt::print(stderr, "{}\n", m_sink.GetError());
+      return;
+    }
+    m_pipeline->Process(m_image);
+    m_listener(*m_pipeline, m_timeSync.GetFrameTime(frameTime));
+    if (m_overlay && m_overlay->IsDue(frameTime)) {
+      m_overlay->PutFrame(m_image, frameTime, [&](cv::Mat& image) {
+        m_drawer(*m_pipeline, image);
+      });
+    }
+  }
+
+  // overlay must outlive the runner; pass nullptr to disable
+  void SetOverlay(OverlayOutput* overlay, Drawer drawer) {
+    m_overlay = overlay;
+    m_drawer = std::move(drawer);
+  }
+
+  void RunForever() {
+    while (m_enabled) RunOnce();
+  }
+
+  void Stop() { m_enabled = false; }
+
+ private:
+  ScaledSink m_sink;
+  cv::Mat m_image;
+  Pipeline* m_pipeline;
+  Listener m_listener;
+  const TimeSync& m_timeSync;
+  OverlayOutput* m_overlay = nullptr;
+  Drawer m_drawer;
+  std::atomic_bool m_enabled{true};
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_TIMEDVISIONRUNNER_H_
@@ -0,0 +1,153 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "WorkPool.h"
+
+#include <algorithm>
+
+using namespace frcvision;
+
+namespace {
+
+// worker index of the current thread in its pool, or -1
+thread_local const WorkPool* currentPool = nullptr;
+thread_local int currentWorker = -1;
+
+}  // namespace
+
+WorkPool::WorkPool(int threads) {
+  if (threads <= 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 0; i < threads; ++i)
+    m_workers.emplace_back(std::make_unique<Worker>());
+  // start after all workers exist, as they steal from each other
+  for (int i = 0; i < threads; ++i)
+    m_workers[i]->thread = std::thread([this, i] { WorkerMain(i); });
+}
+
+WorkPool::~WorkPool() {
+  {
+    std::scoped_lock lock{m_mutex};
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  for (auto&& worker : m_workers) worker->thread.join();
+}
+
+void WorkPool::Submit(int priority, Task task) {
+  {
+    std::scoped_lock lock{m_mutex};
+    m_queue.push(Queued{priority, m_seq++, std::move(task)});
+  }
+  m_cv.notify_one();
+}
+
+void WorkPool::ParallelFor(int begin, int end, int grain,
+                           const std::function<void(int, int)>& fn) {
+  if (begin >= end) return;
+  grain = std::max(grain, 1);
+  if (end - begin <= grain) {
+    fn(begin, end);
+    return;
+  }
+
+  // chunks go on this worker's deque, or spread over the workers when
+  // called from outside the pool
+  int self = currentPool == this ? currentWorker : -1;
+  std::atomic<int> remaining{(end - begin + grain - 1) / grain - 1};
+  for (int b = begin + grain; b < end; b += grain) {
+    int e = std::min(b + grain, end);
+    int index = self >= 0 ? self : m_nextWorker++ % m_workers.size();
+    Push(index, [&fn, &remaining, b, e] {
+      fn(b, e);
+      remaining.fetch_sub(1, std::memory_order_release);
+    });
+  }
+  Notify();
+
+  // do the first chunk here, then help with chunks (never new frames)
+  // until the rest are done
+  fn(begin, std::min(begin + grain, end));
+  while (remaining.load(std::memory_order_acquire) > 0) {
+    if (!RunLocal(self)) std::this_thread::yield();
+  }
+}
+
+void WorkPool::WorkerMain(int index) {
+  currentPool = this;
+  currentWorker = index;
+  for (;;) {
+    if (RunLocal(index) || RunQueued()) continue;
+
+    std::unique_lock lock{m_mutex};
+    m_cv.wait(lock, [&] {
+      return m_stop || !m_queue.empty() ||
+             m_localCount.load(std::memory_order_relaxed) > 0;
+    });
+    if (m_stop) return;
+  }
+}
+
+void WorkPool::Push(int index, Task task) {
+  auto& worker = *m_workers[index];
+  {
+    std::scoped_lock lock{worker.mutex};
+    worker.tasks.emplace_back(std::move(task));
+    m_localCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool WorkPool::RunLocal(int index) {
+  if (m_localCount.load(std::memory_order_relaxed) == 0) return false;
+
+  Task task;
+  // newest from our own deque keeps the working set in cache
+  if (index >= 0) {
+    auto& worker = *m_workers[index];
+    std::scoped_lock lock{worker.mutex};
+    if (!worker.tasks.empty()) {
+      task = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+      m_localCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+  // otherwise steal the oldest from another worker
+  if (!task) {
+    size_t n = m_workers.size();
+    size_t start = index >= 0 ? index + 1 : 0;
+    for (size_t i = 0; i < n && !task; ++i) {
+      auto& victim = *m_workers[(start + i) % n];
+      std::scoped_lock lock{victim.mutex};
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        m_localCount.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  if (!task) return false;
+
+  task();
+  return true;
+}
+
+bool WorkPool::RunQueued() {
+  Task task;
+  {
+    std::scoped_lock lock{m_mutex};
+    if (m_queue.empty()) return false;
+    // priority_queue::top is const; the task is moved out before pop
+    task = std::move(const_cast<Queued&>(m_queue.top()).task);
+    m_queue.pop();
+  }
+  task();
+  return true;
+}
+
+void WorkPool::Notify() {
+  // take the lock so a worker between its checks and its wait can't miss
+  // the wakeup
+  { std::scoped_lock lock{m_mutex}; }
+  m_cv.notify_all();
+}
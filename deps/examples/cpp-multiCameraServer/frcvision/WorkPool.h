@@ -0,0 +1,92 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef FRCVISION_WORKPOOL_H_
+#define FRCVISION_WORKPOOL_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace frcvision {
+
+/*
+   Work-stealing thread pool shared by all pipelines.
+
+   Top-level tasks (one per camera frame) are submitted with a priority and
+   wait in a shared queue, highest priority first and FIFO within a
+   priority.  A pipeline can split its own work with ParallelFor; those
+   chunks go on the calling worker's local deque, where the owner takes the
+   newest and idle workers steal the oldest.  Workers always finish
+   outstanding chunks before starting another frame, so a heavy pipeline
+   spreads over spare cores without delaying higher priority frames behind
+   whole frames of lower priority work.
+ */
+class WorkPool {
+ public:
+  using Task = std::function<void()>;
+
+  // threads <= 0 uses one thread per core
+  explicit WorkPool(int threads = 0);
+  ~WorkPool();
+
+  WorkPool(const WorkPool&) = delete;
+  WorkPool& operator=(const WorkPool&) = delete;
+
+  int GetNumThreads() const { return static_cast<int>(m_workers.size()); }
+
+  // queues a top-level task; higher priorities run first
+  void Submit(int priority, Task task);
+
+  // runs fn(chunkBegin, chunkEnd) over [begin, end) in chunks of at most
+  // grain, on the calling thread and any idle workers; returns when all
+  // chunks are done.  May be called from inside a task or from any thread.
+  void ParallelFor(int begin, int end, int grain,
+                   const std::function<void(int, int)>& fn);
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  struct Queued {
+    int priority;
+    uint64_t seq;
+    Task task;
+    bool operator<(const Queued& rhs) const {
+      if (priority != rhs.priority) return priority < rhs.priority;
+      return seq > rhs.seq;
+    }
+  };
+
+  void WorkerMain(int index);
+  void Push(int index, Task task);
+  bool RunLocal(int index);
+  bool RunQueued();
+  void Notify();
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::atomic<int> m_localCount{0};  // chunks waiting in worker deques
+  std::atomic<unsigned int> m_nextWorker{0};
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::priority_queue<Queued> m_queue;
+  uint64_t m_seq = 0;
+  bool m_stop = false;
+};
+
+}  // namespace frcvision
+
+#endif  // FRCVISION_WORKPOOL_H_
@@ -3,6 +3,7 @@
 // the WPILib BSD license file in the root directory of this project.
 
 #include <cstdio>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -10,13 +11,15 @@
 
 #include <fmt/format.h>
 #include <networktables/NetworkTableInstance.h>
-#include <vision/VisionPipeline.h>
-#include <vision/VisionRunner.h>
 #include <wpi/StringExtras.h>
 #include <wpi/json.h>
 #include <wpi/raw_istream.h>
 
+#include "TargetPipeline.h"
 #include "cameraserver/CameraServer.h"
+#include "frcvision/Overlay.h"
+#include "frcvision/PipelineRuntime.h"
+#include "frcvision/TimeSync.h"
 
 /*
    JSON format:
@@ -31,6 +34,7 @@
                "width": <video mode width>              // optional
                "height": <video mode height>            // optional
                "fps": <video mode fps>                  // optional
+               "priority": <processing priority, default 0> // optional
                "brightness": <percentage brightness>    // optional
                "white balance": <"auto", "hold", value> // optional
                "exposure": <"auto", "hold", value>      // optional
@@ -48,6 +52,13 @@
                        }
                    ]
                }
+               "overlay": {                             // optional
+                   "name": <stream name>    // "<camera name> overlay"
+                   "fps": <maximum frame rate>          // 15 if unspecified
+                   "stream": {                          // optional
+                       "properties": [ ... ]            // as above
+                   }
+               }
            }
        ]
        "switched cameras": [
@@ -58,7 +69,35 @@
                // if NT value is a double, it's treated as an integer index
            }
        ]
+       "pipelines": [                                   // optional
+           {
+               "type": <pipeline type registered in main()>
+               "camera": <name of camera to process>
+               "name": <name for results, type if unspecified>
+               "fps": <maximum processing rate>         // optional
+               "width": <processing width>              // optional
+               "height": <processing height>            // optional
+               "gray": <true to process luminance only> // optional
+               "config": <pipeline specific settings>   // optional
+           }
+       ]
    }
+
+   The built-in multiCameraServer reads "plugin" and "stages" entries under
+   the same "pipelines" key; the forms are described together at the top
+   of its multiCameraServer.cpp.
+
+   Every pipeline runs on one shared pool with a thread per core; frames of
+   higher priority cameras are processed first.  Without "pipelines", the
+   example pipeline runs on the first camera.
+
+   Results are published with the frame capture time as the NT timestamp,
+   which robot code sees in its own (NT server) time base; the estimated
+   clock offset is published to /multiCameraServer/timeSync.
+
+   If a processed camera has an "overlay", the results of the first
+   pipeline on it are drawn on the processed frames and served as an
+   additional stream.
  */
 
 static const char* configFile = "/boot/frc.json";
@@ -73,6 +112,11 @@ struct CameraConfig {
   std::string path;
   wpi::json config;
   wpi::json streamConfig;
+  bool overlay = false;
+  std::string overlayName;
+  int overlayFps = 15;
+  wpi::json overlayStreamConfig;
+  int priority = 0;
 };
 
 struct SwitchedCameraConfig {
@@ -82,7 +126,9 @@ struct SwitchedCameraConfig {
 
 std::vector<CameraConfig> cameraConfigs;
 std::vector<SwitchedCameraConfig> switchedCameraConfigs;
+std::vector<frcvision::PipelineSettings> pipelineConfigs;
 std::vector<cs::VideoSource> cameras;
+std::vector<std::unique_ptr<frcvision::OverlayOutput>> overlays;
 
 void ParseErrorV(fmt::string_view format, fmt::format_args args) {
   fmt::print(stderr, "config error in '{}': ", configFile);
@@ -117,6 +163,34 @@ bool ReadCameraConfig(const wpi::json& config) {
   // stream properties
   if (config.count("stream") != 0) c.streamConfig = config.at("stream");
 
+  // processing priority (optional)
+  try {
+    c.priority = config.value("priority", 0);
+  } catch (const wpi::json::exception& e) {
+    ParseError("camera '{}': could not read priority: {}", c.name, e.what());
+    return false;
+  }
+
+  // overlay output (optional)
+  if (config.count("overlay") != 0) {
+    try {
+      const auto& overlay = config.at("overlay");
+      c.overlay = true;
+      c.overlayName = overlay.value("name", c.name + " overlay");
+      c.overlayFps = overlay.value("fps", 15);
+      if (overlay.count("stream") != 0)
+        c.overlayStreamConfig = overlay.at("stream");
+    } catch (const wpi::json::exception& e) {
+      ParseError("camera '{}': could not read overlay: {}", c.name,
+                 e.what());
+      return false;
+    }
+    if (c.overlayFps <= 0) {
+      ParseError("camera '{}': overlay fps must be positive", c.name);
+      return false;
+    }
+  }
+
   c.config = config;
 
   cameraConfigs.emplace_back(std::move(c));
@@ -147,6 +221,44 @@ bool ReadSwitchedCameraConfig(const wpi::json& config) {
   return true;
 }
 
+bool ReadPipelineConfig(const wpi::json& config) {
+  frcvision::PipelineSettings c;
+
+  // "plugin" and "stages" entries are for the built-in multiCameraServer
+  if (config.count("type") == 0 &&
+      (config.count("plugin") != 0 || config.count("stages") != 0)) {
+    ParseError(
+        "pipeline '{}': \"plugin\" and \"stages\" pipelines are run by "
+        "the built-in multiCameraServer, not this program",
+        config.value("name", ""));
+    return false;
+  }
+
+  // type
+  try {
+    c.type = config.at("type").get<std::string>();
+  } catch (const wpi::json::exception& e) {
+    ParseError("could not read pipeline type: {}", e.what());
+    return false;
+  }
+
+  try {
+    c.camera = config.at("camera").get<std::string>();
+    c.name = config.value("name", c.type);
+    c.fps = config.value("fps", 0.0);
+    c.size.width = config.value("width", 0);
+    c.size.height = config.value("height", 0);
+    c.gray = config.value("gray", false);
+    c.config = config.value("config", wpi::json::object());
+  } catch (const wpi::json::exception& e) {
+    ParseError("pipeline '{}': {}", c.type, e.what());
+    return false;
+  }
+
+  pipelineConfigs.emplace_back(std::move(c));
+  return true;
+}
+
 bool ReadConfig() {
   // open config file
   std::error_code ec;
@@ -217,6 +329,24 @@ bool ReadConfig() {
     }
   }
 
+  // pipelines (optional)
+  if (j.count("pipelines") != 0) {
+    try {
+      for (auto&& pipeline : j.at("pipelines")) {
+        if (!ReadPipelineConfig(pipeline)) return false;
+      }
+    } catch (const wpi::json::exception& e) {
+      ParseError("could not read pipelines: {}", e.what());
+      return false;
+    }
+  } else if (!cameraConfigs.empty()) {
+    frcvision::PipelineSettings c;
+    c.type = "example";
+    c.name = "example";
+    c.camera = cameraConfigs[0].name;
+    pipelineConfigs.emplace_back(std::move(c));
+  }
+
   return true;
 }
 
@@ -266,14 +396,46 @@ cs::MjpegServer StartSwitchedCamera(const SwitchedCameraConfig& config) {
 }
 
 // example pipeline
-class MyPipeline : public frc::VisionPipeline {
+class MyPipeline : public frcvision::CameraPipeline {
  public:
-  int val = 0;
+  MyPipeline(const frcvision::PipelineSettings& settings,
+             nt::NetworkTableInstance inst)
+      : m_valPub{inst.GetIntegerTopic(fmt::format("/vision/{}/val",
+                                                  settings.name))
+                     .Publish()},
+        m_captureTimePub{
+            inst.GetIntegerTopic(
+                    fmt::format("/vision/{}/captureTime", settings.name))
+                .Publish()} {}
+
+  void Process(cv::Mat& mat, const frcvision::FrameTime& time) override {
+    ++m_val;
+    // publish results with the capture time so the robot can compensate
+    // for latency
+    m_valPub.Set(m_val, time.local);
+    if (time.server != 0) m_captureTimePub.Set(time.server, time.local);
+  }
 
-  void Process(cv::Mat& mat) override {
-    ++val;
+  // draws results for the overlay stream
+  void Draw(cv::Mat& mat) override {
+    frcvision::DrawLabel(mat, fmt::format("val {}", m_val), {4, mat.rows - 6});
   }
+
+ private:
+  int m_val = 0;
+  nt::IntegerPublisher m_valPub;
+  nt::IntegerPublisher m_captureTimePub;
 };
+
+// overlay stream for a camera, if configured
+frcvision::OverlayOutput* StartOverlay(const CameraConfig& config) {
+  if (!config.overlay) return nullptr;
+  auto overlay = std::make_unique<frcvision::OverlayOutput>(
+      config.overlayName, config.overlayFps);
+  if (config.overlayStreamConfig.is_object())
+    overlay->GetServer().SetConfigJson(config.overlayStreamConfig);
+  return overlays.emplace_back(std::move(overlay)).get();
+}
 }  // namespace
 
 int main(int argc, char* argv[]) {
@@ -303,21 +465,47 @@ int main(int argc, char* argv[]) {
   // start switched cameras
   for (const auto& config : switchedCameraConfigs) StartSwitchedCamera(config);
 
-  // start image processing on camera 0 if present
-  if (cameras.size() >= 1) {
-    std::thread([&] {
-      frc::VisionRunner<MyPipeline> runner(cameras[0], new MyPipeline(),
-                                           [&](MyPipeline &pipeline) {
-        // do something with pipeline results
-      });
-      /* something like this for GRIP:
-      frc::VisionRunner<MyPipeline> runner(cameras[0], new grip::GripPipeline(),
-                                           [&](grip::GripPipeline& pipeline) {
-        ...
-      });
-       */
-      runner.RunForever();
-    }).detach();
+  // estimate the NT server clock offset for frame timestamps
+  frcvision::TimeSync timeSync{ntinst};
+
+  // pipeline types that frc.json can attach to cameras
+  frcvision::PipelineRuntime runtime{ntinst, timeSync};
+  runtime.AddType("example", [&](const auto& settings, auto& pool) {
+    return std::make_unique<MyPipeline>(settings, ntinst);
+  });
+  runtime.AddType("target", [&](const auto& settings, auto& pool) {
+    return std::make_unique<TargetPipeline>(settings, ntinst, pool);
+  });
+  /* something like this for GRIP, with an adapter class that calls
+     grip::GripPipeline::Process and publishes its outputs:
+  runtime.AddType("grip", [&](const auto& settings, auto& pool) {
+    return std::make_unique<GripAdapter>(settings, ntinst);
+  });
+   */
+
+  // start image processing
+  std::vector<bool> overlayUsed(cameras.size());
+  for (auto settings : pipelineConfigs) {
+    size_t i = 0;
+    while (i < cameraConfigs.size() && cameraConfigs[i].name != settings.camera)
+      ++i;
+    if (i == cameraConfigs.size()) {
+      fmt::print(stderr, "pipeline '{}': no camera named '{}'\n",
+                 settings.name, settings.camera);
+      continue;
+    }
+    settings.priority = cameraConfigs[i].priority;
+    frcvision::OverlayOutput* overlay = nullptr;
+    if (!overlayUsed[i]) {
+      overlay = StartOverlay(cameraConfigs[i]);
+      overlayUsed[i] = true;
+    }
+    fmt::print("Starting pipeline '{}' ({}) on camera '{}'\n", settings.name,
+               settings.type, settings.camera);
+    if (!runtime.Attach(cameras[i], settings, overlay)) {
+      fmt::print(stderr, "pipeline '{}': unknown type '{}'\n", settings.name,
+                 settings.type);
+    }
   }
 
   // loop forever
@@ -0,0 +1,98 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <VisionPlugin.h>
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <wpi/json.h>
+
+/*
+   Example pipeline plugin for the built-in multiCameraServer: finds the
+   largest bright blob and publishes its center and area.
+
+   Build with "make plugin" and upload pipeline.so on the Application tab
+   with "Built-in streaming with uploaded pipeline plugin" selected.  The
+   camera is chosen in the "pipelines" section of /boot/frc.json; the
+   optional "config" object there is passed to create, e.g.
+   {"threshold": 200}.
+ */
+
+namespace {
+
+struct Pipeline {
+  const frcvision_host* host;
+  int threshold = 200;
+  cv::Mat gray;
+  cv::Mat mask;
+  std::vector<std::vector<cv::Point>> contours;
+};
+
+void* Create(const frcvision_host* host, const char* config) {
+  auto pipeline = new Pipeline;
+  pipeline->host = host;
+  try {
+    auto j = wpi::json::parse(config);
+    pipeline->threshold = j.value("threshold", pipeline->threshold);
+  } catch (const wpi::json::exception& e) {
+    host->log(host->ctx, e.what());
+  }
+  return pipeline;
+}
+
+void Process(void* instance, frcvision_image* image, int64_t captureTime) {
+  auto pipeline = static_cast<Pipeline*>(instance);
+  auto host = pipeline->host;
+
+  // wrap the frame without copying
+  bool gray = image->format == FRCVISION_PIXEL_GRAY;
+  cv::Mat frame{image->height, image->width, gray ? CV_8UC1 : CV_8UC3,
+                image->data, image->stride};
+  if (gray) {
+    pipeline->gray = frame;
+  } else {
+    cv::cvtColor(frame, pipeline->gray, cv::COLOR_BGR2GRAY);
+  }
+
+  cv::threshold(pipeline->gray, pipeline->mask, pipeline->threshold, 255,
+                cv::THRESH_BINARY);
+  cv::findContours(pipeline->mask, pipeline->contours, cv::RETR_EXTERNAL,
+                   cv::CHAIN_APPROX_SIMPLE);
+
+  double bestArea = 0;
+  cv::Rect best;
+  for (const auto& contour : pipeline->contours) {
+    double area = cv::contourArea(contour);
+    if (area > bestArea) {
+      bestArea = area;
+      best = cv::boundingRect(contour);
+    }
+  }
+
+  host->publish_double(host->ctx, "area", bestArea);
+  if (bestArea > 0) {
+    double center[2] = {best.x + best.width / 2.0,
+                        best.y + best.height / 2.0};
+    host->publish_double_array(host->ctx, "center", center, 2);
+
+    // annotate the output stream, if any
+    cv::rectangle(frame, best, gray ? cv::Scalar{255} : cv::Scalar{0, 255, 0},
+                  2);
+  }
+}
+
+void Destroy(void* instance) { delete static_cast<Pipeline*>(instance); }
+
+const frcvision_plugin plugin = {FRCVISION_PLUGIN_ABI_VERSION,
+                                 "example blob finder", Create, Process,
+                                 Destroy};
+
+}  // namespace
+
+extern "C" const frcvision_plugin* FRCVISION_PLUGIN_ENTRY(void) {
+  return &plugin;
+}
@@ -0,0 +1,174 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fmt/format.h>
+#include <networktables/NetworkTableInstance.h>
+#include <wpi/json.h>
+#include <wpi/raw_istream.h>
+
+#include "TargetPipeline.h"
+#include "frcvision/FrameReader.h"
+#include "frcvision/ReplayCameraPipeline.h"
+#include "frcvision/ReplayRunner.h"
+#include "frcvision/WorkPool.h"
+
+/*
+   Runs the "target" pipeline (TargetPipeline.h) on recorded frames and
+   reports how fast it was:
+
+       multiCameraServerReplay [options] <image directory, image or video>
+
+   It is the same pipeline the example runs on cameras, replayed through
+   ReplayCameraPipeline with the recorded frame times; "-c" takes the
+   "config" object of its /boot/frc.json pipelines entry.  Its results go
+   to a local NetworkTables instance, which is never started.  To replay
+   another CameraPipeline, construct it here instead and return its
+   results from the listener, to compare them between versions with -o
+   and diff.
+ */
+
+using namespace frcvision;
+
+static wpi::json Describe(const TargetPipeline& pipeline) {
+  wpi::json targets = wpi::json::array();
+  for (auto&& target : pipeline.GetTargets()) {
+    targets.emplace_back(wpi::json{{"x", target.x},
+                                   {"y", target.y},
+                                   {"width", target.width},
+                                   {"height", target.height},
+                                   {"area", target.area}});
+  }
+  return targets;
+}
+
+static bool ReadPipelineConfig(const char* path, wpi::json& config) {
+  std::error_code ec;
+  wpi::raw_fd_istream is(path, ec);
+  if (ec) {
+    fmt::print(stderr, "could not open '{}': {}\n", path, ec.message());
+    return false;
+  }
+  try {
+    config = wpi::json::parse(is);
+  } catch (const wpi::json::parse_error& e) {
+    fmt::print(stderr, "config error in '{}': byte {}: {}\n", path, e.byte,
+               e.what());
+    return false;
+  }
+  if (!config.is_object()) {
+    fmt::print(stderr, "config error in '{}': must be JSON object\n", path);
+    return false;
+  }
+  return true;
+}
+
+static void Usage() {
+  fmt::print(stderr,
+             "usage: multiCameraServerReplay [-r] [-f fps] [-n loops] "
+             "[-s WIDTHxHEIGHT] [-g]\n"
+             "                               [-c config.json] "
+             "[-o results.jsonl] <frames>\n\n"
+             "  -r  real time: wait for each frame's time and skip the\n"
+             "      frames that arrive while the pipeline is busy\n"
+             "  -f  frame rate of images (and videos without timestamps)\n"
+             "  -n  times to run through the frames\n"
+             "  -s  resize frames to the pipeline's size\n"
+             "  -g  give the pipeline grayscale frames\n"
+             "  -c  the pipeline's config (a pipelines entry's \"config\")\n"
+             "  -o  write each frame's results, one JSON line per frame\n");
+}
+
+static void PrintTimes(std::string_view label,
+                       const LatencyHistogram::Snapshot& times) {
+  fmt::print("  {:<10} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f}\n", label,
+             times.GetMeanMs(), times.GetPercentileMs(0.5),
+             times.GetPercentileMs(0.9), times.GetPercentileMs(0.99),
+             times.GetPercentileMs(1));
+}
+
+int main(int argc, char* argv[]) {
+  ReplayOptions options;
+  PipelineSettings settings;
+  settings.name = "target";
+  settings.type = "target";
+  double fps = 30;
+  std::string path;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg{argv[i]};
+    if (arg == "-r") {
+      options.realTime = true;
+    } else if (arg == "-f" && i + 1 < argc) {
+      fps = std::atof(argv[++i]);
+    } else if (arg == "-n" && i + 1 < argc) {
+      options.loops = std::max(std::atoi(argv[++i]), 1);
+    } else if (arg == "-s" && i + 1 < argc) {
+      int width = 0, height = 0;
+      if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 ||
+          width <= 0 || height <= 0) {
+        Usage();
+        return EXIT_FAILURE;
+      }
+      options.size = {width, height};
+    } else if (arg == "-g") {
+      options.gray = true;
+    } else if (arg == "-c" && i + 1 < argc) {
+      if (!ReadPipelineConfig(argv[++i], settings.config)) return EXIT_FAILURE;
+    } else if (arg == "-o" && i + 1 < argc) {
+      options.results = argv[++i];
+    } else if (arg == "-h" || arg == "--help" || arg[0] == '-' ||
+               !path.empty()) {
+      Usage();
+      return EXIT_FAILURE;
+    } else {
+      path = arg;
+    }
+  }
+  if (path.empty()) {
+    Usage();
+    return EXIT_FAILURE;
+  }
+
+  std::string error;
+  FrameReader reader;
+  if (!reader.Open(path, fps, error)) {
+    fmt::print(stderr, "{}\n", error);
+    return EXIT_FAILURE;
+  }
+
+  settings.size = options.size;
+  settings.gray = options.gray;
+  auto ntinst = nt::NetworkTableInstance::Create();
+  WorkPool pool;
+  TargetPipeline pipeline{settings, ntinst, pool};
+  ReplayCameraPipeline replay{pipeline};
+  ReplayRunner<ReplayCameraPipeline> runner{
+      reader, &replay,
+      [&](ReplayCameraPipeline&) { return Describe(pipeline); }};
+  ReplayStats stats;
+  if (!runner.Run(options, stats, error)) {
+    fmt::print(stderr, "{}\n", error);
+    return EXIT_FAILURE;
+  }
+
+  fmt::print("{} frames in {:.2f} s", stats.frames, stats.seconds);
+  if (options.realTime) fmt::print(", {} skipped", stats.skipped);
+  fmt::print("\n");
+  if (stats.frames == 0) return EXIT_SUCCESS;
+  // throughput with and without reading and decoding the frames
+  fmt::print("  {:.1f} fps, {:.1f} fps in the pipeline\n",
+             stats.frames / stats.seconds,
+             stats.frames / (stats.process.sumNs / 1e9));
+  fmt::print("\n  {:<10} {:>8} {:>8} {:>8} {:>8} {:>8}\n", "ms", "mean",
+             "p50", "p90", "p99", "max");
+  PrintTimes("process", stats.process);
+  if (options.realTime) PrintTimes("latency", stats.latency);
+  return EXIT_SUCCESS;
+}
@@ -35,6 +35,12 @@ void Application::Set(std::string_view appType,
 
   if (appType == "builtin") {
     appCommand = "/usr/local/frc/bin/multiCameraServer";
+  } else if (appType == "upload-plugin") {
+    // uploading another plugin build is picked up by the running
+    // multiCameraServer, so don't restart it
+    if (GetStatusJson()["applicationType"].get<std::string>() == appType)
+      return;
+    appCommand = "/usr/local/frc/bin/multiCameraServer";
   } else if (appType == "example-java") {
     appDir = "examples/java-multiCameraServer";
     appCommand =
@@ -94,6 +100,8 @@ void Application::FinishUpload(std::string_view appType, UploadHelper& helper,
     filename = "/uploaded";
   } else if (appType == "upload-python") {
     filename = "/uploaded.py";
+  } else if (appType == "upload-plugin") {
+    filename = "/uploaded.so";
   } else {
     onFail(fmt::format("cannot upload application type '{}'", appType));
     helper.Close();
@@ -119,6 +127,16 @@ void Application::FinishUpload(std::string_view appType, UploadHelper& helper,
 
   auto pathname = fmt::format("{}{}", EXEC_HOME, filename);
 
+  // replace plugins atomically; multiCameraServer watches the file and
+  // swaps in the new build without restarting
+  if (appType == "upload-plugin") {
+    if (rename(helper.GetFilename(), pathname.c_str()) == -1) {
+      onFail(fmt::format("could not rename to plugin: {}",
+                         std::strerror(errno)));
+    }
+    return;
+  }
+
   // remove old file (need to do this as we can't overwrite a running exe)
   if (unlink(pathname.c_str()) == -1) {
     fmt::print(stderr, "could not remove app executable: {}\n",
@@ -0,0 +1,334 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "VideoModePlanner.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string_view>
+#include <utility>
+
+#include <fmt/format.h>
+#include <wpi/json.h>
+
+namespace {
+
+// maximum candidate modes considered per camera
+constexpr size_t kMaxCandidates = 32;
+
+/*
+   Cost model.  Bandwidth figures are the approximate isochronous bandwidth
+   a UVC camera can actually get at each USB speed (well below the signaling
+   rate).  CPU figures are rough per-pixel costs on a Raspberry Pi 4.
+ */
+
+// usable isochronous bandwidth in bytes/s
+double UsbBudget(int speedMbps) {
+  if (speedMbps >= 5000) return 400e6;
+  if (speedMbps >= 480) return 24e6;
+  if (speedMbps >= 12) return 1e6;
+  return 0.1e6;
+}
+
+// bytes per pixel on the wire; MJPEG is a typical compressed size
+double WireBytesPerPixel(cs::VideoMode::PixelFormat pixelFormat) {
+  switch (pixelFormat) {
+    case cs::VideoMode::kMJPEG:
+      return 0.3;
+    case cs::VideoMode::kBGR:
+      return 3;
+    case cs::VideoMode::kGray:
+      return 1;
+    default:
+      return 2;
+  }
+}
+
+// ns per pixel to produce a BGR image for processing
+double DecodeNsPerPixel(cs::VideoMode::PixelFormat pixelFormat) {
+  switch (pixelFormat) {
+    case cs::VideoMode::kMJPEG:
+      return 12;
+    case cs::VideoMode::kBGR:
+      return 0.5;
+    case cs::VideoMode::kGray:
+      return 1;
+    default:
+      return 3;
+  }
+}
+
+// ns per pixel to stream; MJPEG is passed through without re-encoding
+double StreamNsPerPixel(cs::VideoMode::PixelFormat pixelFormat) {
+  return pixelFormat == cs::VideoMode::kMJPEG ? 0 : 16;
+}
+
+std::string_view PixelFormatName(cs::VideoMode::PixelFormat pixelFormat) {
+  switch (pixelFormat) {
+    case cs::VideoMode::kMJPEG:
+      return "mjpeg";
+    case cs::VideoMode::kYUYV:
+      return "yuyv";
+    case cs::VideoMode::kRGB565:
+      return "rgb565";
+    case cs::VideoMode::kBGR:
+      return "bgr";
+    case cs::VideoMode::kGray:
+      return "gray";
+    default:
+      return {};
+  }
+}
+
+struct Candidate {
+  const cs::VideoMode* mode;
+  double bandwidth;  // bytes/s
+  double cpu;        // fraction of one core
+};
+
+std::string DescribeMode(const cs::VideoMode& mode) {
+  std::string name{PixelFormatName(
+      static_cast<cs::VideoMode::PixelFormat>(mode.pixelFormat))};
+  std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+  return fmt::format("{} {}x{}@{}", name, mode.width, mode.height, mode.fps);
+}
+
+class Planner {
+ public:
+  explicit Planner(std::span<const PlannerCamera> cameras)
+      : m_cameras{cameras},
+        m_candidates(cameras.size()),
+        m_relaxed(cameras.size()),
+        m_choice(cameras.size()) {}
+
+  wpi::json Plan();
+
+ private:
+  void BuildCandidates(size_t i);
+  bool Fits(size_t i, const Candidate& c) const;
+  void Search(size_t i, double cost);
+  std::string Explain(size_t i, const Candidate& chosen) const;
+
+  std::span<const PlannerCamera> m_cameras;
+  std::vector<std::vector<Candidate>> m_candidates;
+  std::vector<std::string> m_relaxed;
+  std::map<int, double> m_busUsed;
+  std::vector<size_t> m_choice;
+  std::vector<size_t> m_best;
+  double m_bestCost = std::numeric_limits<double>::infinity();
+};
+
+void Planner::BuildCandidates(size_t i) {
+  const auto& cam = m_cameras[i];
+  auto& candidates = m_candidates[i];
+
+  auto meetsSize = [&](const cs::VideoMode& m) {
+    return m.width >= cam.width && m.height >= cam.height;
+  };
+  auto meetsFps = [&](const cs::VideoMode& m) { return m.fps >= cam.fps; };
+
+  auto usable = [](const cs::VideoMode& m) {
+    return !PixelFormatName(
+                static_cast<cs::VideoMode::PixelFormat>(m.pixelFormat))
+                .empty();
+  };
+
+  // use the strictest filter that leaves at least one mode
+  bool haveFull = false;
+  bool haveSize = false;
+  for (auto&& mode : cam.modes) {
+    if (!usable(mode)) continue;
+    if (meetsSize(mode) && meetsFps(mode)) haveFull = true;
+    if (meetsSize(mode)) haveSize = true;
+  }
+
+  // if the target can't be met, only consider the modes that come closest:
+  // the highest fps at the target resolution, or else the largest size
+  auto closeness = [&](const cs::VideoMode& m) {
+    return haveSize ? m.fps : m.width * m.height;
+  };
+  int best = 0;
+  if (!haveFull) {
+    m_relaxed[i] = haveSize ? "no mode reaches the target fps"
+                            : "no mode reaches the target resolution";
+    for (auto&& mode : cam.modes) {
+      if (usable(mode) && (!haveSize || meetsSize(mode)))
+        best = std::max(best, closeness(mode));
+    }
+  }
+
+  for (auto&& mode : cam.modes) {
+    if (!usable(mode)) continue;
+    if (haveFull && !(meetsSize(mode) && meetsFps(mode))) continue;
+    if (!haveFull && haveSize && !meetsSize(mode)) continue;
+    if (!haveFull && closeness(mode) != best) continue;
+
+    auto pixelFormat =
+        static_cast<cs::VideoMode::PixelFormat>(mode.pixelFormat);
+    double pixelRate = static_cast<double>(mode.width) * mode.height * mode.fps;
+    double ns = StreamNsPerPixel(pixelFormat);
+    if (cam.process) ns += DecodeNsPerPixel(pixelFormat);
+    candidates.push_back({&mode, pixelRate * WireBytesPerPixel(pixelFormat),
+                          pixelRate * ns * 1e-9});
+  }
+
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) {
+              if (a.cpu != b.cpu) return a.cpu < b.cpu;
+              return a.bandwidth < b.bandwidth;
+            });
+  // a mode that costs at least as much CPU and bandwidth as another can
+  // never be part of a better plan; what remains gets cheaper on the bus as
+  // it gets more expensive on the CPU
+  std::vector<Candidate> kept;
+  for (auto&& c : candidates) {
+    if (kept.empty() || c.bandwidth < kept.back().bandwidth) kept.push_back(c);
+  }
+  // if there are still too many, keep the cheapest on the CPU and the
+  // cheapest on the bus, which are the ones that fit a crowded bus
+  if (kept.size() > kMaxCandidates) {
+    kept.erase(kept.begin() + kMaxCandidates / 2,
+               kept.end() - (kMaxCandidates - kMaxCandidates / 2));
+  }
+  candidates = std::move(kept);
+}
+
+bool Planner::Fits(size_t i, const Candidate& c) const {
+  const auto& usb = m_cameras[i].usb;
+  if (usb.bus < 0) return true;
+  if (c.bandwidth > UsbBudget(usb.speed)) return false;
+  auto it = m_busUsed.find(usb.bus);
+  double used = it == m_busUsed.end() ? 0 : it->second;
+  return used + c.bandwidth <= UsbBudget(usb.busSpeed);
+}
+
+void Planner::Search(size_t i, double cost) {
+  if (i == m_cameras.size()) {
+    m_bestCost = cost;
+    m_best = m_choice;
+    return;
+  }
+  const auto& candidates = m_candidates[i];
+  for (size_t k = 0; k < candidates.size(); ++k) {
+    const auto& c = candidates[k];
+    // candidates are sorted by cost, so nothing later can do better
+    if (cost + c.cpu >= m_bestCost) break;
+    if (!Fits(i, c)) continue;
+    int bus = m_cameras[i].usb.bus;
+    if (bus >= 0) m_busUsed[bus] += c.bandwidth;
+    m_choice[i] = k;
+    Search(i + 1, cost + c.cpu);
+    if (bus >= 0) m_busUsed[bus] -= c.bandwidth;
+  }
+}
+
+std::string Planner::Explain(size_t i, const Candidate& chosen) const {
+  const auto& usb = m_cameras[i].usb;
+  std::string out = DescribeMode(*chosen.mode);
+  if (usb.bus >= 0) {
+    out += fmt::format(": {:.1f} MB/s on USB bus {} ", chosen.bandwidth / 1e6,
+                       usb.bus);
+    out += fmt::format("({} Mbps device, {} Mbps bus)", usb.speed,
+                       usb.busSpeed);
+  } else {
+    out += ": not a USB camera";
+  }
+  out += fmt::format(", ~{:.0f}% of one core", chosen.cpu * 100);
+
+  if (!m_relaxed[i].empty()) out += "; " + m_relaxed[i];
+
+  // explain why the cheapest mode was not used
+  const auto& cheapest = m_candidates[i].front();
+  if (cheapest.mode != chosen.mode) {
+    out += fmt::format("; {} would use ~{:.0f}% but needs {:.1f} MB/s",
+                       DescribeMode(*cheapest.mode), cheapest.cpu * 100,
+                       cheapest.bandwidth / 1e6);
+    if (usb.bus >= 0 && cheapest.bandwidth > UsbBudget(usb.speed))
+      out += " (more than this device's link)";
+    else
+      out += " (does not fit on the bus with the other cameras)";
+  }
+  return out;
+}
+
+wpi::json Planner::Plan() {
+  for (size_t i = 0; i < m_cameras.size(); ++i) {
+    BuildCandidates(i);
+    if (m_candidates[i].empty()) {
+      return {{"type", "visionPlan"},
+              {"feasible", false},
+              {"summary", fmt::format("no usable video modes for camera {}",
+                                      m_cameras[i].path)}};
+    }
+  }
+
+  Search(0, 0);
+
+  bool feasible = !m_best.empty() || m_cameras.empty();
+  if (!feasible) {
+    // nothing fits; fall back to the least bandwidth for every camera
+    m_best.resize(m_cameras.size());
+    for (size_t i = 0; i < m_cameras.size(); ++i) {
+      auto& candidates = m_candidates[i];
+      m_best[i] = std::min_element(candidates.begin(), candidates.end(),
+                                   [](const auto& a, const auto& b) {
+                                     return a.bandwidth < b.bandwidth;
+                                   }) -
+                  candidates.begin();
+    }
+  }
+
+  wpi::json j = {{"type", "visionPlan"},
+                 {"feasible", feasible},
+                 {"cameras", wpi::json::array()},
+                 {"buses", wpi::json::array()}};
+
+  double cpu = 0;
+  std::map<int, std::pair<double, int>> buses;
+  for (size_t i = 0; i < m_cameras.size(); ++i) {
+    const auto& c = m_candidates[i][m_best[i]];
+    cpu += c.cpu;
+    const auto& usb = m_cameras[i].usb;
+    if (usb.bus >= 0) {
+      buses[usb.bus].first += c.bandwidth;
+      buses[usb.bus].second = usb.busSpeed;
+    }
+    j["cameras"].emplace_back(wpi::json{
+        {"path", m_cameras[i].path},
+        {"pixel format",
+         PixelFormatName(
+             static_cast<cs::VideoMode::PixelFormat>(c.mode->pixelFormat))},
+        {"width", c.mode->width},
+        {"height", c.mode->height},
+        {"fps", c.mode->fps},
+        {"explanation", Explain(i, c)}});
+  }
+  for (auto&& [bus, usage] : buses) {
+    j["buses"].emplace_back(wpi::json{{"bus", bus},
+                                      {"speed", usage.second},
+                                      {"used", usage.first},
+                                      {"budget", UsbBudget(usage.second)}});
+  }
+  j["cpu"] = cpu * 100;
+
+  if (feasible) {
+    j["summary"] = fmt::format(
+        "All cameras fit their USB bandwidth; estimated {:.0f}% of one core "
+        "for capture and streaming",
+        cpu * 100);
+  } else {
+    j["summary"] =
+        "No combination of modes fits the USB bandwidth; showing the lowest "
+        "bandwidth modes.  Move cameras to different buses or lower the "
+        "targets.";
+  }
+  return j;
+}
+
+}  // namespace
+
+wpi::json PlanVideoModes(std::span<const PlannerCamera> cameras) {
+  return Planner{cameras}.Plan();
+}
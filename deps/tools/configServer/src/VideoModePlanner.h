@@ -0,0 +1,46 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef RPICONFIGSERVER_VIDEOMODEPLANNER_H_
+#define RPICONFIGSERVER_VIDEOMODEPLANNER_H_
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include <cscore.h>
+#include <wpi/json_fwd.h>
+
+/* USB topology of a camera, read from sysfs */
+struct UsbBusInfo {
+  int bus = -1;         // USB bus number; -1 if not a USB device
+  int speed = 0;        // negotiated device speed in Mbps
+  int busSpeed = 0;     // root hub speed in Mbps
+  std::string port;     // sysfs device name, e.g. "1-1.2"
+};
+
+struct PlannerCamera {
+  std::string path;
+  std::vector<cs::VideoMode> modes;
+  UsbBusInfo usb;
+
+  // target; 0 means "don't care"
+  int width = 0;
+  int height = 0;
+  int fps = 0;
+
+  // frames are decoded for vision processing (not only streamed)
+  bool process = false;
+};
+
+/*
+   Picks one video mode per camera that meets the per-camera target, fits
+   the isochronous bandwidth of each USB bus, and minimizes the estimated CPU
+   spent decoding, converting and stream-encoding frames.
+
+   Returns a "visionPlan" message with the chosen modes and an explanation.
+ */
+wpi::json PlanVideoModes(std::span<const PlannerCamera> cameras);
+
+#endif  // RPICONFIGSERVER_VIDEOMODEPLANNER_H_
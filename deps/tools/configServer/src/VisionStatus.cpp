@@ -8,9 +8,13 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstring>
+#include <string>
 #include <string_view>
 
 #include <cscore.h>
@@ -19,6 +23,7 @@
 #include <wpi/StringExtras.h>
 #include <wpi/fmt/raw_ostream.h>
 #include <wpi/json.h>
+#include <wpi/raw_istream.h>
 #include <wpi/raw_ostream.h>
 #include <wpinet/uv/Buffer.h>
 #include <wpinet/uv/FsEvent.h>
@@ -31,6 +36,36 @@ namespace uv = wpi::uv;
 
 #define SERVICE "/service/camera"
 
+static double ReadSysfsNumber(const std::string& path) {
+  std::error_code ec;
+  wpi::raw_fd_istream is(path, ec);
+  if (ec) return -1;
+  wpi::SmallString<32> buf;
+  return wpi::parse_float<double>(wpi::trim(is.getline(buf, 32))).value_or(-1);
+}
+
+static UsbBusInfo ReadUsbBusInfo(int dev) {
+  UsbBusInfo info;
+
+  // the video4linux device links to the USB interface (e.g. 1-1.2:1.0);
+  // its parent directory is the USB device itself
+  char buf[PATH_MAX];
+  auto link = fmt::format("/sys/class/video4linux/video{}/device", dev);
+  if (!realpath(link.c_str(), buf)) return info;
+  std::string_view iface{buf};
+  std::string device{iface.substr(0, iface.rfind('/'))};
+
+  double bus = ReadSysfsNumber(device + "/busnum");
+  if (bus < 0) return info;  // not a USB device (e.g. CSI camera)
+  info.bus = bus;
+  info.speed = ReadSysfsNumber(device + "/speed");
+  info.busSpeed = ReadSysfsNumber(
+      fmt::format("/sys/bus/usb/devices/usb{}/speed", info.bus));
+  if (info.busSpeed <= 0) info.busSpeed = info.speed;
+  info.port = device.substr(device.rfind('/') + 1);
+  return info;
+}
+
 std::shared_ptr<VisionStatus> VisionStatus::GetInstance() {
   static auto visStatus = std::make_shared<VisionStatus>(private_init{});
   return visStatus;
@@ -100,11 +135,46 @@ void VisionStatus::UpdateCameraList() {
 
       modes.emplace_back(jmode);
     }
+    if (caminfo.usb.bus >= 0) {
+      cam["usb"] = {{"bus", caminfo.usb.bus},
+                    {"speed", caminfo.usb.speed},
+                    {"port", caminfo.usb.port}};
+    }
     cams.emplace_back(cam);
   }
   cameraList(j);
 }
 
+wpi::json VisionStatus::PlanModes(const wpi::json& targets) {
+  std::vector<PlannerCamera> cams;
+  for (auto&& target : targets) {
+    PlannerCamera c;
+    c.path = target.at("path").get<std::string>();
+    c.width = target.value("width", 0);
+    c.height = target.value("height", 0);
+    c.fps = target.value("fps", 0);
+    c.process = target.value("process", false);
+
+    // match by main path or any alternate path
+    for (const auto& caminfo : m_cameraInfo) {
+      const auto& paths = caminfo.info.otherPaths;
+      if (caminfo.info.path == c.path ||
+          std::find(paths.begin(), paths.end(), c.path) != paths.end()) {
+        c.modes = caminfo.modes;
+        c.usb = caminfo.usb;
+        break;
+      }
+    }
+    if (c.modes.empty()) {
+      return {{"type", "visionPlan"},
+              {"feasible", false},
+              {"summary", fmt::format("camera {} is not connected", c.path)}};
+    }
+    cams.emplace_back(std::move(c));
+  }
+  return PlanVideoModes(cams);
+}
+
 void VisionStatus::RefreshCameraList() {
   struct RefreshCameraWorkReq : public uv::WorkReq {
     std::vector<CameraInfo> cameraInfo;
@@ -117,6 +187,7 @@ void VisionStatus::RefreshCameraList() {
       r->cameraInfo.emplace_back();
       r->cameraInfo.back().info = std::move(caminfo);
       r->cameraInfo.back().modes = camera.EnumerateVideoModes();
+      r->cameraInfo.back().usb = ReadUsbBusInfo(r->cameraInfo.back().info.dev);
     }
   });
   workReq->afterWork.connect([ this, r = workReq.get() ] {
@@ -274,3 +345,39 @@ void VisionStatus::ConsoleLog(uv::Buffer& buf, size_t len) {
                  {"data", std::string_view(buf.base, len)}};
   log(j);
 }
+
+void VisionStatus::Telemetry(uv::Buffer& buf, size_t len) {
+  wpi::json j;
+  try {
+    j = wpi::json::parse(std::string_view(buf.base, len));
+  } catch (const wpi::json::parse_error& e) {
+    fmt::print(stderr, "could not parse vision telemetry: {}\n", e.what());
+    return;
+  }
+
+  // only pass through vision messages to the web page
+  if (!j.is_object() || !j.count("type") || !j.at("type").is_string() ||
+      !wpi::starts_with(j.at("type").get<std::string>(), "vision"))
+    return;
+
+  auto type = j.at("type").get<std::string>();
+  auto it = std::find_if(m_telemetry.begin(), m_telemetry.end(),
+                         [&](const auto& info) { return info.type == type; });
+  if (it == m_telemetry.end())
+    it = m_telemetry.insert(m_telemetry.end(), TelemetryInfo{type});
+  it->message.assign(buf.base, len);
+  it->received = std::chrono::steady_clock::now();
+
+  telemetry(j);
+}
+
+void VisionStatus::UpdateTelemetry() {
+  // senders report every second or so; anything older is from a pipeline
+  // that has stopped
+  auto now = std::chrono::steady_clock::now();
+  for (auto&& info : m_telemetry) {
+    if (now - info.received > std::chrono::seconds{3}) continue;
+    // it parsed when it arrived
+    telemetry(wpi::json::parse(info.message));
+  }
+}
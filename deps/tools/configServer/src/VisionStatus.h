@@ -5,8 +5,10 @@
 #ifndef RPICONFIGSERVER_VISIONSTATUS_H_
 #define RPICONFIGSERVER_VISIONSTATUS_H_
 
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -15,6 +17,8 @@
 #include <wpi/json_fwd.h>
 #include <wpinet/uv/Loop.h>
 
+#include "VideoModePlanner.h"
+
 namespace wpi::uv {
 class Buffer;
 }  // namespace wpi::uv
@@ -36,10 +40,17 @@ class VisionStatus {
 
   void UpdateStatus();
   void ConsoleLog(wpi::uv::Buffer& buf, size_t len);
+  void Telemetry(wpi::uv::Buffer& buf, size_t len);
+  // resends the latest telemetry of each type, unless it is stale
+  void UpdateTelemetry();
   void UpdateCameraList();
 
+  // plan video modes for the given per-camera targets
+  wpi::json PlanModes(const wpi::json& targets);
+
   wpi::sig::Signal<const wpi::json&> update;
   wpi::sig::Signal<const wpi::json&> log;
+  wpi::sig::Signal<const wpi::json&> telemetry;
   wpi::sig::Signal<const wpi::json&> cameraList;
 
   static std::shared_ptr<VisionStatus> GetInstance();
@@ -53,8 +64,17 @@ class VisionStatus {
   struct CameraInfo {
     cs::UsbCameraInfo info;
     std::vector<cs::VideoMode> modes;
+    UsbBusInfo usb;
   };
   std::vector<CameraInfo> m_cameraInfo;
+
+  // latest message of each telemetry type, so a new page doesn't wait
+  struct TelemetryInfo {
+    std::string type;
+    std::string message;
+    std::chrono::steady_clock::time_point received;
+  };
+  std::vector<TelemetryInfo> m_telemetry;
 };
 
 #endif  // RPICONFIGSERVER_VISIONSTATUS_H_
@@ -44,6 +44,7 @@ struct WebSocketData {
   wpi::sig::ScopedConnection sysWritableConn;
   wpi::sig::ScopedConnection visStatusConn;
   wpi::sig::ScopedConnection visLogConn;
+  wpi::sig::ScopedConnection visTelemetryConn;
   wpi::sig::ScopedConnection romiStatusConn;
   wpi::sig::ScopedConnection romiLogConn;
   wpi::sig::ScopedConnection romiConfigConn;
@@ -136,7 +137,10 @@ void InitWs(wpi::WebSocket& ws) {
         auto d = ws.GetData<WebSocketData>();
         if (d->visionLogEnabled) SendWsText(ws, j);
       });
+  data->visTelemetryConn = visStatus->telemetry.connect_connection(
+      [&ws](const wpi::json& j) { SendWsText(ws, j); });
   visStatus->UpdateStatus();
+  visStatus->UpdateTelemetry();
   data->cameraListConn = visStatus->cameraList.connect_connection(
       [&ws](const wpi::json& j) { SendWsText(ws, j); });
   visStatus->UpdateCameraList();
@@ -265,6 +269,13 @@ void ProcessWsText(wpi::WebSocket& ws, std::string_view msg) {
         fmt::print(stderr, "could not read visionSave value: {}\n", e.what());
         return;
       }
+    } else if (subType == "Plan") {
+      try {
+        SendWsText(ws, VisionStatus::GetInstance()->PlanModes(j.at("targets")));
+      } catch (const wpi::json::exception& e) {
+        fmt::print(stderr, "could not read visionPlan value: {}\n", e.what());
+        return;
+      }
     }
   } else if (wpi::starts_with(t, "romi") && romi) {
     std::string_view subType = wpi::substr(t, 4);
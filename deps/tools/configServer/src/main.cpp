@@ -97,6 +97,15 @@ int main(int argc, char* argv[]) {
         VisionStatus::GetInstance()->ConsoleLog(buf, len);
       });
 
+  // listen on port 6667 for vision telemetry (JSON messages)
+  auto udpTelemetry = uv::Udp::Create(loop);
+  udpTelemetry->Bind("127.0.0.1", 6667, UV_UDP_REUSEADDR);
+  udpTelemetry->StartRecv();
+  udpTelemetry->received.connect(
+      [](uv::Buffer& buf, size_t len, const sockaddr&, unsigned) {
+        VisionStatus::GetInstance()->Telemetry(buf, len);
+      });
+
   // listen on port 7777 for romi console logging
   if (romi) {
     auto udpCon = uv::Udp::Create(loop);
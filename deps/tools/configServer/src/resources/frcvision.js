@@ -82,6 +82,8 @@ var connectedButtonIds = [
   'visionClient',
   'visionTeam',
   'visionDiscard',
+  'visionPlan',
+  'visionPlanProcess',
   'addConnectedCamera',
   'addCamera',
   'applicationType'
@@ -107,7 +109,7 @@ var connectedButtonClasses = [
   'cameraCopyConfig',
   'cameraKey'
 ];
-var writableButtonIds = ['networkSave', 'visionSave', 'applicationSave', 'fileUploadButton', 'romiSaveExternalIOConfig', 'romiServiceUploadButton', 'romiCalibrateButton'];
+var writableButtonIds = ['networkSave', 'visionSave', 'visionPlanApply', 'applicationSave', 'fileUploadButton', 'romiSaveExternalIOConfig', 'romiServiceUploadButton', 'romiCalibrateButton'];
 var systemStatusIds = ['systemMemoryFree1s', 'systemMemoryFree5s',
                        'systemMemoryAvail1s', 'systemMemoryAvail5s',
                        'systemCpuUser1s', 'systemCpuUser5s',
@@ -281,6 +283,12 @@ function connect() {
       case 'visionLog':
         visionLog(msg.data);
         break;
+      case 'visionBandwidth':
+        updateVisionBandwidthView(msg);
+        break;
+      case 'visionProfile':
+        updateVisionProfileView(msg);
+        break;
       case 'romiStatus':
         var elem = $('#romiServiceStatus');
         if (msg.romiServiceStatus) {
@@ -381,6 +389,9 @@ function connect() {
         cameraList = msg.cameras;
         updateCameraListView();
         break;
+      case 'visionPlan':
+        updateVisionPlanView(msg);
+        break;
     }
   };
 }
@@ -572,6 +583,82 @@ function visionLog(data) {
   }
 }
 
+//
+// Vision stream bandwidth
+//
+function updateVisionBandwidthView(msg) {
+  var usage = $('#visionBandwidthUsage');
+  if (msg.budget > 0) {
+    usage.text(msg.used.toFixed(1) + ' / ' + msg.budget + ' Mbps');
+    usage.toggleClass('badge-danger', msg.used > msg.budget);
+    usage.toggleClass('badge-primary', msg.used <= msg.budget);
+  } else {
+    usage.text(msg.used.toFixed(1) + ' Mbps (no budget)');
+    usage.removeClass('badge-danger').addClass('badge-primary');
+  }
+  usage.removeClass('badge-dark');
+
+  var rows = $('#visionBandwidthStreams');
+  rows.html('');
+  msg.streams.forEach(function (stream) {
+    rows.append('<tr><td>' + escapeHtml(stream.name) + '</td><td>' +
+                stream.priority + '</td><td>' + stream.clients + '</td><td>' +
+                stream.mbps.toFixed(2) + '</td><td>' +
+                escapeHtml(stream.throttle) + '</td></tr>');
+  });
+}
+
+//
+// Vision pipeline stage timing
+//
+var visionProfileTimer = null;
+
+function updateVisionProfileView(msg) {
+  var status = $('#visionProfileStatus');
+  var rows = $('#visionProfileStages');
+  rows.html('');
+  var over = false;
+  msg.cameras.forEach(function (camera) {
+    rows.append('<tr class="table-secondary"><th colspan="6">' +
+                escapeHtml(camera.name || '(no camera)') + '</th></tr>');
+    camera.pipelines.forEach(function (pipeline) {
+      var budget = pipeline.budgetMs > 0 ? pipeline.budgetMs.toFixed(1) + ' ms' : 'no budget';
+      pipeline.stages.forEach(function (stage, i) {
+        // the share of the pipeline's frame period the stage takes
+        var share = '';
+        if (pipeline.budgetMs > 0) {
+          var percent = 100 * stage.meanMs / pipeline.budgetMs;
+          share = percent.toFixed(0) + '%';
+          if (stage.name === 'frame' && stage.p99Ms > pipeline.budgetMs) {
+            share = '<span class="text-danger">' + share + '</span>';
+            over = true;
+          }
+        }
+        rows.append('<tr><td>' +
+                    (i === 0 ? escapeHtml(pipeline.name) + ' (' + budget + ')' : '') +
+                    '</td><td>' + escapeHtml(stage.name) + '</td><td>' +
+                    (i === 0 ? pipeline.fps.toFixed(1) : '') + '</td><td>' +
+                    stage.meanMs.toFixed(2) + '</td><td>' +
+                    stage.p99Ms.toFixed(2) + '</td><td>' + share +
+                    '</td></tr>');
+      });
+    });
+  });
+
+  status.text(over ? 'Over Budget' : 'Running');
+  status.toggleClass('badge-danger', over);
+  status.toggleClass('badge-primary', !over);
+  status.removeClass('badge-dark');
+
+  // summaries come every second; stop showing them once they don't
+  clearTimeout(visionProfileTimer);
+  visionProfileTimer = setTimeout(function () {
+    status.text('No Data');
+    status.removeClass('badge-danger').removeClass('badge-primary').addClass('badge-dark');
+    rows.html('');
+  }, 3000);
+}
+
 //
 // Romi console output
 //
@@ -1118,6 +1205,67 @@ function updateCameraListView() {
   });
 }
 
+// Video mode planner
+var visionPlan = null;
+
+$('#visionPlan').click(function() {
+  var targets = [];
+  visionSettingsDisplay.cameras.forEach(function (value, i) {
+    var camera = $('#camera' + i);
+    var target = {
+      path: camera.find('.cameraPath').val(),
+      process: $('#visionPlanProcess').prop('checked')
+    };
+    var width = parseInt(camera.find('.cameraWidth').val(), 10);
+    if (!isNaN(width)) {
+      target.width = width;
+    }
+    var height = parseInt(camera.find('.cameraHeight').val(), 10);
+    if (!isNaN(height)) {
+      target.height = height;
+    }
+    var fps = parseInt(camera.find('.cameraFps').val(), 10);
+    if (!isNaN(fps)) {
+      target.fps = fps;
+    }
+    targets.push(target);
+  });
+  var msg = {
+    type: 'visionPlan',
+    targets: targets
+  };
+  connection.send(JSON.stringify(msg));
+});
+
+function updateVisionPlanView(plan) {
+  visionPlan = plan;
+  $('#visionPlanSummary').text(plan.summary);
+  var list = $('#visionPlanCameras');
+  list.html('');
+  if ('cameras' in plan) {
+    plan.cameras.forEach(function (value, i) {
+      var name = $('#camera' + i).find('.cameraName').val();
+      list.append('<li>' + escapeHtml('Camera ' + name + ': ' + value.explanation) + '</li>');
+    });
+  }
+  $('#visionPlanApply').toggle(plan.feasible && 'cameras' in plan);
+  $('#visionPlanResult').collapse('show');
+}
+
+$('#visionPlanApply').click(function() {
+  if (visionPlan === null || !('cameras' in visionPlan)) {
+    return;
+  }
+  visionPlan.cameras.forEach(function (value, i) {
+    var camera = $('#camera' + i);
+    camera.find('.cameraPixelFormat').val(value['pixel format']);
+    camera.find('.cameraWidth').val(value.width);
+    camera.find('.cameraHeight').val(value.height);
+    camera.find('.cameraFps').val(value.fps);
+  });
+  $('#visionSave').click();
+});
+
 var applicationFiles = [];
 
 // Show details when appropriate for application type
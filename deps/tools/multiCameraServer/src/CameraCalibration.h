@@ -0,0 +1,49 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_CAMERACALIBRATION_H_
+#define MULTICAMERASERVER_CAMERACALIBRATION_H_
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/*
+   Pinhole intrinsics and lens distortion of a camera, from the
+   "calibration" object of its frc.json entry.  They are measured at one
+   resolution; stages that see a resized frame scale them to the image they
+   process (the distortion coefficients don't depend on the scale).
+ */
+struct CameraCalibration {
+  int width = 0;  // resolution the calibration was done at
+  int height = 0;
+  double fx = 0;  // focal lengths and principal point, in pixels
+  double fy = 0;
+  double cx = 0;
+  double cy = 0;
+  // k1, k2, p1, p2[, k3[, k4, k5, k6]] as OpenCV orders them; empty if the
+  // lens is taken as distortion free
+  std::vector<double> distortion;
+
+  bool IsValid() const {
+    size_t n = distortion.size();
+    return width > 0 && height > 0 && fx > 0 && fy > 0 &&
+           (n == 0 || n == 4 || n == 5 || n == 8);
+  }
+
+  /* camera matrix for images of the given size */
+  cv::Matx33d GetCameraMatrix(cv::Size size) const {
+    double sx = static_cast<double>(size.width) / width;
+    double sy = static_cast<double>(size.height) / height;
+    return {fx * sx, 0, cx * sx, 0, fy * sy, cy * sy, 0, 0, 1};
+  }
+
+  /* distortion coefficients as a row, or an empty Mat */
+  cv::Mat GetDistortion() const {
+    if (distortion.empty()) return {};
+    return cv::Mat{distortion, true}.reshape(1, 1);
+  }
+};
+
+#endif  // MULTICAMERASERVER_CAMERACALIBRATION_H_
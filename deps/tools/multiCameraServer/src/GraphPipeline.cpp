@@ -0,0 +1,810 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "GraphPipeline.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#include <fmt/format.h>
+#include <networktables/DoubleArrayTopic.h>
+#include <networktables/IntegerArrayTopic.h>
+#include <opencv2/imgproc.hpp>
+
+#include "TagDetector.h"
+#include "UndistortMap.h"
+#include "cameraserver/CameraServer.h"
+
+namespace {
+
+using Contours = std::vector<std::vector<cv::Point>>;
+
+// what a stage produces; kNone for stages that only publish
+enum class Kind { kNone, kColor, kGray, kMask, kContours };
+
+std::string_view KindName(Kind kind) {
+  switch (kind) {
+    case Kind::kColor:
+      return "a color image";
+    case Kind::kGray:
+      return "a grayscale image";
+    case Kind::kMask:
+      return "a mask";
+    case Kind::kContours:
+      return "contours";
+    default:
+      return "nothing";
+  }
+}
+
+bool IsImage(Kind kind) {
+  return kind == Kind::kColor || kind == Kind::kGray || kind == Kind::kMask;
+}
+
+// result of one stage for one frame
+struct Value {
+  cv::Mat image;
+  Contours contours;
+  cv::Size size;  // with contours: of the image they were found in
+};
+
+}  // namespace
+
+struct GraphPipeline::Frame {
+  uint64_t time = 0;
+  Value camera;
+  std::vector<Value> outputs;  // indexed like m_nodes
+};
+
+class GraphPipeline::Stage {
+ public:
+  virtual ~Stage() = default;
+
+  // checks the input and returns the output kind, or sets error
+  virtual Kind Connect(Kind input, std::string& error) = 0;
+
+  // called for one frame at a time, on the stage's own thread
+  virtual void Process(const Value& in, Value& out, uint64_t time) = 0;
+};
+
+namespace {
+
+// "width", "height"
+class ResizeStage : public GraphPipeline::Stage {
+ public:
+  explicit ResizeStage(const wpi::json& config)
+      : m_size{config.at("width").get<int>(),
+               config.at("height").get<int>()} {}
+
+  Kind Connect(Kind input, std::string& error) override {
+    if (!IsImage(input)) {
+      error = fmt::format("cannot resize {}", KindName(input));
+      return Kind::kNone;
+    }
+    if (m_size.width <= 0 || m_size.height <= 0) {
+      error = fmt::format("invalid size {}x{}", m_size.width, m_size.height);
+      return Kind::kNone;
+    }
+    // keep masks binary
+    m_interpolation =
+        input == Kind::kMask ? cv::INTER_NEAREST : cv::INTER_AREA;
+    return input;
+  }
+
+  void Process(const Value& in, Value& out, uint64_t time) override {
+    cv::resize(in.image, out.image, m_size, 0, 0, m_interpolation);
+  }
+
+ private:
+  cv::Size m_size;
+  int m_interpolation = cv::INTER_AREA;
+};
+
+// "space" ("hsv", "ycrcb", "bgr" or "gray"), "low", "high"
+class ThresholdStage : public GraphPipeline::Stage {
+ public:
+  explicit ThresholdStage(const wpi::json& config)
+      : m_space{config.value("space", "")},
+        m_low{config.at("low").get<std::vector<double>>()},
+        m_high{config.at("high").get<std::vector<double>>()} {}
+
+  Kind Connect(Kind input, std::string& error) override {
+    if (input == Kind::kColor) {
+      if (m_space.empty()) m_space = "hsv";
+      if (m_space == "hsv") {
+        m_conversion = cv::COLOR_BGR2HSV;
+      } else if (m_space == "ycrcb") {
+        m_conversion = cv::COLOR_BGR2YCrCb;
+      } else if (m_space != "bgr") {
+        error = fmt::format("unknown color space '{}'", m_space);
+        return Kind::kNone;
+      }
+    } else if (input == Kind::kGray || input == Kind::kMask) {
+      if (m_space.empty()) m_space = "gray";
+      if (m_space != "gray") {
+        error = fmt::format("cannot convert {} to {}", KindName(input),
+                            m_space);
+        return Kind::kNone;
+      }
+    } else {
+      error = fmt::format("cannot threshold {}", KindName(input));
+      return Kind::kNone;
+    }
+
+    size_t channels = m_space == "gray" ? 1 : 3;
+    if (m_low.size() != channels || m_high.size() != channels) {
+      error = fmt::format("low and high need {} values for {}", channels,
+                          m_space);
+      return Kind::kNone;
+    }
+    for (size_t i = 0; i < channels; ++i) {
+      m_lowScalar[i] = m_low[i];
+      m_highScalar[i] = m_high[i];
+    }
+    return Kind::kMask;
+  }
+
+  void Process(const Value& in, Value& out, uint64_t time) override {
+    if (m_conversion < 0) {
+      cv::inRange(in.image, m_lowScalar, m_highScalar, out.image);
+    } else {
+      cv::cvtColor(in.image, m_converted, m_conversion);
+      cv::inRange(m_converted, m_lowScalar, m_highScalar, out.image);
+    }
+  }
+
+ private:
+  std::string m_space;
+  std::vector<double> m_low;
+  std::vector<double> m_high;
+  cv::Scalar m_lowScalar;
+  cv::Scalar m_highScalar;
+  int m_conversion = -1;
+  cv::Mat m_converted;
+};
+
+// "op" ("erode", "dilate", "open" or "close"), "kernel", "iterations"
+class MorphologyStage : public GraphPipeline::Stage {
+ public:
+  explicit MorphologyStage(const wpi::json& config)
+      : m_opName{config.at("op").get<std::string>()},
+        m_size{config.value("kernel", 3)},
+        m_iterations{config.value("iterations", 1)} {}
+
+  Kind Connect(Kind input, std::string& error) override {
+    if (m_opName == "erode") {
+      m_op = cv::MORPH_ERODE;
+    } else if (m_opName == "dilate") {
+      m_op = cv::MORPH_DILATE;
+    } else if (m_opName == "open") {
+      m_op = cv::MORPH_OPEN;
+    } else if (m_opName == "close") {
+      m_op = cv::MORPH_CLOSE;
+    } else {
+      error = fmt::format("unknown op '{}'", m_opName);
+      return Kind::kNone;
+    }
+    if (input != Kind::kMask && input != Kind::kGray) {
+      error = fmt::format("cannot {} {}", m_opName, KindName(input));
+      return Kind::kNone;
+    }
+    if (m_size <= 0 || m_iterations <= 0) {
+      error = "kernel and iterations must be positive";
+      return Kind::kNone;
+    }
+    m_kernel =
+        cv::getStructuringElement(cv::MORPH_RECT, cv::Size{m_size, m_size});
+    return input;
+  }
+
+  void Process(const Value& in, Value& out, uint64_t time) override {
+    cv::morphologyEx(in.image, out.image, m_op, m_kernel, cv::Point{-1, -1},
+                     m_iterations);
+  }
+
+ private:
+  std::string m_opName;
+  int m_size;
+  int m_iterations;
+  int m_op = cv::MORPH_ERODE;
+  cv::Mat m_kernel;
+};
+
+// "external" (false to also find holes)
+class ContoursStage : public GraphPipeline::Stage {
+ public:
+  explicit ContoursStage(const wpi::json& config)
+      : m_mode{config.value("external", true) ? cv::RETR_EXTERNAL
+                                              : cv::RETR_LIST} {}
+
+  Kind Connect(Kind input, std::string& error) override {
+    if (input != Kind::kMask) {
+      error = fmt::format("need a mask, not {}", KindName(input));
+      return Kind::kNone;
+    }
+    return Kind::kContours;
+  }
+
+  void Process(const Value& in, Value& out, uint64_t time) override {
+    cv::findContours(in.image, out.contours, m_mode, cv::CHAIN_APPROX_SIMPLE);
+    out.size = in.image.size();
+  }
+
+ private:
+  int m_mode;
+};
+
+// "min area", "max area", "min width", "max width", "min height",
+// "max height", "min ratio", "max ratio" (width / height), "min solidity",
+// "max solidity" (area / convex hull area)
+class FilterStage : public GraphPipeline::Stage {
+ public:
+  explicit FilterStage(const wpi::json& config) {
+    auto range = [&](std::string_view key, Range& range) {
+      range.min = config.value(fmt::format("min {}", key), range.min);
+      range.max = config.value(fmt::format("max {}", key), range.max);
+    };
+    range("area", m_area);
+    range("width", m_width);
+    range("height", m_height);
+    range("ratio", m_ratio);
+    range("solidity", m_solidity);
+  }
+
+  Kind Connect(Kind input, std::string& error) override {
+    if (input != Kind::kContours) {
+      error = fmt::format("need contours, not {}", KindName(input));
+      return Kind::kNone;
+    }
+    return Kind::kContours;
+  }
+
+  void Process(const Value& in, Value& out, uint64_t time) override {
+    out.contours.clear();
+    out.size = in.size;
+    for (auto&& contour : in.contours) {
+      cv::Rect box = cv::boundingRect(contour);
+      double area = cv::contourArea(contour);
+      if (!m_area.Contains(area) || !m_width.Contains(box.width) ||
+          !m_height.Contains(box.height) ||
+          !m_ratio.Contains(static_cast<double>(box.width) / box.height))
+        continue;
+      if (m_solidity.IsSet()) {
+        cv::convexHull(contour, m_hull);
+        double hullArea = cv::contourArea(m_hull);
+        if (!m_solidity.Contains(hullArea > 0 ? area / hullArea : 0)) continue;
+      }
+      out.contours.emplace_back(contour);
+    }
+  }
+
+ private:
+  struct Range {
+    double min = 0;
+    double max = std::numeric_limits<double>::infinity();
+
+    bool IsSet() const {
+      return min > 0 || max != std::numeric_limits<double>::infinity();
+    }
+    bool Contains(double value) const { return value >= min && value <= max; }
+  };
+
+  Range m_area;
+  Range m_width;
+  Range m_height;
+  Range m_ratio;
+  Range m_solidity;
+  std::vector<cv::Point> m_hull;
+};
+
+// "max count" (0 for all); largest contours first
+class PublishStage : public GraphPipeline::Stage {
+ public:
+  PublishStage(const wpi::json& config, nt::NetworkTableInstance inst,
+               std::string_view prefix)
+      : m_maxCount{config.value("max count", 0)} {
+    auto publish = [&](std::string_view key) {
+      return inst.GetDoubleArrayTopic(fmt::format("{}/{}", prefix, key))
+          .Publish();
+    };
+    m_centerXPub = publish("centerX");
+    m_centerYPub = publish("centerY");
+    m_widthPub = publish("width");
+    m_heightPub = publish("height");
+    m_areaPub = publish("area");
+  }
+
+  Kind Connect(Kind input, std::string& error) override {
+    if (input != Kind::kContours) {
+      error = fmt::format("need contours, not {}", KindName(input));
+      return Kind::kNone;
+    }
+    return Kind::kNone;
+  }
+
+  void Process(const Value& in, Value& out, uint64_t time) override {
+    size_t count = in.contours.size();
+    m_areas.resize(count);
+    m_order.resize(count);
+    for (size_t i = 0; i < count; ++i)
+      m_areas[i] = cv::contourArea(in.contours[i]);
+    std::iota(m_order.begin(), m_order.end(), 0);
+    std::stable_sort(m_order.begin(), m_order.end(), [&](size_t a, size_t b) {
+      return m_areas[a] > m_areas[b];
+    });
+    if (m_maxCount > 0 && count > static_cast<size_t>(m_maxCount))
+      count = m_maxCount;
+
+    m_centerX.clear();
+    m_centerY.clear();
+    m_width.clear();
+    m_height.clear();
+    m_area.clear();
+    out.contours.clear();  // kept for drawing on the output stream
+    out.size = in.size;
+    for (size_t i = 0; i < count; ++i) {
+      const auto& contour = in.contours[m_order[i]];
+      cv::Rect box = cv::boundingRect(contour);
+      m_centerX.emplace_back(box.x + box.width / 2.0);
+      m_centerY.emplace_back(box.y + box.height / 2.0);
+      m_width.emplace_back(box.width);
+      m_height.emplace_back(box.height);
+      m_area.emplace_back(m_areas[m_order[i]]);
+      out.contours.emplace_back(contour);
+    }
+
+    int64_t t = time;
+    m_centerXPub.Set(m_centerX, t);
+    m_centerYPub.Set(m_centerY, t);
+    m_widthPub.Set(m_width, t);
+    m_heightPub.Set(m_height, t);
+    m_areaPub.Set(m_area, t);
+  }
+
+ private:
+  int m_maxCount;
+  std::vector<double> m_areas;
+  std::vector<size_t> m_order;
+  std::vector<double> m_centerX;
+  std::vector<double> m_centerY;
+  std::vector<double> m_width;
+  std::vector<double> m_height;
+  std::vector<double> m_area;
+  nt::DoubleArrayPublisher m_centerXPub;
+  nt::DoubleArrayPublisher m_centerYPub;
+  nt::DoubleArrayPublisher m_widthPub;
+  nt::DoubleArrayPublisher m_heightPub;
+  nt::DoubleArrayPublisher m_areaPub;
+};
+
+// "points" (true to undistort contours instead of images), "cache"
+// (directory for the remap tables); needs the camera's "calibration"
+class UndistortStage : public GraphPipeline::Stage {
+ public:
+  UndistortStage(const wpi::json& config,
+                 const std::optional<CameraCalibration>& calibration)
+      : m_calibration{calibration},
+        m_points{config.value("points", false)},
+        m_cacheDir{config.value("cache",
+                                std::string{UndistortMap::kDefaultCacheDir})} {}
+
+  Kind Connect(Kind input, std::string& error) override {
+    if (!m_calibration || m_calibration->distortion.empty()) {
+      error = "needs the camera's calibration, with distortion";
+      return Kind::kNone;
+    }
+    if (m_points ? input != Kind::kContours : !IsImage(input)) {
+      error = fmt::format("need {}, not {}", m_points ? "contours" : "an image",
+                          KindName(input));
+      return Kind::kNone;
+    }
+    // keep masks binary
+    m_interpolation =
+        input == Kind::kMask ? cv::INTER_NEAREST : cv::INTER_LINEAR;
+    return input;
+  }
+
+  void Process(const Value& in, Value& out, uint64_t time) override {
+    if (m_points) {
+      // points are cheap to set up for, so there is nothing to cache
+      if (in.size != m_undistorter.GetSize())
+        m_undistorter.Init(*m_calibration, in.size);
+      out.contours.resize(in.contours.size());
+      for (size_t i = 0; i < in.contours.size(); ++i)
+        m_undistorter.Apply(in.contours[i], out.contours[i]);
+      out.size = in.size;
+      return;
+    }
+
+    // tables for the camera's resolution are built (or loaded) on the first
+    // frame, and again only if the resolution changes
+    if (in.image.size() != m_map.GetSize()) {
+      auto start = std::chrono::steady_clock::now();
+      bool cached = m_map.Init(*m_calibration, in.image.size(), m_cacheDir);
+      fmt::print(stderr, "undistort tables for {}x{} {} in {} ms\n",
+                 in.image.cols, in.image.rows, cached ? "loaded" : "built",
+                 std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count());
+    }
+    m_map.Apply(in.image, out.image, m_interpolation);
+  }
+
+ private:
+  std::optional<CameraCalibration> m_calibration;
+  bool m_points;
+  std::string m_cacheDir;
+  int m_interpolation = cv::INTER_LINEAR;
+  UndistortMap m_map;
+  PointUndistorter m_undistorter;
+};
+
+// "family" (default "tag36h11"), "decimate" (default 2), "threads"
+// (default one per core), "max hamming" (default 0), "min margin",
+// "tag size" (meters, default 0.1651), "field" (layout JSON, default the
+// current season's); poses need the camera's "calibration"
+class AprilTagStage : public GraphPipeline::Stage {
+ public:
+  AprilTagStage(const wpi::json& config,
+                const std::optional<CameraCalibration>& calibration,
+                nt::NetworkTableInstance inst, std::string_view prefix)
+      : m_detector{ReadConfig(config), calibration} {
+    auto publish = [&](std::string_view key) {
+      return inst.GetDoubleArrayTopic(fmt::format("{}/{}", prefix, key))
+          .Publish();
+    };
+    m_idsPub =
+        inst.GetIntegerArrayTopic(fmt::format("{}/ids", prefix)).Publish();
+    m_centerXPub = publish("centerX");
+    m_centerYPub = publish("centerY");
+    m_posesPub = publish("poses");
+    m_ambiguityPub = publish("ambiguity");
+    m_cameraPosePub = publish("cameraPose");
+  }
+
+  Kind Connect(Kind input, std::string& error) override {
+    if (input != Kind::kColor && input != Kind::kGray) {
+      error = fmt::format("need an image, not {}", KindName(input));
+      return Kind::kNone;
+    }
+    m_color = input == Kind::kColor;
+    m_detector.Init(error);
+    return Kind::kNone;
+  }
+
+  void Process(const Value& in, Value& out, uint64_t time) override {
+    if (m_color) {
+      cv::cvtColor(in.image, m_gray, cv::COLOR_BGR2GRAY);
+      m_detector.Detect(m_gray);
+    } else {
+      m_detector.Detect(in.image);
+    }
+
+    m_ids.clear();
+    m_centerX.clear();
+    m_centerY.clear();
+    m_poses.clear();
+    m_ambiguity.clear();
+    m_cameraPose.clear();
+    out.contours.clear();  // tag outlines, for the output stream
+    out.size = in.image.size();
+    for (auto&& tag : m_detector.GetTags()) {
+      m_ids.emplace_back(tag.id);
+      m_centerX.emplace_back(tag.center.x);
+      m_centerY.emplace_back(tag.center.y);
+      if (m_detector.HasPoses())
+        AppendPose(m_poses, tag.pose.Translation(), tag.pose.Rotation());
+      m_ambiguity.emplace_back(tag.ambiguity);
+      auto& outline = out.contours.emplace_back();
+      for (auto&& corner : tag.corners) outline.emplace_back(corner);
+    }
+    if (auto& pose = m_detector.GetCameraPose())
+      AppendPose(m_cameraPose, pose->Translation(), pose->Rotation());
+
+    int64_t t = time;
+    m_idsPub.Set(m_ids, t);
+    m_centerXPub.Set(m_centerX, t);
+    m_centerYPub.Set(m_centerY, t);
+    m_posesPub.Set(m_poses, t);
+    m_ambiguityPub.Set(m_ambiguity, t);
+    m_cameraPosePub.Set(m_cameraPose, t);
+  }
+
+ private:
+  static TagDetectorConfig ReadConfig(const wpi::json& config) {
+    TagDetectorConfig c;
+    c.family = config.value("family", c.family);
+    c.threads = config.value("threads", c.threads);
+    c.decimate = config.value("decimate", c.decimate);
+    c.maxHamming = config.value("max hamming", c.maxHamming);
+    c.minMargin = config.value("min margin", c.minMargin);
+    c.tagSize = config.value("tag size", c.tagSize);
+    c.field = config.value("field", c.field);
+    return c;
+  }
+
+  // x, y, z, then the rotation quaternion w, x, y, z
+  static void AppendPose(std::vector<double>& out,
+                         const frc::Translation3d& translation,
+                         const frc::Rotation3d& rotation) {
+    const auto& q = rotation.GetQuaternion();
+    out.insert(out.end(),
+               {translation.X().value(), translation.Y().value(),
+                translation.Z().value(), q.W(), q.X(), q.Y(), q.Z()});
+  }
+
+  TagDetector m_detector;
+  bool m_color = false;
+  cv::Mat m_gray;
+  std::vector<int64_t> m_ids;
+  std::vector<double> m_centerX;
+  std::vector<double> m_centerY;
+  std::vector<double> m_poses;
+  std::vector<double> m_ambiguity;
+  std::vector<double> m_cameraPose;
+  nt::IntegerArrayPublisher m_idsPub;
+  nt::DoubleArrayPublisher m_centerXPub;
+  nt::DoubleArrayPublisher m_centerYPub;
+  nt::DoubleArrayPublisher m_posesPub;
+  nt::DoubleArrayPublisher m_ambiguityPub;
+  nt::DoubleArrayPublisher m_cameraPosePub;
+};
+
+}  // namespace
+
+GraphPipeline::GraphPipeline(
+    std::string_view name, wpi::json stages, bool gray,
+    std::string_view output,
+    const std::optional<CameraCalibration>& calibration)
+    : m_name{name},
+      m_config{std::move(stages)},
+      m_gray{gray},
+      m_outputName{output},
+      m_calibration{calibration},
+      m_sink{fmt::format("pipeline {}", name),
+             gray ? cs::VideoMode::kGray : cs::VideoMode::kBGR} {}
+
+GraphPipeline::~GraphPipeline() = default;
+
+cs::MjpegServer GraphPipeline::AddOutputStream() {
+  m_output = cs::CvSource{m_name, cs::VideoMode::kBGR, 0, 0, 30};
+  return frc::CameraServer::StartAutomaticCapture(m_output);
+}
+
+bool GraphPipeline::Start(cs::VideoSource source,
+                          nt::NetworkTableInstance inst) {
+  m_inst = inst;
+  auto prefix = fmt::format("/multiCameraServer/pipelines/{}/", m_name);
+  m_errorPub = inst.GetStringTopic(prefix + "error").Publish();
+  m_skippedPub = inst.GetIntegerTopic(prefix + "skippedFrames").Publish();
+  m_skippedPub.Set(0);
+
+  std::string error;
+  if (!Build(error)) {
+    fmt::print(stderr, "pipeline '{}': {}\n", m_name, error);
+    m_errorPub.Set(error);
+    m_nodes.clear();
+    return false;
+  }
+  m_errorPub.Set("");
+
+  auto now = std::chrono::steady_clock::now();
+  for (auto&& node : m_nodes) {
+    node->timePub =
+        inst.GetDoubleTopic(prefix + "stages/" + node->name).Publish();
+    node->windowStart = now;
+  }
+
+  m_sink.SetSource(source);
+  std::thread([this] { GrabThreadMain(); }).detach();
+  for (auto&& node : m_nodes)
+    std::thread([this, &node = *node] { NodeThreadMain(node); }).detach();
+  return true;
+}
+
+bool GraphPipeline::Build(std::string& error) {
+  if (!m_config.is_array() || m_config.empty()) {
+    error = "stages must be a non-empty array";
+    return false;
+  }
+
+  std::vector<Kind> kinds;
+  Kind cameraKind = m_gray ? Kind::kGray : Kind::kColor;
+  for (auto&& config : m_config) {
+    auto node = std::make_unique<Node>();
+    int index = m_nodes.size();
+    node->index = index;
+    std::string type;
+    try {
+      node->name = config.at("name").get<std::string>();
+      type = config.at("type").get<std::string>();
+      std::string input = config.value(
+          "input", index == 0 ? std::string{"camera"} : m_nodes.back()->name);
+
+      if (node->name == "camera" || node->name.empty()) {
+        error = fmt::format("invalid stage name '{}'", node->name);
+        return false;
+      }
+      for (auto&& other : m_nodes) {
+        if (other->name == node->name) {
+          error = fmt::format("duplicate stage name '{}'", node->name);
+          return false;
+        }
+      }
+
+      // inputs must come first, so the stages always form a tree
+      if (input != "camera") {
+        auto it = std::find_if(m_nodes.begin(), m_nodes.end(),
+                               [&](auto& n) { return n->name == input; });
+        if (it == m_nodes.end()) {
+          error = fmt::format("stage '{}': input '{}' is not an earlier stage",
+                              node->name, input);
+          return false;
+        }
+        node->input = it - m_nodes.begin();
+      }
+
+      if (type == "resize") {
+        node->stage = std::make_unique<ResizeStage>(config);
+      } else if (type == "threshold") {
+        node->stage = std::make_unique<ThresholdStage>(config);
+      } else if (type == "morphology") {
+        node->stage = std::make_unique<MorphologyStage>(config);
+      } else if (type == "contours") {
+        node->stage = std::make_unique<ContoursStage>(config);
+      } else if (type == "filter") {
+        node->stage = std::make_unique<FilterStage>(config);
+      } else if (type == "publish") {
+        node->stage = std::make_unique<PublishStage>(
+            config, m_inst, fmt::format("/vision/{}/{}", m_name, node->name));
+      } else if (type == "undistort") {
+        node->stage = std::make_unique<UndistortStage>(config, m_calibration);
+      } else if (type == "apriltag") {
+        node->stage = std::make_unique<AprilTagStage>(
+            config, m_calibration, m_inst,
+            fmt::format("/vision/{}/{}", m_name, node->name));
+      } else {
+        error = fmt::format("stage '{}': unknown type '{}'", node->name, type);
+        return false;
+      }
+    } catch (const wpi::json::exception& e) {
+      error = fmt::format("stage {}: {}",
+                          node->name.empty() ? std::to_string(index)
+                                             : "'" + node->name + "'",
+                          e.what());
+      return false;
+    }
+
+    Kind input = node->input < 0 ? cameraKind : kinds[node->input];
+    std::string stageError;
+    Kind output = node->stage->Connect(input, stageError);
+    if (!stageError.empty()) {
+      error = fmt::format("stage '{}' ({}): {}", node->name, type, stageError);
+      return false;
+    }
+
+    if (node->input < 0)
+      m_roots.emplace_back(index);
+    else
+      m_nodes[node->input]->children.emplace_back(index);
+    kinds.emplace_back(output);
+    m_nodes.emplace_back(std::move(node));
+  }
+
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    if (kinds[i] == Kind::kNone && !m_nodes[i]->children.empty()) {
+      error = fmt::format("stage '{}' has no output for its inputs",
+                          m_nodes[i]->name);
+      return false;
+    }
+  }
+
+  // the output stream shows the chosen stage, or the last one
+  m_outputNode = m_nodes.size() - 1;
+  if (!m_outputName.empty()) {
+    auto it = std::find_if(m_nodes.begin(), m_nodes.end(),
+                           [&](auto& n) { return n->name == m_outputName; });
+    if (it == m_nodes.end()) {
+      error = fmt::format("output stage '{}' not found", m_outputName);
+      return false;
+    }
+    m_outputNode = it - m_nodes.begin();
+  }
+
+  // nearest color or grayscale image up the graph for drawing contours
+  m_drawBase = m_nodes[m_outputNode]->input;
+  while (m_drawBase >= 0 && kinds[m_drawBase] != Kind::kColor &&
+         kinds[m_drawBase] != Kind::kGray)
+    m_drawBase = m_nodes[m_drawBase]->input;
+  return true;
+}
+
+void GraphPipeline::GrabThreadMain() {
+  for (;;) {
+    auto frame = std::make_shared<Frame>();
+    frame->outputs.resize(m_nodes.size());
+    frame->time = m_sink.GrabFrame(frame->camera.image);
+    if (frame->time == 0) {
+      fmt::print(stderr, "pipeline '{}': {}\n", m_name, m_sink.GetError());
+      continue;
+    }
+    if (m_captureTime) frame->time = m_captureTime(frame->time);
+
+    // the newest frame replaces one a busy first stage hasn't started yet
+    bool skipped = false;
+    for (int root : m_roots) {
+      if (!m_nodes[root]->queue.Push(frame, true)) skipped = true;
+    }
+    if (skipped) m_skippedPub.Set(++m_skipped);
+  }
+}
+
+void GraphPipeline::NodeThreadMain(Node& node) {
+  for (;;) {
+    FramePtr frame = node.queue.Pop();
+    const Value& in =
+        node.input < 0 ? frame->camera : frame->outputs[node.input];
+
+    auto start = std::chrono::steady_clock::now();
+    node.stage->Process(in, frame->outputs[node.index], frame->time);
+    auto end = std::chrono::steady_clock::now();
+
+    node.busy += end - start;
+    ++node.frames;
+    if (end - node.windowStart >= std::chrono::seconds{1}) {
+      node.timePub.Set(
+          std::chrono::duration<double, std::milli>(node.busy).count() /
+          node.frames);
+      node.busy = std::chrono::steady_clock::duration::zero();
+      node.frames = 0;
+      node.windowStart = end;
+    }
+
+    if (node.index == m_outputNode && m_output) PutOutput(*frame);
+
+    // waits while a child is still busy with the previous frame
+    for (int child : node.children) m_nodes[child]->queue.Push(frame, false);
+  }
+}
+
+void GraphPipeline::PutOutput(Frame& frame) {
+  Value& out = frame.outputs[m_outputNode];
+  if (!out.image.empty()) {
+    m_output.PutFrame(out.image);
+    return;
+  }
+
+  // contours are drawn on the image they were found in
+  cv::Mat& base = m_drawBase < 0 ? frame.camera.image
+                                 : frame.outputs[m_drawBase].image;
+  if (base.channels() == 1)
+    cv::cvtColor(base, m_canvas, cv::COLOR_GRAY2BGR);
+  else
+    base.copyTo(m_canvas);
+  cv::drawContours(m_canvas, out.contours, -1, cv::Scalar{0, 255, 0}, 2);
+  m_output.PutFrame(m_canvas);
+}
+
+bool GraphPipeline::FrameQueue::Push(FramePtr frame, bool replace) {
+  std::unique_lock lock{m_mutex};
+  if (replace && m_frame) {
+    m_frame = std::move(frame);
+    return false;
+  }
+  m_cv.wait(lock, [&] { return !m_frame; });
+  m_frame = std::move(frame);
+  m_cv.notify_all();
+  return true;
+}
+
+GraphPipeline::FramePtr GraphPipeline::FrameQueue::Pop() {
+  std::unique_lock lock{m_mutex};
+  m_cv.wait(lock, [&] { return static_cast<bool>(m_frame); });
+  FramePtr frame = std::move(m_frame);
+  m_cv.notify_all();
+  return frame;
+}
@@ -0,0 +1,145 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_GRAPHPIPELINE_H_
+#define MULTICAMERASERVER_GRAPHPIPELINE_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cscore_cv.h>
+#include <networktables/DoubleTopic.h>
+#include <networktables/IntegerTopic.h>
+#include <networktables/NetworkTableInstance.h>
+#include <networktables/StringTopic.h>
+#include <opencv2/core/core.hpp>
+#include <wpi/json.h>
+
+#include "CameraCalibration.h"
+
+/*
+   Runs a pipeline described in frc.json as a graph of built-in stages, so
+   simple target pipelines need no code at all.
+
+   Each stage names its input: the camera or any earlier stage (by default
+   the previous one), so the stages form a tree fed by the camera.  Stage
+   types are resize, undistort, threshold, morphology, contours, filter,
+   publish and apriltag; see the JSON format in multiCameraServer.cpp for
+   their settings.
+
+   Every stage runs on its own thread and hands each frame's result to the
+   stages that use it through a one-frame queue, so stages work on
+   consecutive frames at the same time: while one frame's contours are
+   filtered, the next one is already being thresholded.  The throughput is
+   set by the slowest stage rather than the sum of all of them.  When the
+   first stage is still busy, the camera's newest frame replaces the one
+   waiting for it; replaced frames are published to
+   /multiCameraServer/pipelines/<name>/skippedFrames.
+
+   The mean processing time of each stage over the last second is published
+   to /multiCameraServer/pipelines/<name>/stages/<stage> in milliseconds.
+   Publish stages write center, size and area arrays of their contours to
+   /vision/<name>/<stage>/, timestamped with the frame capture time, and
+   apriltag stages write the ids, centers and poses of the tags they find
+   (see TagDetector.h) the same way.  An invalid graph is reported to
+   /multiCameraServer/pipelines/<name>/error.
+ */
+class GraphPipeline {
+ public:
+  // output is the stage shown on the output stream, the last if empty;
+  // calibration is the camera's, for stages that undistort or estimate
+  // poses
+  GraphPipeline(std::string_view name, wpi::json stages, bool gray,
+                std::string_view output,
+                const std::optional<CameraCalibration>& calibration = {});
+  ~GraphPipeline();
+
+  GraphPipeline(const GraphPipeline&) = delete;
+  GraphPipeline& operator=(const GraphPipeline&) = delete;
+
+  // serves the output stage's results as a stream; call before Start()
+  cs::MjpegServer AddOutputStream();
+
+  // maps the time CvSink::GrabFrame returns to the frame's capture time,
+  // for cameras that know it (see LatencyCamera.h); call before Start()
+  void SetCaptureTimes(std::function<uint64_t(uint64_t)> captureTime) {
+    m_captureTime = std::move(captureTime);
+  }
+
+  // builds the graph and starts processing; returns false (and processes
+  // nothing) if the graph is invalid
+  bool Start(cs::VideoSource source, nt::NetworkTableInstance inst);
+
+  class Stage;
+  struct Frame;
+  using FramePtr = std::shared_ptr<Frame>;
+
+ private:
+  // hands frames from one thread to the next, at most one waiting
+  class FrameQueue {
+   public:
+    // waits for room; if replace, drops the waiting frame instead and
+    // returns false
+    bool Push(FramePtr frame, bool replace);
+    FramePtr Pop();
+
+   private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    FramePtr m_frame;
+  };
+
+  struct Node {
+    std::string name;
+    int index = 0;
+    int input = -1;  // node index, or -1 for the camera
+    std::unique_ptr<Stage> stage;
+    std::vector<int> children;
+    FrameQueue queue;
+
+    // processing time, node thread only
+    nt::DoublePublisher timePub;
+    std::chrono::steady_clock::duration busy{0};
+    int frames = 0;
+    std::chrono::steady_clock::time_point windowStart;
+  };
+
+  bool Build(std::string& error);
+  void GrabThreadMain();
+  void NodeThreadMain(Node& node);
+  void PutOutput(Frame& frame);
+
+  std::string m_name;
+  wpi::json m_config;
+  bool m_gray;
+  std::string m_outputName;
+  std::optional<CameraCalibration> m_calibration;
+
+  cs::CvSink m_sink;
+  std::function<uint64_t(uint64_t)> m_captureTime;
+  cs::CvSource m_output;
+  int m_outputNode = -1;
+  int m_drawBase = -1;  // node whose image contours are drawn on, or camera
+  cv::Mat m_canvas;     // output node thread only
+
+  nt::NetworkTableInstance m_inst;
+  nt::StringPublisher m_errorPub;
+  nt::IntegerPublisher m_skippedPub;
+  int64_t m_skipped = 0;  // grab thread only
+
+  std::vector<std::unique_ptr<Node>> m_nodes;
+  std::vector<int> m_roots;  // nodes fed by the camera
+};
+
+#endif  // MULTICAMERASERVER_GRAPHPIPELINE_H_
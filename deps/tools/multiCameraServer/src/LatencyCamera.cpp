@@ -0,0 +1,385 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "LatencyCamera.h"
+
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+#include <fmt/format.h>
+#include <networktables/NetworkTableInstance.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <wpi/StringExtras.h>
+#include <wpi/timestamp.h>
+
+namespace {
+
+// the minimum most drivers accept; one being filled while one is delivered
+constexpr unsigned int kNumBuffers = 2;
+
+int xioctl(int fd, unsigned long req, void* arg) {
+  int rv;
+  do {
+    rv = ioctl(fd, req, arg);
+  } while (rv == -1 && errno == EINTR);
+  return rv;
+}
+
+uint32_t ToV4L2PixelFormat(std::string_view str) {
+  if (wpi::equals_lower(str, "mjpeg")) return V4L2_PIX_FMT_MJPEG;
+  if (wpi::equals_lower(str, "yuyv")) return V4L2_PIX_FMT_YUYV;
+  if (wpi::equals_lower(str, "rgb565")) return V4L2_PIX_FMT_RGB565;
+  if (wpi::equals_lower(str, "bgr")) return V4L2_PIX_FMT_BGR24;
+  if (wpi::equals_lower(str, "gray")) return V4L2_PIX_FMT_GREY;
+  return 0;
+}
+
+// same normalization cscore uses for property names
+std::string NormalizeName(std::string_view name) {
+  std::string out;
+  bool sep = false;
+  for (char ch : name) {
+    if (std::isalnum(static_cast<unsigned char>(ch))) {
+      if (sep && !out.empty()) out += '_';
+      sep = false;
+      out += std::tolower(static_cast<unsigned char>(ch));
+    } else {
+      sep = true;
+    }
+  }
+  return out;
+}
+
+int64_t MonotonicMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+}  // namespace
+
+LatencyCamera::LatencyCamera(std::string_view name, std::string_view path,
+                             const wpi::json& config)
+    : m_name{name}, m_path{path}, m_config{config} {
+  if (config.count("pixel format") != 0) {
+    auto str = config.at("pixel format").get<std::string>();
+    m_pixelFormat = ToV4L2PixelFormat(str);
+    if (m_pixelFormat == 0)
+      fmt::print(stderr, "camera '{}': unknown pixel format '{}'\n", m_name,
+                 str);
+  }
+  m_width = config.value("width", 0);
+  m_height = config.value("height", 0);
+  m_fps = config.value("fps", 0);
+
+  m_source = cs::CvSource{name, cs::VideoMode::kBGR,
+                          m_width ? m_width : 640, m_height ? m_height : 480,
+                          m_fps ? m_fps : 30};
+
+  auto inst = nt::NetworkTableInstance::GetDefault();
+  m_captureTimePub =
+      inst.GetIntegerTopic(
+              fmt::format("/multiCameraServer/{}/captureTime", m_name))
+          .Publish();
+  m_staleFramesPub =
+      inst.GetIntegerTopic(
+              fmt::format("/multiCameraServer/{}/staleFrames", m_name))
+          .Publish();
+
+  // thread names are limited to 15 characters
+  m_threadName = fmt::format("capture {}", m_name).substr(0, 15);
+  m_thread = std::thread(&LatencyCamera::ThreadMain, this);
+  pthread_setname_np(m_thread.native_handle(), m_threadName.c_str());
+}
+
+LatencyCamera::~LatencyCamera() {
+  m_active = false;
+  if (m_thread.joinable()) m_thread.join();
+}
+
+void LatencyCamera::ThreadMain() {
+  while (m_active) {
+    if (m_fd < 0 && !Open()) {
+      Close();
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+      continue;
+    }
+
+    struct pollfd pfd = {m_fd, POLLIN, 0};
+    int rv = poll(&pfd, 1, 1000);
+    if (rv == 0 || (rv == -1 && errno == EINTR)) continue;
+    if (rv == -1 || (pfd.revents & (POLLERR | POLLHUP))) {
+      Close();
+      continue;
+    }
+
+    // drain all completed buffers, keeping only the newest
+    struct v4l2_buffer newest;
+    bool haveNewest = false;
+    bool error = false;
+    for (;;) {
+      struct v4l2_buffer buf;
+      std::memset(&buf, 0, sizeof(buf));
+      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf.memory = V4L2_MEMORY_MMAP;
+      if (xioctl(m_fd, VIDIOC_DQBUF, &buf) == -1) {
+        if (errno != EAGAIN) error = true;
+        break;
+      }
+      if (buf.flags & V4L2_BUF_FLAG_ERROR) {
+        xioctl(m_fd, VIDIOC_QBUF, &buf);
+        continue;
+      }
+      if (haveNewest) {
+        xioctl(m_fd, VIDIOC_QBUF, &newest);
+        ++m_staleFrames;
+      }
+      newest = buf;
+      haveNewest = true;
+    }
+    if (error) {
+      fmt::print(stderr, "camera '{}': dequeue failed: {}\n", m_name,
+                 std::strerror(errno));
+      Close();
+      continue;
+    }
+    if (!haveNewest) continue;
+
+    // convert driver timestamp to wpi::Now() time base
+    int64_t captureTime = wpi::Now();
+    if ((newest.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) ==
+        V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+      int64_t driverTime =
+          static_cast<int64_t>(newest.timestamp.tv_sec) * 1000000 +
+          newest.timestamp.tv_usec;
+      captureTime -= MonotonicMicros() - driverTime;
+    }
+
+    DeliverFrame(m_buffers[newest.index], newest.bytesused, captureTime);
+    if (xioctl(m_fd, VIDIOC_QBUF, &newest) == -1) Close();
+  }
+  Close();
+}
+
+bool LatencyCamera::Open() {
+  m_fd = open(m_path.c_str(), O_RDWR | O_NONBLOCK);
+  if (m_fd < 0) return false;
+
+  // video mode
+  struct v4l2_format vfmt;
+  std::memset(&vfmt, 0, sizeof(vfmt));
+  vfmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (xioctl(m_fd, VIDIOC_G_FMT, &vfmt) == -1) return false;
+  if (m_pixelFormat != 0) vfmt.fmt.pix.pixelformat = m_pixelFormat;
+  if (m_width != 0) vfmt.fmt.pix.width = m_width;
+  if (m_height != 0) vfmt.fmt.pix.height = m_height;
+  if (xioctl(m_fd, VIDIOC_S_FMT, &vfmt) == -1) {
+    fmt::print(stderr, "camera '{}': could not set format: {}\n", m_name,
+               std::strerror(errno));
+    return false;
+  }
+  m_pixelFormat = vfmt.fmt.pix.pixelformat;
+  m_width = vfmt.fmt.pix.width;
+  m_height = vfmt.fmt.pix.height;
+  m_stride = vfmt.fmt.pix.bytesperline;
+
+  if (m_fps != 0) {
+    struct v4l2_streamparm parm;
+    std::memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = m_fps;
+    xioctl(m_fd, VIDIOC_S_PARM, &parm);
+  }
+
+  ApplyControls();
+
+  // minimal buffer queue
+  struct v4l2_requestbuffers req;
+  std::memset(&req, 0, sizeof(req));
+  req.count = kNumBuffers;
+  req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  req.memory = V4L2_MEMORY_MMAP;
+  if (xioctl(m_fd, VIDIOC_REQBUFS, &req) == -1 || req.count < 1) {
+    fmt::print(stderr, "camera '{}': could not allocate buffers: {}\n",
+               m_name, std::strerror(errno));
+    return false;
+  }
+  for (unsigned int i = 0; i < req.count; ++i) {
+    struct v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = i;
+    if (xioctl(m_fd, VIDIOC_QUERYBUF, &buf) == -1) return false;
+    void* data = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      m_fd, buf.m.offset);
+    if (data == MAP_FAILED) return false;
+    m_buffers.push_back({data, buf.length});
+    if (xioctl(m_fd, VIDIOC_QBUF, &buf) == -1) return false;
+  }
+
+  enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (xioctl(m_fd, VIDIOC_STREAMON, &type) == -1) {
+    fmt::print(stderr, "camera '{}': could not start streaming: {}\n", m_name,
+               std::strerror(errno));
+    return false;
+  }
+
+  m_source.SetVideoMode(cs::VideoMode::kBGR, m_width, m_height,
+                        m_fps ? m_fps : 30);
+  fmt::print("camera '{}': latency mode {}x{} with {} buffers\n", m_name,
+             m_width, m_height, m_buffers.size());
+  return true;
+}
+
+void LatencyCamera::Close() {
+  if (m_fd < 0) return;
+  enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  xioctl(m_fd, VIDIOC_STREAMOFF, &type);
+  for (auto&& buf : m_buffers) munmap(buf.data, buf.length);
+  m_buffers.clear();
+  close(m_fd);
+  m_fd = -1;
+}
+
+bool LatencyCamera::SetControl(std::string_view name, int value,
+                               bool percentage) {
+  struct v4l2_queryctrl qc;
+  std::memset(&qc, 0, sizeof(qc));
+  qc.id = V4L2_CTRL_FLAG_NEXT_CTRL;
+  while (xioctl(m_fd, VIDIOC_QUERYCTRL, &qc) == 0) {
+    if (!(qc.flags & V4L2_CTRL_FLAG_DISABLED) &&
+        NormalizeName(reinterpret_cast<const char*>(qc.name)) == name) {
+      // integer controls are set as a percentage of their range like cscore
+      if (percentage && qc.type == V4L2_CTRL_TYPE_INTEGER)
+        value = qc.minimum + (qc.maximum - qc.minimum) * value / 100;
+      struct v4l2_control ctrl = {qc.id, value};
+      if (xioctl(m_fd, VIDIOC_S_CTRL, &ctrl) == -1) {
+        fmt::print(stderr, "camera '{}': could not set {}: {}\n", m_name,
+                   name, std::strerror(errno));
+        return false;
+      }
+      return true;
+    }
+    qc.id |= V4L2_CTRL_FLAG_NEXT_CTRL;
+  }
+  return false;
+}
+
+void LatencyCamera::ApplyControls() {
+  try {
+    if (m_config.count("brightness") != 0)
+      SetControl("brightness", m_config.at("brightness").get<int>(), true);
+
+    // older and newer kernels name the auto controls differently
+    if (m_config.count("white balance") != 0) {
+      auto& wb = m_config.at("white balance");
+      bool isAuto =
+          wb.is_string() && wpi::equals_lower(wb.get<std::string>(), "auto");
+      if (!SetControl("white_balance_temperature_auto", isAuto))
+        SetControl("white_balance_automatic", isAuto);
+      if (wb.is_number())
+        SetControl("white_balance_temperature", wb.get<int>());
+    }
+
+    if (m_config.count("exposure") != 0) {
+      auto& ex = m_config.at("exposure");
+      bool isAuto =
+          ex.is_string() && wpi::equals_lower(ex.get<std::string>(), "auto");
+      int mode =
+          isAuto ? V4L2_EXPOSURE_APERTURE_PRIORITY : V4L2_EXPOSURE_MANUAL;
+      if (!SetControl("exposure_auto", mode)) SetControl("auto_exposure", mode);
+      if (ex.is_number() &&
+          !SetControl("exposure_absolute", ex.get<int>(), true))
+        SetControl("exposure_time_absolute", ex.get<int>(), true);
+    }
+
+    if (m_config.count("properties") != 0) {
+      for (auto&& prop : m_config.at("properties")) {
+        auto name = prop.at("name").get<std::string>();
+        auto& value = prop.at("value");
+        if (!value.is_number() && !value.is_boolean()) continue;
+        int v = value.is_boolean() ? value.get<bool>() : value.get<int>();
+        if (wpi::starts_with(name, "raw_"))
+          SetControl(wpi::substr(name, 4), v);
+        else
+          SetControl(name, v, true);
+      }
+    }
+  } catch (const wpi::json::exception& e) {
+    fmt::print(stderr, "camera '{}': could not read settings: {}\n", m_name,
+               e.what());
+  }
+}
+
+uint64_t LatencyCamera::GetCaptureTime(uint64_t frameTime) const {
+  std::scoped_lock lock{m_deliveriesMutex};
+  for (auto&& delivery : m_deliveries) {
+    if (delivery.putStart != 0 && frameTime >= delivery.putStart &&
+        frameTime <= delivery.putEnd)
+      return delivery.captureTime;
+  }
+  return frameTime;
+}
+
+bool LatencyCamera::DeliverFrame(const Buffer& buf, size_t bytesused,
+                                 int64_t captureTime) {
+  switch (m_pixelFormat) {
+    case V4L2_PIX_FMT_MJPEG:
+      cv::imdecode(cv::Mat{1, static_cast<int>(bytesused), CV_8UC1, buf.data},
+                   cv::IMREAD_COLOR, &m_frame);
+      break;
+    case V4L2_PIX_FMT_YUYV:
+      cv::cvtColor(cv::Mat{m_height, m_width, CV_8UC2, buf.data, m_stride},
+                   m_frame, cv::COLOR_YUV2BGR_YUYV);
+      break;
+    case V4L2_PIX_FMT_RGB565:
+      cv::cvtColor(cv::Mat{m_height, m_width, CV_8UC2, buf.data, m_stride},
+                   m_frame, cv::COLOR_BGR5652BGR);
+      break;
+    case V4L2_PIX_FMT_BGR24:
+      cv::Mat{m_height, m_width, CV_8UC3, buf.data, m_stride}.copyTo(m_frame);
+      break;
+    case V4L2_PIX_FMT_GREY:
+      cv::Mat{m_height, m_width, CV_8UC1, buf.data, m_stride}.copyTo(m_frame);
+      break;
+    default:
+      return false;
+  }
+  if (m_frame.empty()) return false;
+
+  // the interval is recorded open-ended first, as a sink may grab the
+  // frame before PutFrame returns
+  Delivery* delivery;
+  {
+    std::scoped_lock lock{m_deliveriesMutex};
+    delivery = &m_deliveries[m_nextDelivery];
+    m_nextDelivery = (m_nextDelivery + 1) % kNumDeliveries;
+    *delivery = {wpi::Now(), std::numeric_limits<uint64_t>::max(),
+                 captureTime};
+  }
+  m_source.PutFrame(m_frame);
+  {
+    std::scoped_lock lock{m_deliveriesMutex};
+    delivery->putEnd = wpi::Now();
+  }
+  m_lastCaptureTime = captureTime;
+  m_captureTimePub.Set(captureTime, captureTime);
+  m_staleFramesPub.Set(m_staleFrames);
+  return true;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_LATENCYCAMERA_H_
+#define MULTICAMERASERVER_LATENCYCAMERA_H_
+
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <cscore_cv.h>
+#include <networktables/IntegerTopic.h>
+#include <opencv2/core/core.hpp>
+#include <wpi/json.h>
+
+/*
+   USB camera captured directly through V4L2 for "latency mode".
+
+   cscore's UsbCamera keeps several buffers queued in the driver and hands
+   out frames in order, so a frame can be several frame periods old by the
+   time it is delivered.  This camera queues the minimum number of buffers,
+   drains every completed buffer on each wakeup, and only delivers the newest
+   one; older ones are requeued and counted as stale.
+
+   cscore stamps each frame with the time it is put to the CvSource, as
+   CvSource::PutFrame has no way to pass another time, so CvSink::GrabFrame
+   returns the delivery time rather than the driver capture time.
+   GetCaptureTime maps a time GrabFrame returned back to the capture time
+   (in wpi::Now() / NetworkTables local time) of that frame; the pipelines
+   of this server use it, so their results are stamped with the capture
+   time.
+
+   The capture time of the most recently delivered frame is also published
+   to /multiCameraServer/<name>/captureTime, with the NT value timestamp
+   also set to the capture time.  It is only the latest frame's, so it
+   can't be matched to the frame a slower consumer is working on.  The
+   stale count is published to /multiCameraServer/<name>/staleFrames.
+ */
+class LatencyCamera {
+ public:
+  LatencyCamera(std::string_view name, std::string_view path,
+                const wpi::json& config);
+  ~LatencyCamera();
+
+  LatencyCamera(const LatencyCamera&) = delete;
+  LatencyCamera& operator=(const LatencyCamera&) = delete;
+
+  cs::CvSource GetSource() const { return m_source; }
+
+  // name of the capture thread, for RealTime::PromoteNamedThreads
+  const std::string& GetThreadName() const { return m_threadName; }
+
+  // capture time (wpi::Now() base) of the most recently delivered frame
+  int64_t GetLastCaptureTime() const { return m_lastCaptureTime; }
+
+  // capture time of the frame CvSink::GrabFrame returned frameTime for; if
+  // the frame is too old to be remembered, frameTime itself
+  uint64_t GetCaptureTime(uint64_t frameTime) const;
+
+  // total frames discarded because a newer frame was available
+  int64_t GetStaleFrames() const { return m_staleFrames; }
+
+ private:
+  struct Buffer {
+    void* data = nullptr;
+    size_t length = 0;
+  };
+
+  // cscore stamps a frame with wpi::Now() somewhere in [putStart, putEnd]
+  struct Delivery {
+    uint64_t putStart = 0;
+    uint64_t putEnd = 0;
+    int64_t captureTime = 0;
+  };
+  // frames a consumer may still be grabbing
+  static constexpr size_t kNumDeliveries = 8;
+
+  void ThreadMain();
+  bool Open();
+  void Close();
+  void ApplyControls();
+  bool SetControl(std::string_view name, int value, bool percentage = false);
+  bool DeliverFrame(const Buffer& buf, size_t bytesused, int64_t captureTime);
+
+  std::string m_name;
+  std::string m_path;
+  std::string m_threadName;
+  wpi::json m_config;
+
+  uint32_t m_pixelFormat = 0;
+  int m_width = 0;
+  int m_height = 0;
+  int m_fps = 0;
+  size_t m_stride = 0;
+
+  int m_fd = -1;
+  std::vector<Buffer> m_buffers;
+  cv::Mat m_frame;
+
+  cs::CvSource m_source;
+  nt::IntegerPublisher m_captureTimePub;
+  nt::IntegerPublisher m_staleFramesPub;
+
+  mutable std::mutex m_deliveriesMutex;
+  std::array<Delivery, kNumDeliveries> m_deliveries;
+  size_t m_nextDelivery = 0;
+
+  std::atomic<int64_t> m_lastCaptureTime{0};
+  std::atomic<int64_t> m_staleFrames{0};
+  std::atomic_bool m_active{true};
+  std::thread m_thread;
+};
+
+#endif  // MULTICAMERASERVER_LATENCYCAMERA_H_
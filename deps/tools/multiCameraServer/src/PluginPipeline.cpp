@@ -0,0 +1,296 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "PluginPipeline.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "cameraserver/CameraServer.h"
+
+namespace {
+
+// more inotify events within this time are treated as the same update
+constexpr int kSettleMs = 200;
+
+// capture time of the frame being processed on this thread (0 during create)
+thread_local int64_t currentCaptureTime = 0;
+
+}  // namespace
+
+struct PluginPipeline::Loaded {
+  int fd = -1;  // memfd copy; kept open so every build has a unique path
+  void* handle = nullptr;
+  const frcvision_plugin* plugin = nullptr;
+  void* instance = nullptr;
+  int generation = 0;
+};
+
+void PluginPipeline::LoadedDeleter::operator()(Loaded* loaded) const {
+  if (loaded->instance) loaded->plugin->destroy(loaded->instance);
+  if (loaded->handle) dlclose(loaded->handle);
+  if (loaded->fd != -1) close(loaded->fd);
+  delete loaded;
+}
+
+PluginPipeline::PluginPipeline(std::string_view name,
+                               std::string_view pluginPath,
+                               std::string config, bool gray)
+    : m_name{name},
+      m_pluginPath{pluginPath},
+      m_config{std::move(config)},
+      m_gray{gray},
+      m_sink{fmt::format("pipeline {}", name),
+             gray ? cs::VideoMode::kGray : cs::VideoMode::kBGR} {
+  m_host.ctx = this;
+  m_host.publish_double = PublishDouble;
+  m_host.publish_double_array = PublishDoubleArray;
+  m_host.publish_string = PublishString;
+  m_host.log = Log;
+}
+
+cs::MjpegServer PluginPipeline::AddOutputStream() {
+  m_output = cs::CvSource{m_name, m_gray ? cs::VideoMode::kGray
+                                         : cs::VideoMode::kBGR,
+                          0, 0, 30};
+  return frc::CameraServer::StartAutomaticCapture(m_output);
+}
+
+bool PluginPipeline::Start(cs::VideoSource source,
+                           nt::NetworkTableInstance inst) {
+  m_inst = inst;
+  auto prefix = fmt::format("/multiCameraServer/pipelines/{}/", m_name);
+  m_pluginPub = inst.GetStringTopic(prefix + "plugin").Publish();
+  m_generationPub = inst.GetIntegerTopic(prefix + "generation").Publish();
+  m_errorPub = inst.GetStringTopic(prefix + "error").Publish();
+  m_errorPub.Set("");
+
+  m_current = Load();
+  m_sink.SetSource(source);
+
+  std::thread([this] { ProcessThreadMain(); }).detach();
+  std::thread([this] { WatchThreadMain(); }).detach();
+  return static_cast<bool>(m_current);
+}
+
+PluginPipeline::LoadedPtr PluginPipeline::Load() {
+  auto fail = [&](std::string_view msg) {
+    fmt::print(stderr, "pipeline '{}': {}: {}\n", m_name, m_pluginPath, msg);
+    m_errorPub.Set(fmt::format("{}: {}", m_pluginPath, msg));
+    return nullptr;
+  };
+
+  LoadedPtr loaded{new Loaded};
+
+  // copy the file so a later upload can't change the build under us
+  int in = open(m_pluginPath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in == -1) return fail(std::strerror(errno));
+  struct stat st;
+  if (fstat(in, &st) == -1) {
+    close(in);
+    return fail(std::strerror(errno));
+  }
+  loaded->fd = memfd_create("frcvision-plugin", MFD_CLOEXEC);
+  if (loaded->fd == -1) {
+    close(in);
+    return fail(std::strerror(errno));
+  }
+  off_t offset = 0;
+  while (offset < st.st_size) {
+    ssize_t n = sendfile(loaded->fd, in, &offset, st.st_size - offset);
+    if (n <= 0) {
+      if (n == -1 && errno == EINTR) continue;
+      close(in);
+      return fail(n == 0 ? "file truncated" : std::strerror(errno));
+    }
+  }
+  close(in);
+
+  auto path = fmt::format("/proc/self/fd/{}", loaded->fd);
+  loaded->handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!loaded->handle) return fail(dlerror());
+
+  auto entry = reinterpret_cast<frcvision_plugin_entry>(
+      dlsym(loaded->handle, "frcvision_plugin_get"));
+  if (!entry) return fail("no frcvision_plugin_get entry point");
+  loaded->plugin = entry();
+  if (!loaded->plugin) return fail("frcvision_plugin_get returned NULL");
+  if (loaded->plugin->abi_version != FRCVISION_PLUGIN_ABI_VERSION) {
+    return fail(fmt::format("ABI version {}, expected {}",
+                            loaded->plugin->abi_version,
+                            FRCVISION_PLUGIN_ABI_VERSION));
+  }
+  if (!loaded->plugin->create || !loaded->plugin->process ||
+      !loaded->plugin->destroy)
+    return fail("missing create, process or destroy");
+
+  loaded->instance = loaded->plugin->create(&m_host, m_config.c_str());
+  if (!loaded->instance) return fail("create failed");
+
+  loaded->generation = ++m_generation;
+  const char* pluginName = loaded->plugin->name ? loaded->plugin->name : "";
+  fmt::print("pipeline '{}': loaded '{}' from {} (generation {})\n", m_name,
+             pluginName, m_pluginPath, loaded->generation);
+  m_pluginPub.Set(pluginName);
+  m_generationPub.Set(loaded->generation);
+  m_errorPub.Set("");
+  return loaded;
+}
+
+void PluginPipeline::ProcessThreadMain() {
+  for (;;) {
+    uint64_t time = m_sink.GrabFrame(m_frame);
+
+    // swap between frames; the old build is destroyed and unloaded here so
+    // process and destroy happen on the same thread
+    LoadedPtr old;
+    {
+      std::scoped_lock lock{m_pendingMutex};
+      if (m_pending) {
+        old = std::move(m_current);
+        m_current = std::move(m_pending);
+      }
+    }
+    old.reset();
+
+    if (time == 0) {
+      fmt::print(stderr, "pipeline '{}': {}\n", m_name, m_sink.GetError());
+      continue;
+    }
+    if (!m_current) continue;
+    if (m_captureTime) time = m_captureTime(time);
+
+    frcvision_image image;
+    image.data = m_frame.data;
+    image.width = m_frame.cols;
+    image.height = m_frame.rows;
+    image.stride = m_frame.step;
+    image.format = m_gray ? FRCVISION_PIXEL_GRAY : FRCVISION_PIXEL_BGR;
+    currentCaptureTime = time;
+    m_current->plugin->process(m_current->instance, &image, time);
+
+    if (m_output) m_output.PutFrame(m_frame);
+  }
+}
+
+void PluginPipeline::WatchThreadMain() {
+  // watch the directory, as uploads replace the file by renaming over it
+  auto slash = m_pluginPath.rfind('/');
+  std::string dir = ".";
+  std::string file = m_pluginPath;
+  if (slash != std::string::npos) {
+    dir = m_pluginPath.substr(0, slash);
+    file = m_pluginPath.substr(slash + 1);
+  }
+
+  int fd = inotify_init1(IN_CLOEXEC);
+  if (fd == -1 ||
+      inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+    fmt::print(stderr, "pipeline '{}': cannot watch {}: {}\n", m_name, dir,
+               std::strerror(errno));
+    if (fd != -1) close(fd);
+    return;
+  }
+
+  alignas(struct inotify_event) char buf[4096];
+  bool changed = false;
+  for (;;) {
+    // once changed, wait for the writes to settle before loading
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int rv = poll(&pfd, 1, changed ? kSettleMs : -1);
+    if (rv == -1) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    if (rv == 0) {
+      changed = false;
+      if (auto loaded = Load()) {
+        std::scoped_lock lock{m_pendingMutex};
+        // a build replaced before it was swapped in is unloaded here
+        std::swap(m_pending, loaded);
+      }
+      continue;
+    }
+
+    ssize_t len = read(fd, buf, sizeof(buf));
+    if (len <= 0) {
+      if (len == -1 && errno == EINTR) continue;
+      break;
+    }
+    for (char* p = buf; p < buf + len;) {
+      auto event = reinterpret_cast<struct inotify_event*>(p);
+      if (event->len > 0 && file == event->name) changed = true;
+      p += sizeof(struct inotify_event) + event->len;
+    }
+  }
+  fmt::print(stderr, "pipeline '{}': stopped watching {}: {}\n", m_name,
+             m_pluginPath, std::strerror(errno));
+  close(fd);
+}
+
+void PluginPipeline::PublishDouble(void* ctx, const char* key,
+                                   double value) {
+  auto self = static_cast<PluginPipeline*>(ctx);
+  std::scoped_lock lock{self->m_hostMutex};
+  auto it = self->m_doublePubs.find(key);
+  if (it == self->m_doublePubs.end()) {
+    it = self->m_doublePubs
+             .emplace(key, self->m_inst
+                               .GetDoubleTopic(fmt::format(
+                                   "/vision/{}/{}", self->m_name, key))
+                               .Publish())
+             .first;
+  }
+  it->second.Set(value, currentCaptureTime);
+}
+
+void PluginPipeline::PublishDoubleArray(void* ctx, const char* key,
+                                        const double* values, size_t count) {
+  auto self = static_cast<PluginPipeline*>(ctx);
+  std::scoped_lock lock{self->m_hostMutex};
+  auto it = self->m_doubleArrayPubs.find(key);
+  if (it == self->m_doubleArrayPubs.end()) {
+    it = self->m_doubleArrayPubs
+             .emplace(key, self->m_inst
+                               .GetDoubleArrayTopic(fmt::format(
+                                   "/vision/{}/{}", self->m_name, key))
+                               .Publish())
+             .first;
+  }
+  it->second.Set({values, count}, currentCaptureTime);
+}
+
+void PluginPipeline::PublishString(void* ctx, const char* key,
+                                   const char* value) {
+  auto self = static_cast<PluginPipeline*>(ctx);
+  std::scoped_lock lock{self->m_hostMutex};
+  auto it = self->m_stringPubs.find(key);
+  if (it == self->m_stringPubs.end()) {
+    it = self->m_stringPubs
+             .emplace(key, self->m_inst
+                               .GetStringTopic(fmt::format(
+                                   "/vision/{}/{}", self->m_name, key))
+                               .Publish())
+             .first;
+  }
+  it->second.Set(value, currentCaptureTime);
+}
+
+void PluginPipeline::Log(void* ctx, const char* message) {
+  auto self = static_cast<PluginPipeline*>(ctx);
+  fmt::print("pipeline '{}': {}\n", self->m_name, message);
+}
@@ -0,0 +1,118 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_PLUGINPIPELINE_H_
+#define MULTICAMERASERVER_PLUGINPIPELINE_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <cscore_cv.h>
+#include <networktables/DoubleArrayTopic.h>
+#include <networktables/DoubleTopic.h>
+#include <networktables/IntegerTopic.h>
+#include <networktables/NetworkTableInstance.h>
+#include <networktables/StringTopic.h>
+#include <opencv2/core/core.hpp>
+
+#include "VisionPlugin.h"
+
+/*
+   Runs a vision pipeline plugin (see VisionPlugin.h) on a camera.
+
+   The plugin file is watched with inotify.  When it is replaced (e.g. by
+   an upload from the web dashboard), the new build is loaded and created on
+   the watcher thread while the old one keeps processing frames, then
+   swapped in between two frames; the old instance is destroyed and
+   unloaded on the processing thread.  Capture and streams keep running
+   throughout, and a plugin that fails to load leaves the old one running.
+
+   Each build is loaded from a private in-memory copy of the file, so the
+   dynamic loader never confuses it with the previous build of the same path
+   and the file can be replaced while it is loaded.
+
+   Results are published by the plugin to /vision/<name>/.  The loaded
+   plugin name, a load generation count and the last load error are
+   published to /multiCameraServer/pipelines/<name>.  If an output stream is
+   configured, processed frames (as modified by the plugin) are served as a
+   camera stream named after the pipeline.
+ */
+class PluginPipeline {
+ public:
+  PluginPipeline(std::string_view name, std::string_view pluginPath,
+                 std::string config, bool gray);
+
+  PluginPipeline(const PluginPipeline&) = delete;
+  PluginPipeline& operator=(const PluginPipeline&) = delete;
+
+  // serves processed frames as a stream; call before Start()
+  cs::MjpegServer AddOutputStream();
+
+  // maps the time CvSink::GrabFrame returns to the frame's capture time,
+  // for cameras that know it (see LatencyCamera.h); call before Start()
+  void SetCaptureTimes(std::function<uint64_t(uint64_t)> captureTime) {
+    m_captureTime = std::move(captureTime);
+  }
+
+  // loads the plugin and starts processing and watching; returns false if
+  // the initial load failed (the file is still watched for a fixed build)
+  bool Start(cs::VideoSource source, nt::NetworkTableInstance inst);
+
+ private:
+  struct Loaded;
+  struct LoadedDeleter {
+    void operator()(Loaded* loaded) const;
+  };
+  using LoadedPtr = std::unique_ptr<Loaded, LoadedDeleter>;
+
+  LoadedPtr Load();
+  void ProcessThreadMain();
+  void WatchThreadMain();
+
+  // frcvision_host functions; ctx is the PluginPipeline
+  static void PublishDouble(void* ctx, const char* key, double value);
+  static void PublishDoubleArray(void* ctx, const char* key,
+                                 const double* values, size_t count);
+  static void PublishString(void* ctx, const char* key, const char* value);
+  static void Log(void* ctx, const char* message);
+
+  std::string m_name;
+  std::string m_pluginPath;
+  std::string m_config;
+  bool m_gray;
+
+  cs::CvSink m_sink;
+  std::function<uint64_t(uint64_t)> m_captureTime;
+  cs::CvSource m_output;
+  cv::Mat m_frame;
+
+  frcvision_host m_host;
+  nt::NetworkTableInstance m_inst;
+  nt::StringPublisher m_pluginPub;
+  nt::IntegerPublisher m_generationPub;
+  nt::StringPublisher m_errorPub;
+
+  // host publishers, created on first use; guarded by m_hostMutex as the
+  // new plugin's create may run while the old one is processing
+  std::mutex m_hostMutex;
+  std::map<std::string, nt::DoublePublisher, std::less<>> m_doublePubs;
+  std::map<std::string, nt::DoubleArrayPublisher, std::less<>>
+      m_doubleArrayPubs;
+  std::map<std::string, nt::StringPublisher, std::less<>> m_stringPubs;
+
+  int m_generation = 0;  // watcher thread only
+  LoadedPtr m_current;   // processing thread only
+
+  std::mutex m_pendingMutex;
+  LoadedPtr m_pending;
+};
+
+#endif  // MULTICAMERASERVER_PLUGINPIPELINE_H_
@@ -0,0 +1,207 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "RealTime.h"
+
+#include <dirent.h>
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <fmt/format.h>
+#include <networktables/IntegerTopic.h>
+#include <networktables/NetworkTableInstance.h>
+
+namespace {
+
+constexpr size_t kStackPrefaultBytes = 256 * 1024;
+constexpr long kMonitorPeriodNs = 1000000;  // 1 ms
+constexpr int kMonitorReportPeriods = 1000;  // 1 s
+
+void PrefaultStack() {
+  volatile char stack[kStackPrefaultBytes];
+  for (size_t i = 0; i < sizeof(stack); i += 4096) stack[i] = 0;
+}
+
+int64_t DiffNs(const timespec& a, const timespec& b) {
+  return (a.tv_sec - b.tv_sec) * 1000000000LL + (a.tv_nsec - b.tv_nsec);
+}
+
+}  // namespace
+
+bool RealTime::LockMemory(size_t defaultPrefaultBytes) {
+  // keep freed memory in the (locked) heap instead of returning it to the OS,
+  // and don't satisfy large allocations (e.g. frame buffers) with fresh mmaps
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+
+  // MCL_ONFAULT avoids committing the full 8 MB stack of every thread
+  // cscore creates; pages we actually touch are still locked
+#ifdef MCL_ONFAULT
+  int flags = MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT;
+#else
+  int flags = MCL_CURRENT | MCL_FUTURE;
+#endif
+  if (mlockall(flags) == -1) {
+    fmt::print(stderr, "real-time: mlockall failed: {}\n",
+               std::strerror(errno));
+    return false;
+  }
+
+  // preallocate and prefault the heap that frame buffers will come from
+  size_t bytes = m_config.prefaultBytes != 0 ? m_config.prefaultBytes
+                                             : defaultPrefaultBytes;
+  long pageSize = sysconf(_SC_PAGESIZE);
+  if (auto buf = static_cast<volatile char*>(std::malloc(bytes))) {
+    for (size_t i = 0; i < bytes; i += pageSize) buf[i] = 0;
+    std::free(const_cast<char*>(buf));
+  } else {
+    fmt::print(stderr, "real-time: could not prefault {} bytes\n", bytes);
+  }
+  PrefaultStack();
+
+  fmt::print("real-time: memory locked, {} KiB heap prefaulted\n",
+             bytes / 1024);
+  return true;
+}
+
+bool RealTime::IsUsableCpu(int cpu) {
+  if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == -1) return false;
+  return CPU_ISSET(cpu, &set);
+}
+
+std::vector<pid_t> RealTime::GetThreads() {
+  std::vector<pid_t> tids;
+  DIR* dir = opendir("/proc/self/task");
+  if (!dir) return tids;
+  while (struct dirent* ent = readdir(dir)) {
+    if (ent->d_name[0] < '0' || ent->d_name[0] > '9') continue;
+    tids.push_back(std::atoi(ent->d_name));
+  }
+  closedir(dir);
+  std::sort(tids.begin(), tids.end());
+  return tids;
+}
+
+std::string RealTime::GetThreadName(pid_t tid) {
+  std::ifstream is{fmt::format("/proc/self/task/{}/comm", tid)};
+  std::string name;
+  std::getline(is, name);
+  return name;
+}
+
+void RealTime::PromoteNamedThreads(std::string_view name,
+                                   std::string_view what) {
+  if (!m_config.enabled) return;
+  for (pid_t tid : GetThreads()) {
+    if (GetThreadName(tid) != name) continue;
+    if (PromoteThread(tid))
+      fmt::print("real-time: {} thread {} running SCHED_FIFO {}\n", what, tid,
+                 m_config.priority);
+  }
+}
+
+void RealTime::PromoteCaptureThread(const std::vector<pid_t>& before,
+                                    std::string_view what) {
+  if (!m_config.enabled) return;
+  // threads that were never named have the main thread's name
+  std::string unnamed = GetThreadName(getpid());
+  std::vector<pid_t> candidates;
+  for (pid_t tid : GetThreads()) {
+    if (std::binary_search(before.begin(), before.end(), tid)) continue;
+    if (GetThreadName(tid) == unnamed) candidates.push_back(tid);
+  }
+  if (candidates.size() != 1) {
+    fmt::print(stderr,
+               "real-time: {}: {} new unnamed threads, not promoting any; "
+               "latency mode has a named capture thread\n",
+               what, candidates.size());
+    return;
+  }
+  if (PromoteThread(candidates[0]))
+    fmt::print("real-time: {} thread {} running SCHED_FIFO {}\n", what,
+               candidates[0], m_config.priority);
+}
+
+bool RealTime::PromoteThread(pid_t tid) {
+  if (!m_config.enabled) return false;
+
+  struct sched_param param;
+  std::memset(&param, 0, sizeof(param));
+  param.sched_priority = m_config.priority;
+  if (sched_setscheduler(tid, SCHED_FIFO, &param) == -1) {
+    fmt::print(stderr, "real-time: could not set SCHED_FIFO on thread {}: {}\n",
+               tid, std::strerror(errno));
+    return false;
+  }
+
+  if (!m_config.cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : m_config.cpus) CPU_SET(cpu, &set);
+    if (sched_setaffinity(tid, sizeof(set), &set) == -1) {
+      fmt::print(stderr, "real-time: could not pin thread {}: {}\n", tid,
+                 std::strerror(errno));
+    }
+  }
+  return true;
+}
+
+void RealTime::StartJitterMonitor(nt::NetworkTableInstance inst) {
+  if (!m_config.enabled) return;
+
+  std::thread([this, inst] {
+    PromoteThread(0);
+    PrefaultStack();
+
+    auto worstPub =
+        inst.GetIntegerTopic("/multiCameraServer/realtime/worstJitterUs")
+            .Publish();
+    auto recentPub =
+        inst.GetIntegerTopic("/multiCameraServer/realtime/recentJitterUs")
+            .Publish();
+
+    int64_t worst = 0;
+    int64_t recent = 0;
+    int count = 0;
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (;;) {
+      next.tv_nsec += kMonitorPeriodNs;
+      if (next.tv_nsec >= 1000000000L) {
+        next.tv_nsec -= 1000000000L;
+        ++next.tv_sec;
+      }
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+      timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      recent = std::max(recent, DiffNs(now, next));
+
+      if (++count < kMonitorReportPeriods) continue;
+      recent /= 1000;
+      recentPub.Set(recent);
+      if (recent > worst) {
+        worst = recent;
+        worstPub.Set(worst);
+        fmt::print("real-time: new worst-case scheduling jitter {} us\n",
+                   worst);
+      }
+      recent = 0;
+      count = 0;
+    }
+  }).detach();
+}
@@ -0,0 +1,75 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_REALTIME_H_
+#define MULTICAMERASERVER_REALTIME_H_
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nt {
+class NetworkTableInstance;
+}  // namespace nt
+
+struct RealTimeConfig {
+  bool enabled = false;
+  int priority = 50;
+  std::vector<int> cpus;
+  size_t prefaultBytes = 0;  // 0 = estimate from camera video modes
+};
+
+/*
+   Real-time support for capture threads.  Memory is locked and prefaulted so
+   steady-state capture never page faults, capture threads are moved to
+   SCHED_FIFO and pinned to the configured CPUs, and a monitor thread at the
+   same priority measures the worst wakeup latency seen on those CPUs.
+
+   Capture threads are picked out by name (/proc/self/task/<tid>/comm), so
+   stream (encoder) threads and the other threads cscore and ntcore start
+   are left at normal priority.
+ */
+class RealTime {
+ public:
+  explicit RealTime(const RealTimeConfig& config) : m_config{config} {}
+
+  bool IsEnabled() const { return m_config.enabled; }
+
+  // mlockall() and prefault heap and stack; call before starting cameras
+  bool LockMemory(size_t defaultPrefaultBytes);
+
+  // whether a "cpus" entry can be pinned to: online and allowed for this
+  // process
+  static bool IsUsableCpu(int cpu);
+
+  // thread ids of this process
+  static std::vector<pid_t> GetThreads();
+
+  // name of a thread of this process, empty if it has exited
+  static std::string GetThreadName(pid_t tid);
+
+  // promote the threads with the given name
+  void PromoteNamedThreads(std::string_view name, std::string_view what);
+
+  // promote the capture thread of a cscore camera created since the
+  // "before" snapshot: the one new thread that still has the process name.
+  // cscore doesn't name it, so if more than one new thread is unnamed it
+  // can't be told apart and none is promoted.
+  void PromoteCaptureThread(const std::vector<pid_t>& before,
+                            std::string_view what);
+
+  // promote a single thread (0 = calling thread)
+  bool PromoteThread(pid_t tid);
+
+  // start the jitter monitor; reports to stdout and NetworkTables
+  void StartJitterMonitor(nt::NetworkTableInstance inst);
+
+ private:
+  RealTimeConfig m_config;
+};
+
+#endif  // MULTICAMERASERVER_REALTIME_H_
@@ -0,0 +1,301 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "StreamBandwidth.h"
+
+#include <arpa/inet.h>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+
+#include <fmt/format.h>
+#include <wpi/json.h>
+#include <wpi/timestamp.h>
+
+namespace {
+
+// configServer listens here for vision telemetry
+constexpr int kTelemetryPort = 6667;
+
+// TCP states that can still be sending (from the kernel's tcp_states.h)
+constexpr unsigned int kTcpStates = (1 << 1) |  // ESTABLISHED
+                                    (1 << 4) |  // FIN_WAIT1
+                                    (1 << 8);   // CLOSE_WAIT
+
+// throttle levels before limiting to the stream's own quality; level 0 is
+// the stream config
+constexpr ThrottleLevel kLevels[] = {
+    {-1, 1}, {50, 1}, {30, 1}, {30, 2}, {20, 3}, {20, 6}};
+static_assert(sizeof(kLevels) / sizeof(kLevels[0]) == kNumThrottleLevels);
+
+// wait for the smoothed rate to settle before changing levels again
+constexpr int64_t kThrottleHoldUs = 2000000;
+constexpr int64_t kRestoreHoldUs = 5000000;
+
+// unthrottle only when this far under the budget to avoid oscillating
+constexpr double kRestoreFraction = 0.7;
+
+struct SocketBytes {
+  int port;
+  uint64_t cookie;
+  uint64_t bytes;
+};
+
+// reads bytes acked on every TCP socket bound to one of the given local
+// ports using the sock_diag netlink interface
+std::vector<SocketBytes> ReadSocketBytes(const std::vector<int>& ports) {
+  std::vector<SocketBytes> out;
+  int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+  if (fd < 0) return out;
+
+  for (int family : {AF_INET, AF_INET6}) {
+    struct {
+      struct nlmsghdr nlh;
+      struct inet_diag_req_v2 req;
+    } msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.nlh.nlmsg_len = sizeof(msg);
+    msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    msg.req.sdiag_family = family;
+    msg.req.sdiag_protocol = IPPROTO_TCP;
+    msg.req.idiag_states = kTcpStates;
+    msg.req.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+    if (send(fd, &msg, sizeof(msg), 0) < 0) break;
+
+    alignas(struct nlmsghdr) char buf[16384];
+    bool done = false;
+    while (!done) {
+      ssize_t len = recv(fd, buf, sizeof(buf), 0);
+      if (len <= 0) break;
+      auto h = reinterpret_cast<struct nlmsghdr*>(buf);
+      for (; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+        if (h->nlmsg_type == NLMSG_DONE || h->nlmsg_type == NLMSG_ERROR) {
+          done = true;
+          break;
+        }
+        auto diag = static_cast<struct inet_diag_msg*>(NLMSG_DATA(h));
+        int port = ntohs(diag->id.idiag_sport);
+        if (std::find(ports.begin(), ports.end(), port) == ports.end())
+          continue;
+
+        int attrLen = h->nlmsg_len - NLMSG_LENGTH(sizeof(*diag));
+        auto attr = reinterpret_cast<struct rtattr*>(diag + 1);
+        for (; RTA_OK(attr, attrLen); attr = RTA_NEXT(attr, attrLen)) {
+          if (attr->rta_type != INET_DIAG_INFO) continue;
+          // older kernels send a shorter tcp_info
+          if (RTA_PAYLOAD(attr) < offsetof(struct tcp_info, tcpi_bytes_acked) +
+                                      sizeof(uint64_t))
+            continue;
+          auto info = static_cast<struct tcp_info*>(RTA_DATA(attr));
+          uint64_t cookie =
+              diag->id.idiag_cookie[0] |
+              (static_cast<uint64_t>(diag->id.idiag_cookie[1]) << 32);
+          out.push_back({port, cookie, info->tcpi_bytes_acked});
+        }
+      }
+    }
+  }
+
+  close(fd);
+  return out;
+}
+
+std::string DescribeLevel(int baseQuality, int level) {
+  if (level == 0) return "none";
+  auto l = GetThrottleLevel(baseQuality, level);
+  if (l.fpsDivisor == 1) return fmt::format("quality {}", l.quality);
+  return fmt::format("quality {}, 1/{} fps", l.quality, l.fpsDivisor);
+}
+
+}  // namespace
+
+ThrottleLevel GetThrottleLevel(int baseQuality, int level) {
+  if (level == 0) return {baseQuality, 1};
+  ThrottleLevel l = kLevels[level];
+  if (baseQuality >= 0) l.quality = std::min(baseQuality, l.quality);
+  return l;
+}
+
+int StepThrottleLevel(int baseQuality, int level, int step) {
+  auto same = [&](int a, int b) {
+    auto la = GetThrottleLevel(baseQuality, a);
+    auto lb = GetThrottleLevel(baseQuality, b);
+    return la.quality == lb.quality && la.fpsDivisor == lb.fpsDivisor;
+  };
+  // skip the levels that would change nothing
+  int next = level + step;
+  while (next >= 0 && next < kNumThrottleLevels && same(next, level))
+    next += step;
+  if (next < 0 || next >= kNumThrottleLevels) return -1;
+  // of the levels with the same settings, the lowest, so that stepping
+  // back down ends at level 0
+  while (next > 0 && same(next, next - 1)) --next;
+  return next;
+}
+
+void StreamBandwidth::AddStream(std::string_view name, cs::MjpegServer server,
+                                int priority) {
+  Stream s;
+  s.name = name;
+  s.port = server.GetPort();
+  s.priority = priority;
+  s.baseQuality = server.GetProperty("compression").Get();
+  s.baseFps = server.GetProperty("fps").Get();
+  s.server = std::move(server);
+  m_streams.emplace_back(std::move(s));
+}
+
+void StreamBandwidth::Start(nt::NetworkTableInstance inst) {
+  if (m_budgetMbps > 0)
+    fmt::print("Limiting streams to {} Mbps total\n", m_budgetMbps);
+  std::thread(&StreamBandwidth::ThreadMain, this, inst).detach();
+}
+
+void StreamBandwidth::ThreadMain(nt::NetworkTableInstance inst) {
+  m_budgetPub =
+      inst.GetDoubleTopic("/multiCameraServer/bandwidth/budgetMbps").Publish();
+  m_usedPub =
+      inst.GetDoubleTopic("/multiCameraServer/bandwidth/usedMbps").Publish();
+  for (auto&& s : m_streams) {
+    auto prefix = fmt::format("/multiCameraServer/bandwidth/{}/", s.name);
+    s.mbpsPub = inst.GetDoubleTopic(prefix + "mbps").Publish();
+    s.levelPub = inst.GetIntegerTopic(prefix + "level").Publish();
+  }
+  m_udpSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+  auto last = std::chrono::steady_clock::now();
+  for (;;) {
+    std::this_thread::sleep_until(last + std::chrono::seconds(1));
+    auto now = std::chrono::steady_clock::now();
+    Measure(std::chrono::duration<double>(now - last).count());
+    last = now;
+    Enforce();
+    Report();
+  }
+}
+
+void StreamBandwidth::Measure(double seconds) {
+  std::vector<int> ports;
+  for (auto&& s : m_streams) ports.push_back(s.port);
+  auto sockets = ReadSocketBytes(ports);
+
+  m_totalMbps = 0;
+  for (auto&& s : m_streams) {
+    std::map<uint64_t, uint64_t> current;
+    uint64_t sent = 0;
+    for (auto&& sock : sockets) {
+      if (sock.port != s.port) continue;
+      // new connections count from zero
+      auto it = s.sockets.find(sock.cookie);
+      uint64_t prev = it == s.sockets.end() ? 0 : it->second;
+      if (sock.bytes > prev) sent += sock.bytes - prev;
+      current[sock.cookie] = sock.bytes;
+    }
+    s.sockets = std::move(current);
+    s.clients = s.sockets.size();
+
+    // light smoothing so a single large frame doesn't trigger throttling
+    double mbps = sent * 8 / seconds / 1e6;
+    s.mbps = (s.mbps + mbps) / 2;
+    m_totalMbps += s.mbps;
+  }
+}
+
+void StreamBandwidth::Enforce() {
+  if (m_budgetMbps <= 0) return;
+  int64_t now = wpi::Now();
+
+  if (m_totalMbps > m_budgetMbps) {
+    if (now - m_lastChange < kThrottleHoldUs) return;
+    // lowest priority first; among equals, the biggest sender
+    Stream* victim = nullptr;
+    for (auto&& s : m_streams) {
+      if (s.clients == 0 || StepThrottleLevel(s.baseQuality, s.level, 1) < 0)
+        continue;
+      if (!victim || s.priority < victim->priority ||
+          (s.priority == victim->priority && s.mbps > victim->mbps))
+        victim = &s;
+    }
+    if (!victim) return;
+    victim->level = StepThrottleLevel(victim->baseQuality, victim->level, 1);
+    ApplyLevel(*victim);
+    m_lastChange = now;
+    fmt::print("bandwidth: {:.1f} of {} Mbps; throttling '{}' to {}\n",
+               m_totalMbps, m_budgetMbps, victim->name,
+               DescribeLevel(victim->baseQuality, victim->level));
+  } else if (m_totalMbps < m_budgetMbps * kRestoreFraction) {
+    if (now - m_lastChange < kRestoreHoldUs) return;
+    // highest priority first
+    Stream* best = nullptr;
+    for (auto&& s : m_streams) {
+      if (s.level == 0) continue;
+      if (!best || s.priority > best->priority) best = &s;
+    }
+    if (!best) return;
+    best->level =
+        std::max(0, StepThrottleLevel(best->baseQuality, best->level, -1));
+    ApplyLevel(*best);
+    m_lastChange = now;
+    fmt::print("bandwidth: {:.1f} of {} Mbps; restoring '{}' to {}\n",
+               m_totalMbps, m_budgetMbps, best->name,
+               DescribeLevel(best->baseQuality, best->level));
+  }
+}
+
+void StreamBandwidth::ApplyLevel(Stream& s) {
+  if (s.level == 0) {
+    s.server.SetCompression(s.baseQuality);
+    s.server.SetFPS(s.baseFps);
+    return;
+  }
+  auto l = GetThrottleLevel(s.baseQuality, s.level);
+  s.server.SetCompression(l.quality);
+  int fps = s.baseFps;
+  if (fps <= 0) fps = s.server.GetSource().GetVideoMode().fps;
+  if (fps <= 0) fps = 30;
+  s.server.SetFPS(std::max(1, fps / l.fpsDivisor));
+}
+
+void StreamBandwidth::Report() {
+  m_budgetPub.Set(m_budgetMbps);
+  m_usedPub.Set(m_totalMbps);
+
+  wpi::json j = {{"type", "visionBandwidth"},
+                 {"budget", m_budgetMbps},
+                 {"used", m_totalMbps},
+                 {"streams", wpi::json::array()}};
+  for (auto&& s : m_streams) {
+    s.mbpsPub.Set(s.mbps);
+    s.levelPub.Set(s.level);
+    auto throttle = DescribeLevel(s.baseQuality, s.level);
+    j["streams"].emplace_back(wpi::json{{"name", s.name},
+                                        {"port", s.port},
+                                        {"priority", s.priority},
+                                        {"clients", s.clients},
+                                        {"mbps", s.mbps},
+                                        {"throttle", throttle}});
+  }
+
+  if (m_udpSocket < 0) return;
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(kTelemetryPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  auto str = j.dump();
+  sendto(m_udpSocket, str.data(), str.size(), 0,
+         reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+}
@@ -0,0 +1,103 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_STREAMBANDWIDTH_H_
+#define MULTICAMERASERVER_STREAMBANDWIDTH_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cscore.h>
+#include <networktables/DoubleTopic.h>
+#include <networktables/IntegerTopic.h>
+#include <networktables/NetworkTableInstance.h>
+
+/*
+   Throttle levels, least to most aggressive.  Level 0 is the stream's own
+   config; the later ones lower the JPEG quality, then the fps.  A level
+   never sets a quality above the one the stream is configured with, so a
+   stream already at a low quality goes straight to the levels that lower
+   its fps.
+ */
+struct ThrottleLevel {
+  int quality;  // -1 for the server's default
+  int fpsDivisor;
+};
+
+constexpr int kNumThrottleLevels = 6;
+
+// the settings of a level for a stream configured at baseQuality
+ThrottleLevel GetThrottleLevel(int baseQuality, int level);
+
+// the next level up (step 1) or down (step -1) from level that changes the
+// stream's settings, or -1 if there is none
+int StepThrottleLevel(int baseQuality, int level, int step);
+
+/*
+   Accounts the bytes every MjpegServer sends and keeps the total under a
+   global uplink budget.
+
+   Bytes are read once a second from the kernel's TCP statistics for each
+   stream port (bytes acknowledged by the client), so they include HTTP
+   framing and reflect what actually crossed the network.
+
+   When the total exceeds the budget, the lowest priority stream that is
+   sending is stepped down one throttle level (lower JPEG quality, then lower
+   fps); when the total is comfortably under the budget, the highest priority
+   throttled stream is stepped back up.  A budget of 0 only accounts.
+
+   Usage is published to /multiCameraServer/bandwidth and sent to the
+   configServer status page.
+ */
+class StreamBandwidth {
+ public:
+  explicit StreamBandwidth(double budgetMbps) : m_budgetMbps{budgetMbps} {}
+
+  StreamBandwidth(const StreamBandwidth&) = delete;
+  StreamBandwidth& operator=(const StreamBandwidth&) = delete;
+
+  // higher priority streams are throttled last; call before Start()
+  void AddStream(std::string_view name, cs::MjpegServer server, int priority);
+
+  void Start(nt::NetworkTableInstance inst);
+
+ private:
+  struct Stream {
+    std::string name;
+    cs::MjpegServer server;
+    int port;
+    int priority;
+    int baseQuality;  // configured compression property
+    int baseFps;      // configured fps, or the source fps if unlimited
+
+    int level = 0;
+    double mbps = 0;
+    int clients = 0;
+    std::map<uint64_t, uint64_t> sockets;  // socket cookie -> bytes acked
+
+    nt::DoublePublisher mbpsPub;
+    nt::IntegerPublisher levelPub;
+  };
+
+  void ThreadMain(nt::NetworkTableInstance inst);
+  void Measure(double seconds);
+  void Enforce();
+  void ApplyLevel(Stream& stream);
+  void Report();
+
+  double m_budgetMbps;
+  std::vector<Stream> m_streams;
+  double m_totalMbps = 0;
+  int64_t m_lastChange = 0;
+  int m_udpSocket = -1;
+
+  nt::DoublePublisher m_budgetPub;
+  nt::DoublePublisher m_usedPub;
+};
+
+#endif  // MULTICAMERASERVER_STREAMBANDWIDTH_H_
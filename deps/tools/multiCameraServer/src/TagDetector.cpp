@@ -0,0 +1,164 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "TagDetector.h"
+
+#include <algorithm>
+#include <exception>
+#include <numbers>
+#include <thread>
+
+#include <fmt/format.h>
+#include <frc/EigenCore.h>
+#include <frc/apriltag/AprilTagFields.h>
+#include <frc/geometry/CoordinateSystem.h>
+#include <opencv2/calib3d.hpp>
+#include <units/angle.h>
+#include <units/length.h>
+
+namespace {
+
+constexpr int kPoseIterations = 50;
+
+// apriltag poses are in the OpenCV camera frame (x right, y down, z
+// forward) with the tag's z into its face; WPILib's tag x points out of it
+frc::Transform3d ToWpilib(const frc::Transform3d& pose) {
+  auto nwu = frc::CoordinateSystem::Convert(
+      pose, frc::CoordinateSystem::EDN(), frc::CoordinateSystem::NWU());
+  frc::Rotation3d flip{units::radian_t{0}, units::radian_t{0},
+                       units::radian_t{std::numbers::pi}};
+  return {nwu.Translation(), flip.RotateBy(nwu.Rotation())};
+}
+
+}  // namespace
+
+TagDetector::TagDetector(const TagDetectorConfig& config,
+                         const std::optional<CameraCalibration>& calibration)
+    : m_config{config}, m_calibration{calibration} {}
+
+bool TagDetector::Init(std::string& error) {
+  if (m_config.decimate < 1) {
+    error = fmt::format("invalid decimate {}", m_config.decimate);
+    return false;
+  }
+  if (m_config.tagSize <= 0) {
+    error = fmt::format("invalid tag size {}", m_config.tagSize);
+    return false;
+  }
+  if (!m_detector.AddFamily(m_config.family, m_config.maxHamming)) {
+    error = fmt::format("unknown tag family '{}'", m_config.family);
+    return false;
+  }
+
+  frc::AprilTagDetector::Config config;
+  config.numThreads = m_config.threads > 0
+                          ? m_config.threads
+                          : std::max(1u, std::thread::hardware_concurrency());
+  config.quadDecimate = m_config.decimate;
+  m_detector.SetConfig(config);
+
+  // the layout is only needed for the camera pose
+  if (!m_calibration) return true;
+  try {
+    if (m_config.field.empty())
+      m_layout =
+          frc::LoadAprilTagLayoutField(frc::AprilTagField::k2024Crescendo);
+    else
+      m_layout = frc::AprilTagFieldLayout{m_config.field};
+  } catch (const std::exception& e) {
+    error = fmt::format("could not load field layout '{}': {}",
+                        m_config.field, e.what());
+    return false;
+  }
+  return true;
+}
+
+void TagDetector::Detect(const cv::Mat& gray) {
+  if (gray.size() != m_size) SetImageSize(gray.size());
+
+  auto results = m_detector.Detect(gray.cols, gray.rows, gray.step, gray.data);
+  m_tags.clear();
+  for (const frc::AprilTagDetection* detection : results) {
+    if (detection->GetDecisionMargin() < m_config.minMargin) continue;
+    Tag& tag = m_tags.emplace_back();
+    tag.id = detection->GetId();
+    tag.margin = detection->GetDecisionMargin();
+    auto center = detection->GetCenter();
+    tag.center = {center.x, center.y};
+    for (int i = 0; i < 4; ++i) {
+      auto corner = detection->GetCorner(i);
+      tag.corners[i] = {corner.x, corner.y};
+    }
+    if (m_estimator) {
+      auto estimate =
+          m_estimator->EstimateOrthogonalIteration(*detection, kPoseIterations);
+      tag.pose = ToWpilib(estimate.pose1);
+      tag.ambiguity = estimate.GetAmbiguity();
+    }
+  }
+
+  SolveCameraPose();
+}
+
+void TagDetector::SetImageSize(cv::Size size) {
+  m_size = size;
+  if (!m_calibration) return;
+  m_cameraMatrix = m_calibration->GetCameraMatrix(size);
+  m_estimator.emplace(frc::AprilTagPoseEstimator::Config{
+      units::meter_t{m_config.tagSize}, m_cameraMatrix(0, 0),
+      m_cameraMatrix(1, 1), m_cameraMatrix(0, 2), m_cameraMatrix(1, 2)});
+}
+
+void TagDetector::SolveCameraPose() {
+  m_cameraPose.reset();
+  if (!m_layout) return;
+
+  // the corners of every known tag, in field coordinates, in the order
+  // the detector reports them (tag y to the viewer's right)
+  units::meter_t zero{0};
+  units::meter_t half{m_config.tagSize / 2};
+  const frc::Translation3d corners[4] = {{zero, -half, -half},
+                                         {zero, half, -half},
+                                         {zero, half, half},
+                                         {zero, -half, half}};
+  m_objectPoints.clear();
+  m_imagePoints.clear();
+  int known = 0;
+  for (auto&& tag : m_tags) {
+    auto tagPose = m_layout->GetTagPose(tag.id);
+    if (!tagPose) continue;
+    ++known;
+    for (int i = 0; i < 4; ++i) {
+      auto corner =
+          tagPose->Translation() + corners[i].RotateBy(tagPose->Rotation());
+      m_objectPoints.emplace_back(corner.X().value(), corner.Y().value(),
+                                  corner.Z().value());
+      m_imagePoints.emplace_back(tag.corners[i]);
+    }
+  }
+  if (known < 2) return;
+
+  cv::Vec3d rvec, tvec;
+  if (!cv::solvePnP(m_objectPoints, m_imagePoints, m_cameraMatrix,
+                    cv::noArray(), rvec, tvec, false, cv::SOLVEPNP_SQPNP))
+    return;
+
+  // solvePnP maps field to OpenCV camera coordinates; invert it and take
+  // the camera's forward (z), left (-x) and up (-y) axes in the field
+  cv::Matx33d rotation;
+  cv::Rodrigues(rvec, rotation);
+  cv::Matx33d toField = rotation.t();
+  cv::Vec3d position = -(toField * tvec);
+  frc::Matrixd<3, 3> axes;
+  for (int i = 0; i < 3; ++i) {
+    axes(i, 0) = toField(i, 2);
+    axes(i, 1) = -toField(i, 0);
+    axes(i, 2) = -toField(i, 1);
+  }
+  m_cameraPose = frc::Pose3d{
+      frc::Translation3d{units::meter_t{position[0]},
+                         units::meter_t{position[1]},
+                         units::meter_t{position[2]}},
+      frc::Rotation3d{axes}};
+}
@@ -0,0 +1,98 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_TAGDETECTOR_H_
+#define MULTICAMERASERVER_TAGDETECTOR_H_
+
+#include <array>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <frc/apriltag/AprilTagDetector.h>
+#include <frc/apriltag/AprilTagFieldLayout.h>
+#include <frc/apriltag/AprilTagPoseEstimator.h>
+#include <frc/geometry/Pose3d.h>
+#include <frc/geometry/Transform3d.h>
+#include <opencv2/core/core.hpp>
+
+#include "CameraCalibration.h"
+
+struct TagDetectorConfig {
+  std::string family = "tag36h11";
+  int threads = 0;          // detector threads, 0 for one per core
+  float decimate = 2;       // quad detection on a 1/decimate size image
+  int maxHamming = 0;       // bit errors corrected
+  double minMargin = 0;     // decision margin, to reject weak decodes
+  double tagSize = 0.1651;  // black square side, in meters
+  std::string field;        // layout JSON; the current season's if empty
+};
+
+/*
+   Finds AprilTags in grayscale frames and, with a camera calibration,
+   estimates where they are.
+
+   The detector, with its worker threads and decode tables, is created once
+   and reused for every frame.  Quads are found on a decimated image and
+   refined at full resolution, so decimate trades range for speed.
+
+   Each tag gets its own camera-to-tag transform (orthogonal iteration, the
+   better of the two planar solutions, with its ambiguity).  In addition,
+   the corners of all the tags that are in the field layout are solved
+   together for the camera's field pose in one solvePnP, which is far
+   less ambiguous and noisy than any single tag.  Poses use the WPILib
+   conventions: x forward, y left, z up, for the camera as for the field.
+ */
+class TagDetector {
+ public:
+  struct Tag {
+    int id = 0;
+    double margin = 0;
+    cv::Point2d center;
+    std::array<cv::Point2d, 4> corners;  // bottom left, counter-clockwise
+    frc::Transform3d pose;  // camera to tag, if calibrated
+    double ambiguity = 0;   // pose error ratio of the two solutions
+  };
+
+  TagDetector(const TagDetectorConfig& config,
+              const std::optional<CameraCalibration>& calibration);
+
+  // sets up the family and loads the field layout
+  bool Init(std::string& error);
+
+  // the results are kept until the next call
+  void Detect(const cv::Mat& gray);
+
+  std::span<const Tag> GetTags() const { return m_tags; }
+
+  // whether tags get poses, which needs a calibration
+  bool HasPoses() const { return m_calibration.has_value(); }
+
+  // from all the layout's tags in the frame, if there were at least two
+  const std::optional<frc::Pose3d>& GetCameraPose() const {
+    return m_cameraPose;
+  }
+
+ private:
+  void SetImageSize(cv::Size size);
+  void SolveCameraPose();
+
+  TagDetectorConfig m_config;
+  std::optional<CameraCalibration> m_calibration;
+  frc::AprilTagDetector m_detector;
+  std::optional<frc::AprilTagFieldLayout> m_layout;
+
+  // for the current image size
+  cv::Size m_size;
+  cv::Matx33d m_cameraMatrix;
+  std::optional<frc::AprilTagPoseEstimator> m_estimator;
+
+  std::vector<Tag> m_tags;
+  std::optional<frc::Pose3d> m_cameraPose;
+  std::vector<cv::Point3d> m_objectPoints;
+  std::vector<cv::Point2d> m_imagePoints;
+};
+
+#endif  // MULTICAMERASERVER_TAGDETECTOR_H_
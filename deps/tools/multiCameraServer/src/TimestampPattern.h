@@ -0,0 +1,122 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_TIMESTAMPPATTERN_H_
+#define MULTICAMERASERVER_TIMESTAMPPATTERN_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include <cstddef>
+
+/*
+   Machine-readable timestamp pattern used for glass-to-glass latency
+   measurement.  The full image is divided into a kPatternCols x kPatternRows
+   grid of cells.  Cell 0 is always white and cell 1 is always black; these
+   are used as decode references.  The next 64 cells are the timestamp bits
+   (MSB first), followed by 8 cells of CRC-8.  Remaining cells are mid-gray.
+
+   Cells are large relative to JPEG blocks, and only the center of each cell
+   is sampled when decoding, so the pattern survives MJPEG compression and
+   server-side downscaling to 160x120.
+ */
+
+namespace tspattern {
+
+constexpr int kPatternCols = 9;
+constexpr int kPatternRows = 9;
+constexpr int kDataCells = 64;
+constexpr int kCrcCells = 8;
+
+/* microseconds from CLOCK_MONOTONIC; shared by all processes on a host */
+inline uint64_t MonotonicMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000u + ts.tv_nsec / 1000;
+}
+
+inline uint8_t Crc8(uint64_t value) {
+  uint8_t crc = 0;
+  for (int i = 7; i >= 0; --i) {
+    crc ^= static_cast<uint8_t>(value >> (i * 8));
+    for (int b = 0; b < 8; ++b)
+      crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07)
+                         : static_cast<uint8_t>(crc << 1);
+  }
+  return crc;
+}
+
+/* returns the 0/255 value of a cell, or 128 for an unused cell */
+inline uint8_t CellValue(int cell, uint64_t value, uint8_t crc) {
+  if (cell == 0) return 255;
+  if (cell == 1) return 0;
+  cell -= 2;
+  if (cell < kDataCells) return ((value >> (kDataCells - 1 - cell)) & 1) * 255;
+  cell -= kDataCells;
+  if (cell < kCrcCells) return ((crc >> (kCrcCells - 1 - cell)) & 1) * 255;
+  return 128;
+}
+
+/* draw pattern into an 8-bit grayscale image */
+inline void Draw(uint8_t* data, int width, int height, size_t stride,
+                 uint64_t value) {
+  uint8_t crc = Crc8(value);
+  for (int y = 0; y < height; ++y) {
+    int row = y * kPatternRows / height;
+    uint8_t* line = data + y * stride;
+    for (int x = 0; x < width; ++x) {
+      int col = x * kPatternCols / width;
+      line[x] = CellValue(row * kPatternCols + col, value, crc);
+    }
+  }
+}
+
+/* average of the center half of a cell */
+inline int SampleCell(const uint8_t* data, int width, int height,
+                      size_t stride, int cell) {
+  int row = cell / kPatternCols;
+  int col = cell % kPatternCols;
+  int x0 = (col * 4 + 1) * width / (kPatternCols * 4);
+  int x1 = (col * 4 + 3) * width / (kPatternCols * 4);
+  int y0 = (row * 4 + 1) * height / (kPatternRows * 4);
+  int y1 = (row * 4 + 3) * height / (kPatternRows * 4);
+  if (x1 <= x0) x1 = x0 + 1;
+  if (y1 <= y0) y1 = y0 + 1;
+  unsigned int sum = 0;
+  for (int y = y0; y < y1; ++y) {
+    const uint8_t* line = data + y * stride;
+    for (int x = x0; x < x1; ++x) sum += line[x];
+  }
+  return sum / ((x1 - x0) * (y1 - y0));
+}
+
+/* decode pattern from an 8-bit grayscale image; false if not found */
+inline bool Decode(const uint8_t* data, int width, int height, size_t stride,
+                   uint64_t* value) {
+  if (width < kPatternCols * 4 || height < kPatternRows * 4) return false;
+  int white = SampleCell(data, width, height, stride, 0);
+  int black = SampleCell(data, width, height, stride, 1);
+  if (white - black < 64) return false;
+  int threshold = (white + black) / 2;
+
+  uint64_t v = 0;
+  for (int i = 0; i < kDataCells; ++i) {
+    v <<= 1;
+    if (SampleCell(data, width, height, stride, 2 + i) > threshold) v |= 1;
+  }
+  uint8_t crc = 0;
+  for (int i = 0; i < kCrcCells; ++i) {
+    crc <<= 1;
+    if (SampleCell(data, width, height, stride, 2 + kDataCells + i) >
+        threshold)
+      crc |= 1;
+  }
+  if (crc != Crc8(v)) return false;
+  *value = v;
+  return true;
+}
+
+}  // namespace tspattern
+
+#endif  // MULTICAMERASERVER_TIMESTAMPPATTERN_H_
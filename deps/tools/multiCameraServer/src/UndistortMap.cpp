@@ -0,0 +1,177 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "UndistortMap.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include <fmt/format.h>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace {
+
+constexpr char kMagic[8] = {'U', 'N', 'D', 'I', 'S', 'T', '0', '1'};
+
+bool ReadAll(int fd, void* data, size_t size) {
+  auto p = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t n = read(fd, p, size);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) continue;
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool WriteAll(int fd, const void* data, size_t size) {
+  auto p = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t n = write(fd, p, size);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+// FNV-1a, to name the cache file; the file holds the whole key
+uint64_t Hash(const std::vector<double>& key) {
+  uint64_t hash = 14695981039346656037ull;
+  auto p = reinterpret_cast<const unsigned char*>(key.data());
+  for (size_t i = 0; i < key.size() * sizeof(double); ++i) {
+    hash ^= p[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace
+
+bool UndistortMap::Init(const CameraCalibration& calibration, cv::Size size,
+                        std::string_view cacheDir) {
+  m_size = size;
+  cv::Matx33d cameraMatrix = calibration.GetCameraMatrix(size);
+  m_key = {static_cast<double>(size.width), static_cast<double>(size.height),
+           cameraMatrix(0, 0), cameraMatrix(1, 1), cameraMatrix(0, 2),
+           cameraMatrix(1, 2)};
+  m_key.insert(m_key.end(), calibration.distortion.begin(),
+               calibration.distortion.end());
+
+  std::string path = GetCachePath(cacheDir);
+  if (Load(path)) return true;
+
+  cv::initUndistortRectifyMap(cameraMatrix, calibration.GetDistortion(),
+                              cv::noArray(), cameraMatrix, size, CV_16SC2,
+                              m_xy, m_weights);
+  std::string error;
+  if (!Save(path, cacheDir, error)) {
+    fmt::print(stderr, "could not save undistort tables to '{}': {}\n", path,
+               error);
+  }
+  return false;
+}
+
+void UndistortMap::Apply(const cv::Mat& in, cv::Mat& out,
+                         int interpolation) const {
+  cv::remap(in, out, m_xy, m_weights, interpolation, cv::BORDER_CONSTANT);
+}
+
+std::string UndistortMap::GetCachePath(std::string_view cacheDir) const {
+  return fmt::format("{}/undistort-{}x{}-{:016x}.map", cacheDir, m_size.width,
+                     m_size.height, Hash(m_key));
+}
+
+bool UndistortMap::Load(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+
+  char magic[sizeof(kMagic)];
+  uint32_t count = 0;
+  std::vector<double> key;
+  bool ok = ReadAll(fd, magic, sizeof(magic)) &&
+            std::memcmp(magic, kMagic, sizeof(kMagic)) == 0 &&
+            ReadAll(fd, &count, sizeof(count)) && count == m_key.size();
+  if (ok) {
+    key.resize(count);
+    ok = ReadAll(fd, key.data(), count * sizeof(double)) && key == m_key;
+  }
+  if (ok) {
+    m_xy.create(m_size, CV_16SC2);
+    m_weights.create(m_size, CV_16UC1);
+    ok = ReadAll(fd, m_xy.data, m_xy.total() * m_xy.elemSize()) &&
+         ReadAll(fd, m_weights.data,
+                 m_weights.total() * m_weights.elemSize());
+  }
+  close(fd);
+  return ok;
+}
+
+bool UndistortMap::Save(const std::string& path, std::string_view cacheDir,
+                        std::string& error) const {
+  std::error_code ec;
+  std::filesystem::create_directories(std::filesystem::path{cacheDir}, ec);
+  if (ec) {
+    error = ec.message();
+    return false;
+  }
+
+  // written under another name first, so a crash never leaves a partial
+  // file for the next start to load
+  std::string tmp = path + ".tmp";
+  int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+  uint32_t count = m_key.size();
+  bool ok = WriteAll(fd, kMagic, sizeof(kMagic)) &&
+            WriteAll(fd, &count, sizeof(count)) &&
+            WriteAll(fd, m_key.data(), count * sizeof(double)) &&
+            WriteAll(fd, m_xy.data, m_xy.total() * m_xy.elemSize()) &&
+            WriteAll(fd, m_weights.data,
+                     m_weights.total() * m_weights.elemSize());
+  if (!ok) error = std::strerror(errno);
+  if (close(fd) < 0 && ok) {
+    error = std::strerror(errno);
+    ok = false;
+  }
+  if (ok && rename(tmp.c_str(), path.c_str()) < 0) {
+    error = std::strerror(errno);
+    ok = false;
+  }
+  if (!ok) unlink(tmp.c_str());
+  return ok;
+}
+
+void PointUndistorter::Init(const CameraCalibration& calibration,
+                            cv::Size size) {
+  m_size = size;
+  m_cameraMatrix = calibration.GetCameraMatrix(size);
+  m_distortion = calibration.GetDistortion();
+}
+
+void PointUndistorter::Apply(const std::vector<cv::Point>& in,
+                             std::vector<cv::Point>& out) {
+  m_in.assign(in.begin(), in.end());
+  out.clear();
+  if (m_in.empty()) return;
+  // mapped back through the same camera matrix, so they stay in pixels
+  cv::undistortPoints(m_in, m_out, m_cameraMatrix, m_distortion,
+                      cv::noArray(), m_cameraMatrix);
+  for (auto&& p : m_out) out.emplace_back(cvRound(p.x), cvRound(p.y));
+}
@@ -0,0 +1,83 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_UNDISTORTMAP_H_
+#define MULTICAMERASERVER_UNDISTORTMAP_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "CameraCalibration.h"
+
+/*
+   Removes lens distortion from frames of one camera at one resolution.
+
+   cv::undistort computes where every output pixel comes from on every
+   call.  This computes it once, as fixed-point remap tables (16-bit source
+   coordinates plus an interpolation weight index), so each frame is a
+   single cv::remap, which uses the vectorized fixed-point path.
+
+   Building the tables takes a noticeable time at startup, so they are
+   saved in the cache directory, named after the resolution and a hash of
+   the calibration, and loaded on later starts.  A cache file is only used
+   if it was written for exactly this calibration and size.  If the
+   directory can't be written (the rPi's root filesystem is read only
+   unless made writable on the dashboard), the tables are just rebuilt on
+   every start.
+
+   The undistorted image keeps the camera matrix, so it is the image an
+   ideal pinhole camera with the calibration's intrinsics would see.
+ */
+class UndistortMap {
+ public:
+  static constexpr std::string_view kDefaultCacheDir =
+      "/home/pi/.cache/multiCameraServer";
+
+  // loads the tables from the cache or builds (and saves) them; returns
+  // false if they had to be built
+  bool Init(const CameraCalibration& calibration, cv::Size size,
+            std::string_view cacheDir);
+
+  cv::Size GetSize() const { return m_size; }
+
+  void Apply(const cv::Mat& in, cv::Mat& out, int interpolation) const;
+
+ private:
+  std::string GetCachePath(std::string_view cacheDir) const;
+  bool Load(const std::string& path);
+  bool Save(const std::string& path, std::string_view cacheDir,
+            std::string& error) const;
+
+  cv::Size m_size;
+  std::vector<double> m_key;  // calibration for this size, in the file
+  cv::Mat m_xy;               // CV_16SC2 source pixel
+  cv::Mat m_weights;          // CV_16UC1 interpolation table index
+};
+
+/*
+   Removes lens distortion from points, such as the contours of targets,
+   without touching the image: far less work than undistorting frames when
+   only the target positions matter.  Points stay in pixels, in the
+   undistorted image UndistortMap would produce.
+ */
+class PointUndistorter {
+ public:
+  void Init(const CameraCalibration& calibration, cv::Size size);
+
+  cv::Size GetSize() const { return m_size; }
+
+  void Apply(const std::vector<cv::Point>& in, std::vector<cv::Point>& out);
+
+ private:
+  cv::Size m_size;
+  cv::Matx33d m_cameraMatrix;
+  cv::Mat m_distortion;
+  std::vector<cv::Point2f> m_in;
+  std::vector<cv::Point2f> m_out;
+};
+
+#endif  // MULTICAMERASERVER_UNDISTORTMAP_H_
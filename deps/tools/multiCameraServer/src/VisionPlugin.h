@@ -0,0 +1,89 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef MULTICAMERASERVER_VISIONPLUGIN_H_
+#define MULTICAMERASERVER_VISIONPLUGIN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+   C ABI for vision pipeline plugins loaded by multiCameraServer.
+
+   A plugin is a shared object exporting FRCVISION_PLUGIN_ENTRY, which
+   returns a pointer to a static frcvision_plugin.  Only plain C types cross
+   the boundary, so a plugin can be built with any compiler and any OpenCV
+   version (or none).
+
+   multiCameraServer watches the plugin file; when a new build replaces it,
+   the new plugin is loaded and created alongside the running one, swapped
+   in between two frames, and the old one is destroyed and unloaded.  Camera
+   capture and streams are not interrupted.
+
+   process and destroy of an instance are always called from the same
+   thread (an instance replaced before it processed any frame is destroyed
+   on the create thread).  create is called from a different thread, while
+   the previous build may still be processing, so plugins must not share
+   mutable global state between instances.  The host functions may only be
+   called from within create or process.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRCVISION_PLUGIN_ABI_VERSION 1
+#define FRCVISION_PLUGIN_ENTRY frcvision_plugin_get
+
+enum frcvision_pixel_format {
+  FRCVISION_PIXEL_BGR = 0, /* 3 bytes per pixel, B, G, R */
+  FRCVISION_PIXEL_GRAY = 1 /* 1 byte per pixel */
+};
+
+typedef struct frcvision_image {
+  uint8_t* data; /* may be modified in place, e.g. to annotate the stream */
+  int32_t width;
+  int32_t height;
+  size_t stride; /* bytes per row */
+  int32_t format; /* frcvision_pixel_format */
+} frcvision_image;
+
+typedef struct frcvision_host {
+  void* ctx; /* pass as the first argument of every host function */
+
+  /* publishes a value to NetworkTables under /vision/<pipeline name>/;
+     the value timestamp is the capture time of the current frame */
+  void (*publish_double)(void* ctx, const char* key, double value);
+  void (*publish_double_array)(void* ctx, const char* key,
+                               const double* values, size_t count);
+  void (*publish_string)(void* ctx, const char* key, const char* value);
+
+  /* prints a line to the console, prefixed with the pipeline name */
+  void (*log)(void* ctx, const char* message);
+} frcvision_host;
+
+typedef struct frcvision_plugin {
+  uint32_t abi_version; /* FRCVISION_PLUGIN_ABI_VERSION */
+  const char* name;
+
+  /* config is the pipeline's "config" object from frc.json as a JSON
+     string ("{}" if none); returns the instance, or NULL on failure */
+  void* (*create)(const frcvision_host* host, const char* config);
+
+  /* capture_time is in microseconds, NetworkTables local time base */
+  void (*process)(void* instance, frcvision_image* image,
+                  int64_t capture_time);
+
+  void (*destroy)(void* instance);
+} frcvision_plugin;
+
+typedef const frcvision_plugin* (*frcvision_plugin_entry)(void);
+
+const frcvision_plugin* FRCVISION_PLUGIN_ENTRY(void);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // MULTICAMERASERVER_VISIONPLUGIN_H_
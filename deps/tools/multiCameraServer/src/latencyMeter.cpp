@@ -0,0 +1,280 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+#include <opencv2/imgcodecs.hpp>
+
+#include "TimestampPattern.h"
+
+/*
+   Glass-to-glass latency meter for multiCameraServer test patterns.
+
+   Usage: latencyMeter [-n frames] [-w warmup] <label>=<url> ...
+
+   Each <url> is an MJPEG stream of a "test patterns" source, optionally with
+   MjpegServer query parameters, e.g.:
+
+     q30-160=http://localhost:1181/stream.mjpg?compression=30&resolution=160x120
+     q80-320=http://localhost:1181/stream.mjpg?compression=80&resolution=320x240
+
+   The meter must run on the same host as multiCameraServer (e.g. over
+   loopback), as it compares the stamped CLOCK_MONOTONIC time against its own
+   clock at the moment the last byte of each frame is received.  A latency
+   histogram is printed for each stream configuration.
+ */
+
+namespace {
+
+constexpr int kBucketMs = 1;
+constexpr int kNumBuckets = 250;
+
+struct Histogram {
+  std::string label;
+  std::vector<uint64_t> samples;  // microseconds
+  int undecodable = 0;
+};
+
+class StreamReader {
+ public:
+  ~StreamReader() {
+    if (m_fd != -1) close(m_fd);
+  }
+
+  bool Open(std::string_view url);
+  bool ReadFrame(std::vector<uint8_t>* jpeg);
+
+ private:
+  bool Fill();
+  bool ReadLine(std::string* line);
+  bool ReadBytes(uint8_t* dest, size_t len);
+
+  int m_fd = -1;
+  char m_buf[16384];
+  size_t m_pos = 0;
+  size_t m_len = 0;
+};
+
+bool StreamReader::Open(std::string_view url) {
+  if (url.substr(0, 7) != "http://") {
+    fmt::print(stderr, "only http:// URLs are supported: {}\n", url);
+    return false;
+  }
+  url.remove_prefix(7);
+  auto slash = url.find('/');
+  std::string_view hostport = url.substr(0, slash);
+  std::string path{slash == std::string_view::npos ? "/" : url.substr(slash)};
+  std::string host{hostport.substr(0, hostport.find(':'))};
+  std::string port = "80";
+  if (auto colon = hostport.find(':'); colon != std::string_view::npos)
+    port = hostport.substr(colon + 1);
+
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* res;
+  if (int err = getaddrinfo(host.c_str(), port.c_str(), &hints, &res)) {
+    fmt::print(stderr, "could not resolve '{}': {}\n", host,
+               gai_strerror(err));
+    return false;
+  }
+  for (auto ai = res; ai; ai = ai->ai_next) {
+    m_fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (m_fd == -1) continue;
+    if (connect(m_fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+    close(m_fd);
+    m_fd = -1;
+  }
+  freeaddrinfo(res);
+  if (m_fd == -1) {
+    fmt::print(stderr, "could not connect to {}:{}\n", host, port);
+    return false;
+  }
+
+  auto req = fmt::format("GET {} HTTP/1.0\r\nHost: {}\r\n\r\n", path, host);
+  if (write(m_fd, req.data(), req.size()) != static_cast<ssize_t>(req.size()))
+    return false;
+
+  // skip response headers
+  std::string line;
+  if (!ReadLine(&line) || line.find(" 200 ") == std::string::npos) {
+    fmt::print(stderr, "bad HTTP response: '{}'\n", line);
+    return false;
+  }
+  while (ReadLine(&line) && !line.empty()) {
+  }
+  return true;
+}
+
+bool StreamReader::Fill() {
+  if (m_pos < m_len) return true;
+  ssize_t n = read(m_fd, m_buf, sizeof(m_buf));
+  if (n <= 0) return false;
+  m_pos = 0;
+  m_len = n;
+  return true;
+}
+
+bool StreamReader::ReadLine(std::string* line) {
+  line->clear();
+  for (;;) {
+    if (!Fill()) return false;
+    char c = m_buf[m_pos++];
+    if (c == '\n') break;
+    if (c != '\r') line->push_back(c);
+  }
+  return true;
+}
+
+bool StreamReader::ReadBytes(uint8_t* dest, size_t len) {
+  while (len > 0) {
+    if (!Fill()) return false;
+    size_t n = std::min(len, m_len - m_pos);
+    std::memcpy(dest, m_buf + m_pos, n);
+    m_pos += n;
+    dest += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool StreamReader::ReadFrame(std::vector<uint8_t>* jpeg) {
+  // part headers; skip boundary and blank lines until Content-Length
+  std::string line;
+  size_t length = 0;
+  for (;;) {
+    if (!ReadLine(&line)) return false;
+    if (line.empty()) {
+      if (length != 0) break;
+      continue;
+    }
+    auto colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    std::string name = line.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == "content-length")
+      length = std::strtoul(line.c_str() + colon + 1, nullptr, 10);
+  }
+  jpeg->resize(length);
+  return ReadBytes(jpeg->data(), length);
+}
+
+bool Measure(std::string_view url, int frames, int warmup, Histogram* hist) {
+  StreamReader reader;
+  if (!reader.Open(url)) return false;
+
+  std::vector<uint8_t> jpeg;
+  for (int i = 0; i < warmup + frames; ++i) {
+    if (!reader.ReadFrame(&jpeg)) {
+      fmt::print(stderr, "{}: stream ended\n", hist->label);
+      return false;
+    }
+    uint64_t now = tspattern::MonotonicMicros();
+    if (i < warmup) continue;
+
+    cv::Mat image = cv::imdecode(jpeg, cv::IMREAD_GRAYSCALE);
+    uint64_t stamp;
+    if (image.empty() ||
+        !tspattern::Decode(image.data, image.cols, image.rows, image.step,
+                           &stamp) ||
+        stamp > now) {
+      ++hist->undecodable;
+      continue;
+    }
+    hist->samples.push_back(now - stamp);
+  }
+  return true;
+}
+
+void Report(Histogram& hist) {
+  fmt::print("=== {} ===\n", hist.label);
+  fmt::print("frames: {}  undecodable: {}\n", hist.samples.size(),
+             hist.undecodable);
+  if (hist.samples.empty()) return;
+
+  std::sort(hist.samples.begin(), hist.samples.end());
+  auto pct = [&](int p) {
+    return hist.samples[(hist.samples.size() - 1) * p / 100] / 1000.0;
+  };
+  uint64_t sum = 0;
+  for (auto s : hist.samples) sum += s;
+  fmt::print(
+      "latency ms: min {:.1f}  p50 {:.1f}  p90 {:.1f}  p99 {:.1f}  "
+      "max {:.1f}  mean {:.1f}\n",
+      hist.samples.front() / 1000.0, pct(50), pct(90), pct(99),
+      hist.samples.back() / 1000.0, sum / 1000.0 / hist.samples.size());
+
+  std::vector<int> buckets(kNumBuckets + 1);
+  for (auto s : hist.samples)
+    ++buckets[std::min<uint64_t>(s / 1000 / kBucketMs, kNumBuckets)];
+  int maxCount = *std::max_element(buckets.begin(), buckets.end());
+  for (int i = 0; i <= kNumBuckets; ++i) {
+    if (buckets[i] == 0) continue;
+    std::string bar(buckets[i] * 50 / maxCount + 1, '#');
+    if (i == kNumBuckets)
+      fmt::print("  >={:3} ms {:6} {}\n", i * kBucketMs, buckets[i], bar);
+    else
+      fmt::print("  {:5} ms {:6} {}\n", i * kBucketMs, buckets[i], bar);
+  }
+}
+
+// the '=' after the label of a <label>=<url> argument, or npos for a bare
+// URL; a label never contains ':' or '/', so a URL's query string isn't
+// taken for one
+size_t FindLabel(std::string_view arg) {
+  auto eq = arg.find('=');
+  if (eq == std::string_view::npos ||
+      arg.substr(0, eq).find_first_of(":/") != std::string_view::npos)
+    return std::string_view::npos;
+  return eq;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int frames = 300;
+  int warmup = 30;
+  std::vector<std::pair<std::string, std::string>> configs;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg{argv[i]};
+    if (arg == "-n" && i + 1 < argc) {
+      frames = std::atoi(argv[++i]);
+    } else if (arg == "-w" && i + 1 < argc) {
+      warmup = std::atoi(argv[++i]);
+    } else if (auto eq = FindLabel(arg); eq != std::string_view::npos) {
+      configs.emplace_back(arg.substr(0, eq), arg.substr(eq + 1));
+    } else {
+      configs.emplace_back(arg, arg);
+    }
+  }
+  if (configs.empty() || frames <= 0) {
+    fmt::print(stderr,
+               "usage: latencyMeter [-n frames] [-w warmup] <label>=<url> "
+               "...\n");
+    return EXIT_FAILURE;
+  }
+
+  int rv = EXIT_SUCCESS;
+  for (auto&& [label, url] : configs) {
+    Histogram hist;
+    hist.label = label;
+    if (!Measure(url, frames, warmup, &hist)) rv = EXIT_FAILURE;
+    Report(hist);
+  }
+  return rv;
+}
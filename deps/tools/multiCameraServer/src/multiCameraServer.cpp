@@ -3,6 +3,10 @@
 // the WPILib BSD license file in the root directory of this project.
 
 #include <cstdio>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -15,12 +19,26 @@
 #include <wpi/json.h>
 
 #include "cameraserver/CameraServer.h"
+#include "CameraCalibration.h"
+#include "GraphPipeline.h"
+#include "LatencyCamera.h"
+#include "PluginPipeline.h"
+#include "RealTime.h"
+#include "StreamBandwidth.h"
+#include "TimestampPattern.h"
 
 /*
    JSON format:
    {
        "team": <team number>,
        "ntmode": <"client" or "server", "client" if unspecified>
+       "bandwidth budget": <total stream Mbps, unlimited if unspecified>
+       "real time": {                                   // optional
+           "enabled": <true or false, true if unspecified>
+           "priority": <SCHED_FIFO priority for capture, default 50>
+           "cpus": [<cpu index>, ...]                   // optional
+           "prefault": <heap bytes to prefault>         // optional
+       }
        "cameras": [
            {
                "name": <camera name>
@@ -29,6 +47,17 @@
                "width": <video mode width>              // optional
                "height": <video mode height>            // optional
                "fps": <video mode fps>                  // optional
+               "latency mode": <true or false>          // optional
+               "priority": <stream priority, default 0> // optional
+               "calibration": {                         // optional
+                   "width": <resolution calibrated at>
+                   "height": <resolution calibrated at>
+                   "fx": <focal length x, pixels>
+                   "fy": <focal length y, pixels>
+                   "cx": <principal point x, pixels>
+                   "cy": <principal point y, pixels>
+                   "distortion": [k1, k2, p1, p2, k3]   // optional
+               }
                "brightness": <percentage brightness>    // optional
                "white balance": <"auto", "hold", value> // optional
                "exposure": <"auto", "hold", value>      // optional
@@ -52,11 +81,141 @@
            {
                "name": <virtual camera name>
                "key": <network table key used for selection>
+               "priority": <stream priority, default 0> // optional
                // if NT value is a string, it's treated as a name
                // if NT value is a double, it's treated as an integer index
            }
        ]
+       "test patterns": [                               // optional
+           {
+               "name": <virtual camera name>
+               "width": <video mode width>              // optional
+               "height": <video mode height>            // optional
+               "fps": <video mode fps>                  // optional
+               "priority": <stream priority, default 0> // optional
+               "stream": {                              // optional
+                   "properties": [
+                       {
+                           "name": <stream property name>
+                           "value": <stream property value>
+                       }
+                   ]
+               }
+           }
+       ]
+       "pipelines": [                                   // optional
+           {
+               "name": <pipeline name>
+               "camera": <name of camera to process>
+               // exactly one of "plugin" and "stages"; see below
+               "plugin": <path to plugin, e.g. "/home/pi/uploaded.so">
+               "stages": [
+                   {
+                       "name": <stage name>
+                       "type": <"resize", "undistort", "threshold",
+                                "morphology", "contours", "filter",
+                                "publish" or "apriltag">
+                       "input": <"camera" or an earlier stage name,
+                                 default the previous stage> // optional
+                       // resize: "width", "height"
+                       // undistort: "points" (true to undistort
+                       //   contours instead of images), "cache" (remap
+                       //   table directory, default
+                       //   "/home/pi/.cache/multiCameraServer")
+                       // threshold: "space" ("hsv", "ycrcb", "bgr", or
+                       //   "gray" for gray frames), "low", "high"
+                       // morphology: "op" ("erode", "dilate", "open" or
+                       //   "close"), "kernel" (default 3), "iterations"
+                       // contours: "external" (default true)
+                       // filter: "min area", "max area", "min width",
+                       //   "max width", "min height", "max height",
+                       //   "min ratio", "max ratio", "min solidity",
+                       //   "max solidity" (all optional)
+                       // publish: "max count" (default all)
+                       // apriltag: "family" (default "tag36h11"),
+                       //   "decimate" (default 2), "threads" (default
+                       //   one per core), "max hamming" (default 0),
+                       //   "min margin", "tag size" (meters, default
+                       //   0.1651), "field" (layout JSON file, default
+                       //   the current season's)
+                   }
+               ]
+               "output": <stage shown on the stream, default last> // opt.
+               "gray": <true to process grayscale frames>  // optional
+               "config": <object passed to the plugin>     // optional
+               "priority": <stream priority, default 0> // optional
+               "stream": {                              // optional
+                   "properties": [
+                       {
+                           "name": <stream property name>
+                           "value": <stream property value>
+                       }
+                   ]
+               }
+           }
+       ]
    }
+
+   The bytes sent by every stream are measured each second.  If the total
+   exceeds the bandwidth budget (in Mbps), the lowest priority streams are
+   throttled first by lowering JPEG quality and then fps (see
+   StreamBandwidth.h).  Usage is published to /multiCameraServer/bandwidth.
+
+   Test patterns are synthetic sources that stamp the current
+   CLOCK_MONOTONIC time into every frame (see TimestampPattern.h).  Run
+   latencyMeter on the same host against their streams to measure
+   glass-to-glass latency.
+
+   Real time mode locks and prefaults memory, runs camera capture threads at
+   SCHED_FIFO pinned to "cpus", and publishes the worst scheduling jitter
+   observed on those CPUs to /multiCameraServer/realtime.  Stream encoder
+   threads stay at normal priority.  "cpus" must be online CPUs.  cscore
+   doesn't name a USB camera's capture thread, so it is only promoted when
+   it is the one unnamed thread the camera started; a latency mode camera's
+   is always found (see RealTime.h).
+
+   Latency mode captures the camera directly with the minimum number of
+   driver buffers, always delivers the newest frame and discards stale ones
+   (see LatencyCamera.h).  Frames are decoded for every consumer, so it costs
+   more CPU than the default MJPEG passthrough.  Pipelines on the camera see
+   the driver capture time as their frame time.
+
+   Each "pipelines" entry takes exactly one of three forms, as the key is
+   shared with the C++ example program, which can read the same file:
+     - "plugin": a vision plugin, run by this server (below)
+     - "stages": a graph of built-in stages, run by this server (below)
+     - "type": a pipeline compiled into the C++ example program (see
+       main.cpp of cpp-multiCameraServer), which this server rejects
+   An entry with both "plugin" and "stages" is an error.
+
+   Pipelines run vision plugins (shared objects with the C ABI in
+   VisionPlugin.h) on a camera's frames.  Replacing the plugin file loads
+   the new build and swaps it in between frames without restarting capture
+   or streams (see PluginPipeline.h).  If "stream" is given, the processed
+   frames are also streamed under the pipeline name.
+
+   Pipelines with "stages" instead of a plugin are built from the stages
+   above, each running on its own thread so consecutive frames are processed
+   in parallel (see GraphPipeline.h).  Publish stages write their contours
+   to /vision/<pipeline>/<stage>/.
+
+   Apriltag stages detect tags with a multithreaded detector that is kept
+   across frames, and publish their ids, centers and ambiguities to
+   /vision/<pipeline>/<stage>/, timestamped with the capture time.  If the
+   camera has a "calibration", each tag's pose relative to the camera is
+   published to "poses", and the camera's field pose, solved from all the
+   layout's tags in the frame at once, to "cameraPose" (x, y, z in meters
+   and a w, x, y, z quaternion per pose; see TagDetector.h).  Process gray
+   frames ("gray": true) to skip the color conversion.
+
+   Undistort stages remove the lens distortion given in the camera's
+   "calibration", with remap tables built once per resolution and saved in
+   the cache directory, so later starts load them (see UndistortMap.h).
+   The filesystem must be writable the first time for them to be saved.
+   With "points": true, the stage undistorts contours instead, which is
+   much cheaper when only target positions matter.  Apriltag stages take
+   their image as distortion free, so put an undistort stage before them
+   for a lens with noticeable distortion.
  */
 
 #ifdef FRC_JSON
@@ -69,22 +228,54 @@ namespace {
 
 unsigned int team;
 bool server = false;
+double bandwidthBudget = 0;
+RealTimeConfig realTimeConfig;
 
 struct CameraConfig {
   std::string name;
   std::string path;
   wpi::json config;
   wpi::json streamConfig;
+  bool latencyMode = false;
+  int priority = 0;
+  std::optional<CameraCalibration> calibration;
 };
 
 struct SwitchedCameraConfig {
   std::string name;
   std::string key;
+  int priority = 0;
+};
+
+struct TestPatternConfig {
+  std::string name;
+  int width = 320;
+  int height = 240;
+  int fps = 30;
+  int priority = 0;
+  wpi::json streamConfig;
+};
+
+struct PipelineConfig {
+  std::string name;
+  std::string camera;
+  std::string plugin;
+  wpi::json stages;
+  std::string output;
+  bool gray = false;
+  wpi::json config = wpi::json::object();
+  int priority = 0;
+  wpi::json streamConfig;
 };
 
 std::vector<CameraConfig> cameraConfigs;
 std::vector<SwitchedCameraConfig> switchedCameraConfigs;
+std::vector<TestPatternConfig> testPatternConfigs;
+std::vector<PipelineConfig> pipelineConfigs;
 std::vector<cs::VideoSource> cameras;
+std::vector<std::unique_ptr<LatencyCamera>> latencyCameras;
+std::vector<std::unique_ptr<PluginPipeline>> pipelines;
+std::vector<std::unique_ptr<GraphPipeline>> graphPipelines;
 
 void ParseErrorV(fmt::string_view format, fmt::format_args args) {
   fmt::print(stderr, "config error in '{}': ", configFile);
@@ -116,6 +307,50 @@ bool ReadCameraConfig(const wpi::json& config) {
     return false;
   }
 
+  // latency mode (optional)
+  try {
+    c.latencyMode = config.value("latency mode", false);
+  } catch (const wpi::json::exception& e) {
+    ParseError("camera '{}': could not read latency mode: {}", c.name,
+               e.what());
+    return false;
+  }
+
+  // stream priority (optional)
+  try {
+    c.priority = config.value("priority", 0);
+  } catch (const wpi::json::exception& e) {
+    ParseError("camera '{}': could not read priority: {}", c.name, e.what());
+    return false;
+  }
+
+  // calibration (optional)
+  if (config.count("calibration") != 0) {
+    CameraCalibration k;
+    try {
+      const auto& calibration = config.at("calibration");
+      k.width = calibration.at("width").get<int>();
+      k.height = calibration.at("height").get<int>();
+      k.fx = calibration.at("fx").get<double>();
+      k.fy = calibration.at("fy").get<double>();
+      k.cx = calibration.at("cx").get<double>();
+      k.cy = calibration.at("cy").get<double>();
+      if (calibration.count("distortion") != 0) {
+        k.distortion =
+            calibration.at("distortion").get<std::vector<double>>();
+      }
+    } catch (const wpi::json::exception& e) {
+      ParseError("camera '{}': could not read calibration: {}", c.name,
+                 e.what());
+      return false;
+    }
+    if (!k.IsValid()) {
+      ParseError("camera '{}': invalid calibration", c.name);
+      return false;
+    }
+    c.calibration = k;
+  }
+
   // stream properties
   if (config.count("stream") != 0) c.streamConfig = config.at("stream");
 
@@ -145,10 +380,149 @@ bool ReadSwitchedCameraConfig(const wpi::json& config) {
     return false;
   }
 
+  // stream priority (optional)
+  try {
+    c.priority = config.value("priority", 0);
+  } catch (const wpi::json::exception& e) {
+    ParseError("switched camera '{}': could not read priority: {}", c.name,
+               e.what());
+    return false;
+  }
+
   switchedCameraConfigs.emplace_back(std::move(c));
   return true;
 }
 
+bool ReadTestPatternConfig(const wpi::json& config) {
+  TestPatternConfig c;
+
+  // name
+  try {
+    c.name = config.at("name").get<std::string>();
+  } catch (const wpi::json::exception& e) {
+    ParseError("could not read test pattern name: {}", e.what());
+    return false;
+  }
+
+  // video mode (optional)
+  try {
+    if (config.count("width") != 0) c.width = config.at("width").get<int>();
+    if (config.count("height") != 0) c.height = config.at("height").get<int>();
+    if (config.count("fps") != 0) c.fps = config.at("fps").get<int>();
+  } catch (const wpi::json::exception& e) {
+    ParseError("test pattern '{}': could not read video mode: {}", c.name,
+               e.what());
+    return false;
+  }
+
+  // stream priority (optional)
+  try {
+    c.priority = config.value("priority", 0);
+  } catch (const wpi::json::exception& e) {
+    ParseError("test pattern '{}': could not read priority: {}", c.name,
+               e.what());
+    return false;
+  }
+  if (c.width <= 0 || c.height <= 0 || c.fps <= 0) {
+    ParseError("test pattern '{}': invalid video mode {}x{}@{}", c.name,
+               c.width, c.height, c.fps);
+    return false;
+  }
+
+  // stream properties
+  if (config.count("stream") != 0) c.streamConfig = config.at("stream");
+
+  testPatternConfigs.emplace_back(std::move(c));
+  return true;
+}
+
+bool ReadPipelineConfig(const wpi::json& config) {
+  PipelineConfig c;
+
+  // name
+  try {
+    c.name = config.at("name").get<std::string>();
+  } catch (const wpi::json::exception& e) {
+    ParseError("could not read pipeline name: {}", e.what());
+    return false;
+  }
+
+  try {
+    c.camera = config.at("camera").get<std::string>();
+    bool hasStages = config.count("stages") != 0;
+    bool hasPlugin = config.count("plugin") != 0;
+    if (hasStages && hasPlugin) {
+      ParseError("pipeline '{}': has both \"plugin\" and \"stages\"",
+                 c.name);
+      return false;
+    }
+    if (!hasStages && !hasPlugin) {
+      if (config.count("type") != 0) {
+        ParseError(
+            "pipeline '{}': \"type\" pipelines are run by the C++ example "
+            "program, not multiCameraServer",
+            c.name);
+      } else {
+        ParseError("pipeline '{}': needs \"plugin\" or \"stages\"",
+                   c.name);
+      }
+      return false;
+    }
+    if (hasStages) {
+      c.stages = config.at("stages");
+      if (!c.stages.is_array()) {
+        ParseError("pipeline '{}': stages must be an array", c.name);
+        return false;
+      }
+      c.output = config.value("output", "");
+    } else {
+      c.plugin = config.at("plugin").get<std::string>();
+    }
+    c.gray = config.value("gray", false);
+    if (config.count("config") != 0) c.config = config.at("config");
+    c.priority = config.value("priority", 0);
+  } catch (const wpi::json::exception& e) {
+    ParseError("pipeline '{}': {}", c.name, e.what());
+    return false;
+  }
+
+  // output stream properties (optional)
+  if (config.count("stream") != 0) c.streamConfig = config.at("stream");
+
+  pipelineConfigs.emplace_back(std::move(c));
+  return true;
+}
+
+bool ReadRealTimeConfig(const wpi::json& config) {
+  RealTimeConfig c;
+  c.enabled = true;
+  try {
+    if (config.count("enabled") != 0)
+      c.enabled = config.at("enabled").get<bool>();
+    if (config.count("priority") != 0)
+      c.priority = config.at("priority").get<int>();
+    if (config.count("cpus") != 0)
+      c.cpus = config.at("cpus").get<std::vector<int>>();
+    if (config.count("prefault") != 0)
+      c.prefaultBytes = config.at("prefault").get<size_t>();
+  } catch (const wpi::json::exception& e) {
+    ParseError("could not read real time: {}", e.what());
+    return false;
+  }
+  if (c.priority < 1 || c.priority > 99) {
+    ParseError("real time priority {} out of range 1-99", c.priority);
+    return false;
+  }
+  for (int cpu : c.cpus) {
+    if (!RealTime::IsUsableCpu(cpu)) {
+      ParseError("real time cpu {} is not an online CPU", cpu);
+      return false;
+    }
+  }
+  realTimeConfig = std::move(c);
+  return true;
+}
+
 bool ReadConfig() {
   // open config file
   std::error_code ec;
@@ -198,6 +572,21 @@ bool ReadConfig() {
     }
   }
 
+  // bandwidth budget (optional)
+  if (j.count("bandwidth budget") != 0) {
+    try {
+      bandwidthBudget = j.at("bandwidth budget").get<double>();
+    } catch (const wpi::json::exception& e) {
+      ParseError("could not read bandwidth budget: {}", e.what());
+      return false;
+    }
+  }
+
+  // real time (optional)
+  if (j.count("real time") != 0) {
+    if (!ReadRealTimeConfig(j.at("real time"))) return false;
+  }
+
   // cameras
   try {
     for (auto&& camera : j.at("cameras")) {
@@ -220,24 +609,81 @@ bool ReadConfig() {
     }
   }
 
+  // test patterns (optional)
+  if (j.count("test patterns") != 0) {
+    try {
+      for (auto&& pattern : j.at("test patterns")) {
+        if (!ReadTestPatternConfig(pattern)) return false;
+      }
+    } catch (const wpi::json::exception& e) {
+      ParseError("could not read test patterns: {}", e.what());
+      return false;
+    }
+  }
+
+  // pipelines (optional)
+  if (j.count("pipelines") != 0) {
+    try {
+      for (auto&& pipeline : j.at("pipelines")) {
+        if (!ReadPipelineConfig(pipeline)) return false;
+      }
+    } catch (const wpi::json::exception& e) {
+      ParseError("could not read pipelines: {}", e.what());
+      return false;
+    }
+  }
+
   return true;
 }
 
-cs::UsbCamera StartCamera(const CameraConfig& config) {
-  fmt::print("Starting camera '{}' on {}\n", config.name, config.path);
-  cs::UsbCamera camera{config.name, config.path};
-  auto server = frc::CameraServer::StartAutomaticCapture(camera);
+// estimate of frame buffer memory for real time prefaulting
+size_t EstimateFrameMemory() {
+  // cscore keeps a small pool of decoded (BGR) images per source
+  constexpr size_t kFramesPerSource = 8;
+  size_t bytes = 0;
+  for (const auto& config : cameraConfigs) {
+    size_t width = config.config.value("width", 640);
+    size_t height = config.config.value("height", 480);
+    bytes += width * height * 3 * kFramesPerSource;
+  }
+  for (const auto& config : testPatternConfigs)
+    bytes += config.width * config.height * kFramesPerSource;
+  return bytes;
+}
 
-  camera.SetConfigJson(config.config);
-  camera.SetConnectionStrategy(cs::VideoSource::kConnectionKeepOpen);
+cs::VideoSource StartCamera(const CameraConfig& config, RealTime& realTime,
+                            StreamBandwidth& bandwidth) {
+  fmt::print("Starting camera '{}' on {}{}\n", config.name, config.path,
+             config.latencyMode ? " in latency mode" : "");
+  cs::VideoSource camera;
+  if (config.latencyMode) {
+    // camera settings are applied by LatencyCamera when the device opens
+    auto latencyCamera = std::make_unique<LatencyCamera>(
+        config.name, config.path, config.config);
+    realTime.PromoteNamedThreads(latencyCamera->GetThreadName(),
+                                 config.name);
+    camera = latencyCamera->GetSource();
+    latencyCameras.emplace_back(std::move(latencyCamera));
+  } else {
+    // the capture thread is started when the camera is created
+    auto threads = RealTime::GetThreads();
+    cs::UsbCamera usbCamera{config.name, config.path};
+    realTime.PromoteCaptureThread(threads, config.name);
+    usbCamera.SetConfigJson(config.config);
+    usbCamera.SetConnectionStrategy(cs::VideoSource::kConnectionKeepOpen);
+    camera = usbCamera;
+  }
+  auto server = frc::CameraServer::StartAutomaticCapture(camera);
 
   if (config.streamConfig.is_object())
     server.SetConfigJson(config.streamConfig);
+  bandwidth.AddStream(config.name, server, config.priority);
 
   return camera;
 }
 
-cs::MjpegServer StartSwitchedCamera(const SwitchedCameraConfig& config) {
+cs::MjpegServer StartSwitchedCamera(const SwitchedCameraConfig& config,
+                                    StreamBandwidth& bandwidth) {
   fmt::print("Starting switched camera '{}' on {}\n", config.name, config.key);
   auto server = frc::CameraServer::AddSwitchedCamera(config.name);
 
@@ -264,9 +710,97 @@ cs::MjpegServer StartSwitchedCamera(const SwitchedCameraConfig& config) {
         }
       }
     });
+  bandwidth.AddStream(config.name, server, config.priority);
 
   return server;
 }
+
+void StartTestPattern(const TestPatternConfig& config, RealTime& realTime,
+                      StreamBandwidth& bandwidth) {
+  fmt::print("Starting test pattern '{}' at {}x{}@{}\n", config.name,
+             config.width, config.height, config.fps);
+  cs::CvSource source{config.name, cs::VideoMode::kGray, config.width,
+                      config.height, config.fps};
+  auto server = frc::CameraServer::StartAutomaticCapture(source);
+
+  if (config.streamConfig.is_object())
+    server.SetConfigJson(config.streamConfig);
+  bandwidth.AddStream(config.name, server, config.priority);
+
+  auto period = std::chrono::microseconds(1000000 / config.fps);
+  std::thread([source, period, &realTime, width = config.width,
+               height = config.height]() mutable {
+    realTime.PromoteThread(0);
+    cv::Mat frame{height, width, CV_8UC1};
+    auto next = std::chrono::steady_clock::now();
+    for (;;) {
+      next += period;
+      std::this_thread::sleep_until(next);
+      // stamp as late as possible so only delivery is measured
+      tspattern::Draw(frame.data, frame.cols, frame.rows, frame.step,
+                      tspattern::MonotonicMicros());
+      source.PutFrame(frame);
+    }
+  }).detach();
+}
+
+// the frame time to capture time mapping of a latency mode camera; empty
+// for the others, whose frames are stamped when cscore receives them
+std::function<uint64_t(uint64_t)> GetCaptureTimes(
+    const cs::VideoSource& camera) {
+  for (auto&& latencyCamera : latencyCameras) {
+    if (latencyCamera->GetSource() == camera) {
+      return [latencyCamera = latencyCamera.get()](uint64_t frameTime) {
+        return latencyCamera->GetCaptureTime(frameTime);
+      };
+    }
+  }
+  return {};
+}
+
+void StartPipeline(const PipelineConfig& config, nt::NetworkTableInstance inst,
+                   StreamBandwidth& bandwidth) {
+  size_t i = 0;
+  while (i < cameraConfigs.size() && cameraConfigs[i].name != config.camera)
+    ++i;
+  if (i == cameraConfigs.size()) {
+    fmt::print(stderr, "pipeline '{}': no camera named '{}'\n", config.name,
+               config.camera);
+    return;
+  }
+
+  if (config.stages.is_array()) {
+    fmt::print("Starting pipeline '{}' on camera '{}' with {} stages\n",
+               config.name, config.camera, config.stages.size());
+    auto pipeline = std::make_unique<GraphPipeline>(
+        config.name, config.stages, config.gray, config.output,
+        cameraConfigs[i].calibration);
+    if (config.streamConfig.is_object()) {
+      auto server = pipeline->AddOutputStream();
+      server.SetConfigJson(config.streamConfig);
+      bandwidth.AddStream(config.name, server, config.priority);
+    }
+    pipeline->SetCaptureTimes(GetCaptureTimes(cameras[i]));
+    // kept even if invalid, so its error stays published
+    pipeline->Start(cameras[i], inst);
+    graphPipelines.emplace_back(std::move(pipeline));
+    return;
+  }
+
+  fmt::print("Starting pipeline '{}' on camera '{}' with {}\n", config.name,
+             config.camera, config.plugin);
+  auto pipeline = std::make_unique<PluginPipeline>(
+      config.name, config.plugin, config.config.dump(), config.gray);
+  if (config.streamConfig.is_object()) {
+    auto server = pipeline->AddOutputStream();
+    server.SetConfigJson(config.streamConfig);
+    bandwidth.AddStream(config.name, server, config.priority);
+  }
+  pipeline->SetCaptureTimes(GetCaptureTimes(cameras[i]));
+  pipeline->Start(cameras[i], inst);
+  pipelines.emplace_back(std::move(pipeline));
+}
+
 }  // namespace
 
 int main(int argc, char* argv[]) {
@@ -275,6 +809,14 @@ int main(int argc, char* argv[]) {
   // read configuration
   if (!ReadConfig()) return EXIT_FAILURE;
 
+  // lock memory before anything allocates frame buffers
+  RealTime realTime{realTimeConfig};
+  if (realTime.IsEnabled() && !realTime.LockMemory(EstimateFrameMemory())) {
+    fmt::print(stderr,
+               "real-time: continuing without locked memory; capture may "
+               "page fault\n");
+  }
+
   // start NetworkTables
   auto ntinst = nt::NetworkTableInstance::GetDefault();
   if (server) {
@@ -290,11 +832,27 @@ int main(int argc, char* argv[]) {
   // start cameras
   // work around wpilibsuite/allwpilib#5055
   frc::CameraServer::RemoveCamera("unused");
+  StreamBandwidth bandwidth{bandwidthBudget};
   for (const auto& config : cameraConfigs)
-    cameras.emplace_back(StartCamera(config));
+    cameras.emplace_back(StartCamera(config, realTime, bandwidth));
 
   // start switched cameras
-  for (const auto& config : switchedCameraConfigs) StartSwitchedCamera(config);
+  for (const auto& config : switchedCameraConfigs)
+    StartSwitchedCamera(config, bandwidth);
+
+  // start test patterns
+  for (const auto& config : testPatternConfigs)
+    StartTestPattern(config, realTime, bandwidth);
+
+  // start vision pipeline plugins
+  for (const auto& config : pipelineConfigs)
+    StartPipeline(config, ntinst, bandwidth);
+
+  // account stream bandwidth and enforce the budget
+  bandwidth.Start(ntinst);
+
+  // monitor scheduling jitter of the real time CPUs
+  realTime.StartJitterMonitor(ntinst);
 
   // loop forever
   for (;;) std::this_thread::sleep_for(std::chrono::seconds(10));
@@ -0,0 +1,93 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "StreamBandwidth.h"
+
+/*
+   Checks of the StreamBandwidth throttle levels; run with "make check".
+ */
+
+namespace {
+
+int failures = 0;
+
+void Check(std::string_view what, bool ok) {
+  fmt::print("{:<60} {}\n", what, ok ? "ok" : "FAILED");
+  if (!ok) ++failures;
+}
+
+// steps up from level 0 as far as it goes, checking every level on the
+// way; returns the levels visited
+std::vector<int> StepUp(int baseQuality) {
+  std::vector<int> levels{0};
+  int quality = GetThrottleLevel(baseQuality, 0).quality;
+  int divisor = 1;
+  for (int level = 0;;) {
+    level = StepThrottleLevel(baseQuality, level, 1);
+    if (level < 0) break;
+    auto l = GetThrottleLevel(baseQuality, level);
+    Check(fmt::format("quality {}: level {} doesn't raise the quality",
+                      baseQuality, level),
+          baseQuality < 0 || l.quality <= baseQuality);
+    Check(fmt::format("quality {}: level {} lowers quality or fps",
+                      baseQuality, level),
+          (quality < 0 || l.quality <= quality) &&
+              l.fpsDivisor >= divisor &&
+              (l.quality != quality || l.fpsDivisor != divisor));
+    quality = l.quality;
+    divisor = l.fpsDivisor;
+    levels.push_back(level);
+  }
+  return levels;
+}
+
+void CheckStream(int baseQuality) {
+  auto up = StepUp(baseQuality);
+  Check(fmt::format("quality {}: throttles down to the last level",
+                    baseQuality),
+        up.back() == kNumThrottleLevels - 1);
+
+  // stepping down retraces the same levels back to the stream config
+  std::vector<int> down{up.back()};
+  for (int level = up.back(); level > 0;) {
+    level = StepThrottleLevel(baseQuality, level, -1);
+    if (level < 0) break;
+    down.insert(down.begin(), level);
+  }
+  Check(fmt::format("quality {}: restores through the same levels",
+                    baseQuality),
+        down == up);
+}
+
+}  // namespace
+
+int main() {
+  // the server's default quality, a high one, and ones at or below the
+  // throttle qualities
+  for (int quality : {-1, 80, 50, 30, 20, 10}) CheckStream(quality);
+
+  // a stream configured at quality 20 has nothing to gain from the
+  // quality-only levels, so its first step lowers the fps
+  int first = StepThrottleLevel(20, 0, 1);
+  auto l = GetThrottleLevel(20, first);
+  Check("quality 20: first step lowers fps at quality 20",
+        l.quality == 20 && l.fpsDivisor > 1);
+  Check("quality 20: restores straight to level 0",
+        StepThrottleLevel(20, first, -1) == 0);
+
+  Check("quality 30: level 1 keeps quality 30",
+        GetThrottleLevel(30, 1).quality == 30);
+
+  if (failures != 0) {
+    fmt::print("{} check(s) failed\n", failures);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
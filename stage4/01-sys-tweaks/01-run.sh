@@ -41,6 +41,8 @@ popd
 pushd multiCameraServer
 make CXX=aarch64-linux-gnu-g++
 install -m 755 multiCameraServer "${ROOTFS_DIR}/usr/local/frc/bin/"
+install -m 755 latencyMeter "${ROOTFS_DIR}/usr/local/frc/bin/"
+install -m 644 src/VisionPlugin.h "${ROOTFS_DIR}/usr/local/frc/include/"
 
 popd
 